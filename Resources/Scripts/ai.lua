@@ -12,6 +12,18 @@ All StateMachines must have a "default" state.  This is their initial state.
 States transition by returning a string of the new State's name.
 States that do not return new state names will stay in the same state.
 
+A StateMachine may list states that don't need to think every frame:
+StateMachine.thinkIntervals = { State = 4, ... }
+Between thoughts the ship keeps accelerating and turning as it last did.
+
+The steering states of Trader, Patrol, Bully and Hunter also have C++
+versions in Source/AI/ai_behaviour.cpp, which run instead of these functions.
+Change both together, or set options/simulation/native-ai to 0.
+
+When options/simulation/ai-shards is set, the other states run in copies of
+this script on the worker threads, with only part of the Lua API and only the
+numbers, strings and booleans in AIData.  See Source/AI/ai_shards.cpp.
+
 --]]
 
 AIData = {}
@@ -273,6 +285,8 @@ Trader = {
 	end,
 }
 
+Trader.thinkIntervals = { Travelling = 4 }
+
 Patrol = {
 	default = function(id,x,y,angle,speed,vector)
 		local cur_ship = Epiar.getSprite(id)
@@ -348,6 +362,8 @@ Patrol = {
 }
 
 
+Patrol.thinkIntervals = { Travelling = 4, Orbiting = 4 }
+
 Bully = {
 	default = Patrol.default,
 	New_Planet = FindADestination,
@@ -382,6 +398,8 @@ Bully = {
 	end,
 }
 
+Bully.thinkIntervals = { Travelling = 4, Orbiting = 4 }
+
 Pirate = Hunter
 
 Escort = {
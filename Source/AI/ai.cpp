@@ -12,12 +12,29 @@
 #include "Sprites/player.h"
 #include "Sprites/spritemanager.h"
 #include "Utilities/lua.h"
+#include "Graphics/spritebatch.h"
+#include "Utilities/timer.h"
+#include "Utilities/trig.h"
+#include "AI/ai_scheduler.h"
+#include "AI/ai_behaviour.h"
+#include "Utilities/lua_profiler.h"
+
+#define AI_PARITY_EPSILON 0.01 ///< Rotations that differ by less than this many degrees are the same.
 
 /**\class AI
  * \brief AI controls the non-player shipts.
  *
  * */
 
+bool AI::timing = false;
+double AI::decideTime = 0;
+map<string, map<string,AI::StateFunction> > AI::stateFunctions;
+unsigned int AI::stateFunctionsVersion = 0;
+unsigned int AI::stateFunctionsGeneration = 0;
+
+static OptionHandle<int> nativeAI("options/simulation/native-ai");
+static OptionHandle<int> parity("options/development/ai-parity");
+
 /** \brief AI Constructor
  */
 
@@ -25,46 +42,87 @@ AI::AI(string _name, string machine) :
 	name(_name),
 	stateMachine(machine),
 	state("default"),
-	allegiance(NULL)
+	allegiance(NULL),
+	behaviour(NULL),
+	stateFunction(LUA_NOREF),
+	thinkInterval(1),
+	stateVersion(0),
+	nextThink(0),
+	heldAcceleration(false),
+	heldRotation(0),
+	turned(false),
+	requestedRotation(0),
+	shardable(true),
+	decidedInShard(false),
+	lastFireResult(FireSuccess)
 {
 	
 }
 
 /** \brief Run the Lua Statemachine to act and possibly change state.
+ * \details The state function is cached, so unless the state changes this
+ * does not look anything up by name.
+ *
+ * States with a C++ version in the AIBehaviour of the state machine run that
+ * instead of the Lua function, unless "options/simulation/native-ai" is off.
  */
 
 void AI::Decide() {
-	string newstate;
-	// Decide
+	ProfileScope profile("AI::Decide");
 	lua_State *L = Lua::CurrentState();
 	const int initialStackTop = lua_gettop(L);
 
-	// Get the current state machine
-	lua_getglobal(L, stateMachine.c_str() );
-	int machineIndex = lua_gettop(L);
-	if( ! lua_istable(L, machineIndex) )
-	{
-		LogMsg(ERR, "There is no State Machine named '%s'!", stateMachine.c_str() );
-		return; // This ship will just sit idle...
-	}
-
 	// Get the current state
-	lua_pushstring(L, state.c_str() );
-	lua_gettable(L, machineIndex);
-	if( ! lua_isfunction(L,lua_gettop(L)) )
-	{
-		LogMsg(WARN, "The State Machine '%s' has no state '%s'.", stateMachine.c_str(), state.c_str() );
-		lua_getglobal(L, stateMachine.c_str() );
-		lua_pushstring(L, "default" );
-		lua_gettable(L,machineIndex);
-		if( !lua_isfunction(L,lua_gettop(L)) )
-		{
-			LogMsg(ERR, "The State Machine '%s' has no default state.", stateMachine.c_str() );
+	if( stateFunction == LUA_NOREF || stateVersion != Lua::GetScriptVersion() ) {
+		stateVersion = Lua::GetScriptVersion();
+		behaviour = AIBehaviour::Get( stateMachine );
+		stateFunction = GetStateFunction( stateMachine, state, &thinkInterval );
+		if( stateFunction == LUA_NOREF ) {
+			lua_getglobal(L, stateMachine.c_str() );
+			if( ! lua_istable(L, lua_gettop(L)) ) {
+				LogMsg(ERR, "There is no State Machine named '%s'!", stateMachine.c_str() );
+				lua_settop(L, initialStackTop);
+				return; // This ship will just sit idle...
+			}
 			lua_settop(L, initialStackTop);
-			return; // This ship will just sit idle...
+
+			LogMsg(WARN, "The State Machine '%s' has no state '%s'.", stateMachine.c_str(), state.c_str() );
+			stateFunction = GetStateFunction( stateMachine, "default", &thinkInterval );
+			if( stateFunction == LUA_NOREF ) {
+				LogMsg(ERR, "The State Machine '%s' has no default state.", stateMachine.c_str() );
+				return; // This ship will just sit idle...
+			}
 		}
 	}
 
+	if( (behaviour != NULL) && nativeAI.Get() ) {
+		if( parity.Get() ) {
+			if( CompareWithLua() ) {
+				return;
+			}
+		} else {
+			string newState;
+			if( behaviour->Decide( this, state, newState ) ) {
+				if( !newState.empty() ) {
+					ChangeState( newState );
+				}
+				return;
+			}
+		}
+	}
+
+	DecideInLua();
+}
+
+/**\brief Runs the Lua function of the current state (Internal use)
+ * \details The state function must already have been found by Decide.
+ */
+void AI::DecideInLua() {
+	lua_State *L = Lua::CurrentState();
+	const int initialStackTop = lua_gettop(L);
+
+	lua_rawgeti( L, LUA_REGISTRYINDEX, stateFunction );
+
 	// Push Current AI Variables
 	lua_pushinteger( L, this->GetID() );
 	lua_pushnumber( L, this->GetWorldPosition().GetX() );
@@ -85,31 +143,235 @@ void AI::Decide() {
 
 	if( lua_isstring( L, lua_gettop(L) ) )
 	{
-		newstate = (string)luaL_checkstring(L, lua_gettop(L));
+		ChangeState( lua_tostring(L, lua_gettop(L)) );
+		//printf("Changing State:"); Lua::stackDump(L); // DEBUG
+	}
+
+	//printf("Complete:");Lua::stackDump(L); // DEBUG
+	lua_settop(L,initialStackTop);
+}
 
-		// Verify that this new state exists
-		lua_pushstring(L, newstate.c_str() );
-		lua_gettable(L,machineIndex);
-		if( lua_isfunction(L, lua_gettop(L) ))
+/**\brief Moves to the state that the current state returned.
+ */
+void AI::ChangeState( const string& newState ) {
+	// Verify that this new state exists
+	if( state.compare( newState ) != 0 )
+	{
+		int newInterval;
+		int newFunction = GetStateFunction( stateMachine, newState, &newInterval );
+		if( newFunction != LUA_NOREF )
 		{
-			state = newstate;
+			state = newState;
+			stateFunction = newFunction;
+			thinkInterval = newInterval;
 		} else {
-			LogMsg(ERR, "The State Machine '%s' has no state '%s'. Could not transition from '%s'. Resetting StateMachine.", stateMachine.c_str(), newstate.c_str(), state.c_str() );
+			LogMsg(ERR, "The State Machine '%s' has no state '%s'. Could not transition from '%s'. Resetting StateMachine.", stateMachine.c_str(), newState.c_str(), state.c_str() );
 			state = "default"; // Reset the state
+			stateFunction = LUA_NOREF;
 		}
-		//printf("Changing State:"); Lua::stackDump(L); // DEBUG
 	}
+}
 
-	//printf("Complete:");Lua::stackDump(L); // DEBUG
-	lua_settop(L,initialStackTop);
+/**\brief Runs both versions of a state that has a C++ version and logs any difference (Internal use)
+ * \details This is for checking the AIBehaviour against ai.lua, and is turned
+ * on by "options/development/ai-parity".  The C++ version runs first, then
+ * the Ship is turned and moving the way it was before and the Lua version
+ * runs.  The Lua version's decision is the one that is kept.
+ * \return false when the current state has no C++ version.
+ */
+bool AI::CompareWithLua() {
+	const float angle = GetAngle();
+	const Coordinate momentum = GetMomentum();
+	const string previous = state;
+	string newState;
+
+	if( !behaviour->Decide( this, state, newState ) ) {
+		return false;
+	}
+	if( newState.empty() ) {
+		newState = state;
+	}
+	const bool nativeThrust = heldAcceleration;
+	const bool nativeTurned = turned;
+	const float nativeRotation = requestedRotation;
+
+	SetAngle( angle );
+	SetMomentum( momentum );
+	heldAcceleration = false;
+	heldRotation = 0;
+	turned = false;
+	requestedRotation = 0;
+	DecideInLua();
+
+	if( (nativeThrust != heldAcceleration)
+	 || (nativeTurned != turned)
+	 || (fabs( nativeRotation - requestedRotation ) > AI_PARITY_EPSILON)
+	 || (newState != state) )
+	{
+		LogMsg(WARN, "Ship #%d in %s(%s) decided differently in C++ (accelerate %d, rotate %f, to %s) and Lua (accelerate %d, rotate %f, to %s).",
+			GetID(), stateMachine.c_str(), previous.c_str(),
+			nativeThrust, nativeRotation, newState.c_str(),
+			heldAcceleration, requestedRotation, state.c_str() );
+	}
+	return true;
+}
+
+/**\brief Accelerates and keeps accelerating until the AI thinks again.
+ * \sa Ship::Accelerate
+ */
+void AI::Thrust() {
+	this->Ship::Accelerate();
+	heldAcceleration = true;
+}
+
+/**\brief Turns, and finishes the turn even if the AI doesn't think again until later.
+ * \sa Ship::Rotate
+ */
+void AI::Turn( float direction ) {
+	float before = GetAngle();
+	this->Ship::Rotate( direction );
+	heldRotation = direction - normalizeAngle( GetAngle() - before );
+	turned = true;
+	requestedRotation = direction;
+}
+
+/**\brief Checks whether this AI should think in an AIShards Lua state this frame.
+ * \details Only the Lua states of a state machine can run in a shard, and
+ * only once the main state has found the state function.  An AI that failed
+ * in a shard always thinks in the main state afterward.
+ */
+bool AI::WantsShard() {
+	if( !shardable || this->IsDisabled() || !AIScheduler::IsDue( nextThink ) ) {
+		return false;
+	}
+	if( stateFunction == LUA_NOREF || stateVersion != Lua::GetScriptVersion() ) {
+		return false;
+	}
+	if( (behaviour != NULL) && nativeAI.Get() && behaviour->Handles( state ) ) {
+		return false;
+	}
+	return true;
+}
+
+/**\brief Starts a thought that happened in an AIShards Lua state.
+ * \details This forgets the last thought, like Update does before Decide.
+ */
+void AI::StartThought() {
+	heldAcceleration = false;
+	heldRotation = 0;
+	turned = false;
+	requestedRotation = 0;
+}
+
+/**\brief Finishes a thought that happened in an AIShards Lua state.
+ * \details The next Update doesn't think or repeat the last thought.
+ */
+void AI::FinishThought() {
+	nextThink = AIScheduler::Thought( GetID(), thinkInterval, 0 );
+	decidedInShard = true;
+}
+
+/**\brief Finds the Lua function for a state of a state machine.
+ * \details Every function is looked up once and kept in the Lua registry
+ * until a script is loaded, since that may redefine the state machines.
+ * Missing states are remembered too.
+ *
+ * The think interval comes from the thinkIntervals table of the state
+ * machine, and is 1 for states that are not listed.
+ * \param interval [out] How many frames the state waits between thoughts.
+ * \return A registry reference to the function, or LUA_NOREF if there is no such state.
+ */
+int AI::GetStateFunction( const string& machine, const string& stateName, int *interval ) {
+	lua_State *L = Lua::CurrentState();
+	map<string, map<string,StateFunction> >::iterator m;
+	map<string,StateFunction>::iterator s;
+	StateFunction found;
+
+	// Forget everything when the scripts change
+	if( stateFunctionsVersion != Lua::GetScriptVersion() ) {
+		// References into a lua_State that was closed went with it
+		if( stateFunctionsGeneration == Lua::GetGeneration() ) {
+			for( m = stateFunctions.begin(); m != stateFunctions.end(); ++m ) {
+				for( s = m->second.begin(); s != m->second.end(); ++s ) {
+					if( s->second.function != LUA_NOREF ) {
+						luaL_unref( L, LUA_REGISTRYINDEX, s->second.function );
+					}
+				}
+			}
+		}
+		stateFunctions.clear();
+		stateFunctionsVersion = Lua::GetScriptVersion();
+		stateFunctionsGeneration = Lua::GetGeneration();
+	}
+
+	map<string,StateFunction> &states = stateFunctions[machine];
+	s = states.find( stateName );
+	if( s != states.end() ) {
+		*interval = s->second.interval;
+		return s->second.function;
+	}
+
+	found.function = LUA_NOREF;
+	found.interval = 1;
+	lua_getglobal(L, machine.c_str() );
+	if( lua_istable(L, -1) ) {
+		lua_getfield(L, -1, stateName.c_str() );
+		if( lua_isfunction(L, -1) ) {
+			found.function = luaL_ref(L, LUA_REGISTRYINDEX);
+		} else {
+			lua_pop(L, 1);
+		}
+
+		lua_getfield(L, -1, "thinkIntervals" );
+		if( lua_istable(L, -1) ) {
+			lua_getfield(L, -1, stateName.c_str() );
+			if( lua_isnumber(L, -1) && lua_tointeger(L, -1) > 1 ) {
+				found.interval = static_cast<int>( lua_tointeger(L, -1) );
+			}
+			lua_pop(L, 1);
+		}
+		lua_pop(L, 1);
+	}
+	lua_pop(L, 1);
+
+	states[stateName] = found;
+	*interval = found.interval;
+	return found.function;
 }
 
 /**\brief Updates the AI controlled ship by first calling the Lua function
  * and then calling Ship::Update()
+ * \details The AIScheduler decides whether the Lua function runs this frame.
+ * When it doesn't, the Ship keeps accelerating and turning the way that it
+ * did when it last thought.  When the AI already thought in an AIShards Lua
+ * state this frame, it has already acted.
  */
 void AI::Update() {
 	if( !this->IsDisabled() ) {
-		this->Decide();
+		if( decidedInShard ) {
+			decidedInShard = false;
+		} else if( AIScheduler::ShouldThink( nextThink ) ) {
+			double started = Timer::GetRealTime();
+			heldAcceleration = false;
+			heldRotation = 0;
+			turned = false;
+			requestedRotation = 0;
+			this->Decide();
+			double seconds = Timer::GetRealTime() - started;
+			if( timing ) {
+				decideTime += seconds;
+			}
+			nextThink = AIScheduler::Thought( GetID(), thinkInterval, seconds );
+		} else {
+			if( heldAcceleration ) {
+				this->Ship::Accelerate();
+			}
+			if( heldRotation != 0 ) {
+				float before = GetAngle();
+				this->Ship::Rotate( heldRotation );
+				heldRotation -= normalizeAngle( GetAngle() - before );
+			}
+		}
 	}
 
 	// Now act like a normal ship
@@ -126,6 +388,7 @@ void AI::Update() {
 void AI::Draw(){
 	this->Ship::Draw();
 	if( OPTION(int,"options/development/debug-ai") ) {
+		SpriteBatch::Flush(); // The text has to go on top of the Ship
 		Coordinate position = this->GetWorldPosition();
 		SansSerif->SetColor( WHITE );
 		SansSerif->Render(position.GetScreenX(),position.GetScreenY()+GetImage()->GetHalfHeight(),stateMachine);
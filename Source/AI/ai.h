@@ -11,6 +11,9 @@
 
 #include "Sprites/ship.h"
 #include "Engine/alliances.h"
+#include "Utilities/lua.h"
+
+class AIBehaviour;
 
 // Sprites have an AI object which is used to manipulate their attributes
 // to run an AI simulation
@@ -20,8 +23,8 @@ class AI : public Ship {
 		void Update();
 		void Draw();
 		void Decide();
-		void SetStateMachine(string _machine) { stateMachine = _machine; }
-		void SetState(string _state)  { state = _state; }
+		void SetStateMachine(string _machine) { stateMachine = _machine; stateFunction = LUA_NOREF; }
+		void SetState(string _state)  { state = _state; stateFunction = LUA_NOREF; }
 		void SetAlliance(Alliance* alliance) { allegiance = alliance; }
 		string GetName() { return name; }
 		void SetName(string newName) { name = newName; }
@@ -29,11 +32,60 @@ class AI : public Ship {
 		string GetState() { return state; }
 		Alliance* GetAlliance() { return allegiance; }
 
+		void Thrust();
+		void Turn( float direction );
+		void ChangeState( const string& newState );
+
+		// Thinking in an AIShards Lua state
+		bool WantsShard();
+		void StartThought();
+		void FinishThought();
+		void ForbidShard() { shardable = false; }
+		void SetFireResult( FireStatus result ) { lastFireResult = result; }
+		FireStatus GetFireResult() { return lastFireResult; }
+
+		static void SetTiming( bool _timing ) { timing = _timing; decideTime = 0; }
+		static double GetDecideTime() { return decideTime; }
+		static void AddDecideTime( double seconds ) { if( timing ) decideTime += seconds; }
+
 	private:
 		string name;
 		string stateMachine;
 		string state;
 		Alliance* allegiance;
+
+		void DecideInLua();
+		bool CompareWithLua();
+
+		AIBehaviour *behaviour; ///< The C++ versions of some states of the state machine, or NULL.
+		int stateFunction; ///< Registry reference to the function of the current state.
+		int thinkInterval; ///< How many frames the current state waits between thoughts.
+		unsigned int stateVersion; ///< The Lua script version that stateFunction came from.
+
+		Uint32 nextThink; ///< The logical frame when this AI should think again.
+		bool heldAcceleration; ///< The last thought accelerated.
+		float heldRotation; ///< How much of the last requested rotation is left.
+		bool turned; ///< The last thought asked to turn.
+		float requestedRotation; ///< How far the last thought asked to turn.
+
+		bool shardable; ///< Whether this AI may think in an AIShards Lua state.
+		bool decidedInShard; ///< This frame's thought already happened in a shard.
+		FireStatus lastFireResult; ///< What the last shot fired from a shard did.
+
+		/**\brief A state of a state machine (Internal use)
+		 */
+		struct StateFunction {
+			int function; ///< Registry reference, or LUA_NOREF if the state doesn't exist.
+			int interval; ///< Frames between thoughts.
+		};
+
+		static int GetStateFunction( const string& machine, const string& stateName, int *interval );
+		static map<string, map<string,StateFunction> > stateFunctions; ///< The state functions of each state machine.
+		static unsigned int stateFunctionsVersion; ///< The Lua script version that stateFunctions came from.
+		static unsigned int stateFunctionsGeneration; ///< The lua_State that stateFunctions are referenced in.
+
+		static bool timing; ///< Whether Update should measure the Lua AI.
+		static double decideTime; ///< Seconds spent in Decide and in the AIShards since timing was turned on.
 };
 
 #endif /*AI_H_*/
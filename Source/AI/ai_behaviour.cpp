@@ -0,0 +1,387 @@
+/**\file			ai_behaviour.cpp
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			C++ versions of the common AI states
+ * \details
+ */
+
+#include "includes.h"
+#include "common.h"
+#include "AI/ai_behaviour.h"
+#include "AI/ai.h"
+#include "Sprites/spritemanager.h"
+#include "Utilities/log.h"
+
+/**\class AIBehaviour
+ * \brief C++ versions of some of the states of a Lua state machine.
+ * \details
+ * The Trader, Patrol, Bully and Hunter state machines in ai.lua spend most
+ * of their time in a few simple steering states.  Those states have C++
+ * versions here that do exactly what the Lua function does, reading and
+ * writing the same AIData table, so an AI can move between a C++ state and a
+ * Lua state at any time.
+ *
+ * Every state that isn't listed here runs in Lua, and so does any C++ state
+ * that finds something that only the Lua version knows how to handle (for
+ * example when it would have to call okayTarget).  The Lua state machine is
+ * always needed, since it is what decides whether a state exists.
+ *
+ * Set "options/simulation/native-ai" to 0 to run everything in Lua, which a
+ * scenario that redefines these state machines should do.  Set
+ * "options/development/ai-parity" to 1 to run both versions and log any
+ * difference.
+ * \see AI::Decide
+ */
+
+map<string,AIBehaviour*> AIBehaviour::behaviours;
+bool AIBehaviour::registered = false;
+
+/**\brief Runs the C++ version of a state.
+ * \param ai The Ship that is thinking.
+ * \param state The current state.
+ * \param newState [out] The state to change to, left empty to stay.
+ * \return false when the state has to run in Lua instead.
+ */
+bool AIBehaviour::Decide( AI *ai, const string& state, string &newState ) {
+	map<string,AIStateFunction>::iterator s = states.find( state );
+	if( s == states.end() ) {
+		return false;
+	}
+
+	lua_State *L = Lua::CurrentState();
+	const int initialStackTop = lua_gettop(L);
+	bool handled = false;
+
+	// Every built in state keeps its memory in AIData[id]
+	lua_getglobal(L, "AIData");
+	if( lua_istable(L, -1) ) {
+		lua_rawgeti(L, -1, ai->GetID() );
+		if( lua_istable(L, -1) ) {
+			handled = s->second( ai, L, lua_gettop(L), newState );
+		}
+	}
+
+	lua_settop(L, initialStackTop);
+	return handled;
+}
+
+/**\brief Gives a state machine a C++ behaviour.
+ * \details The behaviour is never deleted.
+ */
+void AIBehaviour::Register( const string& machine, AIBehaviour *behaviour ) {
+	behaviours[machine] = behaviour;
+}
+
+/**\brief Finds the C++ behaviour of a state machine.
+ * \return NULL when every state of the machine runs in Lua.
+ */
+AIBehaviour *AIBehaviour::Get( const string& machine ) {
+	if( !registered ) {
+		RegisterDefaults();
+	}
+	map<string,AIBehaviour*>::iterator b = behaviours.find( machine );
+	if( b == behaviours.end() ) {
+		return NULL;
+	}
+	return b->second;
+}
+
+// Helpers for reading the AIData[id] table at the stack index data
+
+/**\brief Reads a number from AIData[id].
+ * \return false when the field isn't a number.
+ */
+static bool GetData( lua_State *L, int data, const char *field, int *value ) {
+	bool found;
+	lua_getfield(L, data, field);
+	found = ( lua_isnumber(L, -1) != 0 );
+	if( found ) {
+		*value = static_cast<int>( lua_tointeger(L, -1) );
+	}
+	lua_pop(L, 1);
+	return found;
+}
+
+/**\brief Checks whether AIData[id].hostile is a particular value.
+ */
+static bool IsHostile( lua_State *L, int data, int hostile ) {
+	int value;
+	return GetData( L, data, "hostile", &value ) && (value == hostile);
+}
+
+/**\brief Finds the Sprite that a field of AIData[id] refers to.
+ * \param sprite [out] The Sprite, or NULL when it no longer exists.
+ * \return false when the field isn't a Sprite ID.
+ */
+static bool GetDataSprite( lua_State *L, int data, const char *field, Sprite **sprite ) {
+	int id;
+	if( !GetData( L, data, field, &id ) ) {
+		return false;
+	}
+	*sprite = SpriteManager::Instance()->GetSpriteByID( id );
+	return true;
+}
+
+/**\brief The same distance as distfrom in utilities.lua.
+ */
+static double Distance( Coordinate a, Coordinate b ) {
+	double dx = a.GetX() - b.GetX();
+	double dy = a.GetY() - b.GetY();
+	return sqrt( dx*dx + dy*dy );
+}
+
+// The states.  Each one follows the Lua function of the same name in ai.lua.
+
+/**\brief Hunter.Hunting: Approach the target.
+ */
+static bool HunterHunting( AI *ai, lua_State *L, int data, string &newState ) {
+	Sprite *target;
+	if( !GetDataSprite( L, data, "target", &target ) ) {
+		return false;
+	}
+	if( target == NULL ) {
+		lua_pushinteger(L, 0);
+		lua_setfield(L, data, "hostile");
+		newState = "default";
+		return true;
+	}
+
+	Coordinate position = target->GetWorldPosition();
+	double dist = Distance( position, ai->GetWorldPosition() );
+
+	ai->Turn( ai->GetDirectionTowards( position ) );
+	if( ai->GetDirectionTowards( position ) == 0 ) {
+		ai->Thrust();
+	}
+
+	if( dist < 400 ) {
+		newState = "Killing";
+	} else if( dist > 1000 && IsHostile( L, data, 0 ) ) {
+		newState = "default";
+	} else {
+		newState = "Hunting";
+	}
+	return true;
+}
+
+/**\brief Trader.Travelling: Get to the planet.
+ */
+static bool TraderTravelling( AI *ai, lua_State *L, int data, string &newState ) {
+	Sprite *planet;
+	if( IsHostile( L, data, 1 ) ) {
+		newState = "Hunting";
+		return true;
+	}
+	if( !GetDataSprite( L, data, "destination", &planet ) ) {
+		return false;
+	}
+	if( planet == NULL ) {
+		newState = "New_Planet";
+		return true;
+	}
+
+	Coordinate position = planet->GetWorldPosition();
+	ai->Turn( ai->GetDirectionTowards( position ) );
+	ai->Thrust();
+	if( Distance( position, ai->GetWorldPosition() ) < 800 ) {
+		newState = "New_Planet";
+	}
+	return true;
+}
+
+/**\brief Trader.Docking: Stop on this planet.
+ */
+static bool TraderDocking( AI *ai, lua_State *L, int data, string &newState ) {
+	Sprite *planet;
+	if( IsHostile( L, data, 1 ) ) {
+		newState = "Hunting";
+		return true;
+	}
+	if( !GetDataSprite( L, data, "destination", &planet ) || (planet == NULL) ) {
+		return false;
+	}
+
+	double dist = Distance( planet->GetWorldPosition(), ai->GetWorldPosition() );
+	if( ai->GetMomentum().GetMagnitude() > 0.5 ) {
+		ai->Turn( - ai->GetDirectionTowards( ai->GetMomentum().GetAngle() ) );
+		if( dist > 100 && fabs( 180 - fabs( ai->GetMomentum().GetAngle() - ai->GetAngle() ) ) <= 10 ) {
+			ai->Thrust();
+		}
+	}
+	// If we drift away, then find a new planet
+	if( dist > 800 ) {
+		newState = "New_Planet";
+	}
+	return true;
+}
+
+/**\brief Patrol.Travelling: Get close enough to the planet to orbit it.
+ */
+static bool PatrolTravelling( AI *ai, lua_State *L, int data, string &newState ) {
+	Sprite *planet;
+	if( IsHostile( L, data, 1 ) ) {
+		newState = "Hunting";
+		return true;
+	}
+	if( !GetDataSprite( L, data, "destination", &planet ) || (planet == NULL) ) {
+		return false;
+	}
+
+	Coordinate position = planet->GetWorldPosition();
+	ai->Turn( ai->GetDirectionTowards( position ) );
+	ai->Thrust();
+	if( Distance( position, ai->GetWorldPosition() ) < 1000 ) {
+		newState = "Orbiting";
+	}
+	return true;
+}
+
+/**\brief Patrol.Orbiting: Circle the planet and look out for Hunters.
+ */
+static bool PatrolOrbiting( AI *ai, lua_State *L, int data, string &newState ) {
+	Sprite *planet;
+	if( IsHostile( L, data, 1 ) ) {
+		newState = "Hunting";
+		return true;
+	}
+	if( !GetDataSprite( L, data, "destination", &planet ) || (planet == NULL) ) {
+		return false;
+	}
+
+	Coordinate position = planet->GetWorldPosition();
+	double dist = Distance( position, ai->GetWorldPosition() );
+
+	// Only Lua knows whether a nearby Hunter is an okayTarget
+	if( dist <= 1500 && dist >= 500 ) {
+		Sprite *ship = SpriteManager::Instance()->GetNearestSprite( ai, 1000, DRAW_ORDER_SHIP | DRAW_ORDER_PLAYER );
+		if( ship != NULL ) {
+			if( ship->GetDrawOrder() != DRAW_ORDER_SHIP ) {
+				return false;
+			}
+			if( ((AI*)ship)->GetStateMachine() == "Hunter" ) {
+				return false;
+			}
+		}
+	}
+
+	ai->Thrust();
+	ai->Turn( ai->GetDirectionTowards( position ) + 90 );
+	if( dist > 1500 ) {
+		newState = "TooFar";
+	} else if( dist < 500 ) {
+		newState = "TooClose";
+	}
+	return true;
+}
+
+/**\brief Patrol.TooClose: Back away from the planet.
+ */
+static bool PatrolTooClose( AI *ai, lua_State *L, int data, string &newState ) {
+	Sprite *planet;
+	if( IsHostile( L, data, 1 ) ) {
+		newState = "Hunting";
+		return true;
+	}
+	if( !GetDataSprite( L, data, "destination", &planet ) || (planet == NULL) ) {
+		return false;
+	}
+
+	Coordinate position = planet->GetWorldPosition();
+	ai->Turn( - ai->GetDirectionTowards( position ) );
+	ai->Thrust();
+	if( Distance( position, ai->GetWorldPosition() ) > 800 ) {
+		newState = "Orbiting";
+	}
+	return true;
+}
+
+/**\brief Patrol.TooFar: Return to the planet.
+ */
+static bool PatrolTooFar( AI *ai, lua_State *L, int data, string &newState ) {
+	Sprite *planet;
+	if( IsHostile( L, data, 1 ) ) {
+		newState = "Hunting";
+		return true;
+	}
+	if( !GetDataSprite( L, data, "destination", &planet ) || (planet == NULL) ) {
+		return false;
+	}
+
+	Coordinate position = planet->GetWorldPosition();
+	ai->Turn( ai->GetDirectionTowards( position ) );
+	ai->Thrust();
+	if( Distance( position, ai->GetWorldPosition() ) < 1300 ) {
+		newState = "Orbiting";
+	}
+	return true;
+}
+
+/**\brief Bully.Orbiting: Circle the planet and look out for damaged Ships.
+ */
+static bool BullyOrbiting( AI *ai, lua_State *L, int data, string &newState ) {
+	Sprite *planet;
+	if( IsHostile( L, data, 1 ) ) {
+		newState = "Hunting";
+		return true;
+	}
+	if( !GetDataSprite( L, data, "destination", &planet ) || (planet == NULL) ) {
+		return false;
+	}
+
+	// Only Lua knows whether a damaged Ship is an okayTarget
+	Sprite *ship = SpriteManager::Instance()->GetNearestSprite( ai, 900, DRAW_ORDER_SHIP | DRAW_ORDER_PLAYER );
+	if( ship != NULL && ((Ship*)ship)->GetHullIntegrityPct() <= 0.9 ) {
+		return false;
+	}
+
+	Coordinate position = planet->GetWorldPosition();
+	double dist = Distance( position, ai->GetWorldPosition() );
+	if( dist > 1500 ) {
+		newState = "TooFar";
+		return true;
+	}
+	if( dist < 500 ) {
+		newState = "TooClose";
+		return true;
+	}
+	ai->Turn( ai->GetDirectionTowards( position ) + 90 );
+	ai->Thrust();
+	return true;
+}
+
+/**\brief Registers the behaviours of the state machines in ai.lua (Internal use)
+ */
+void AIBehaviour::RegisterDefaults( void ) {
+	AIBehaviour *hunter = new AIBehaviour();
+	AIBehaviour *trader = new AIBehaviour();
+	AIBehaviour *patrol = new AIBehaviour();
+	AIBehaviour *bully = new AIBehaviour();
+
+	registered = true;
+
+	hunter->AddState( "Hunting", HunterHunting );
+
+	trader->AddState( "Hunting", HunterHunting );
+	trader->AddState( "Travelling", TraderTravelling );
+	trader->AddState( "Docking", TraderDocking );
+
+	patrol->AddState( "Hunting", HunterHunting );
+	patrol->AddState( "Travelling", PatrolTravelling );
+	patrol->AddState( "Orbiting", PatrolOrbiting );
+	patrol->AddState( "TooClose", PatrolTooClose );
+	patrol->AddState( "TooFar", PatrolTooFar );
+
+	bully->AddState( "Hunting", HunterHunting );
+	bully->AddState( "Travelling", PatrolTravelling );
+	bully->AddState( "Orbiting", BullyOrbiting );
+	bully->AddState( "TooClose", PatrolTooClose );
+	bully->AddState( "TooFar", PatrolTooFar );
+
+	// Keep anything that was registered before the first Get
+	if( behaviours.find( "Hunter" ) == behaviours.end() ) Register( "Hunter", hunter );
+	if( behaviours.find( "Pirate" ) == behaviours.end() ) Register( "Pirate", hunter );
+	if( behaviours.find( "Trader" ) == behaviours.end() ) Register( "Trader", trader );
+	if( behaviours.find( "Patrol" ) == behaviours.end() ) Register( "Patrol", patrol );
+	if( behaviours.find( "Bully" ) == behaviours.end() ) Register( "Bully", bully );
+}
@@ -0,0 +1,47 @@
+/**\file			ai_behaviour.h
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			C++ versions of the common AI states
+ * \details
+ */
+
+#ifndef __H_AI_BEHAVIOUR__
+#define __H_AI_BEHAVIOUR__
+
+#include "includes.h"
+#include "Utilities/lua.h"
+
+class AI;
+
+/**\brief Runs one state for an AI.
+ * \param ai The Ship that is thinking.
+ * \param L The Lua state that holds the AIData table.
+ * \param data The stack index of AIData[id].
+ * \param newState [out] The state to change to, left empty to stay.
+ * \return false when the state has to run in Lua instead.  Nothing may be
+ *  changed before returning false.
+ */
+typedef bool (*AIStateFunction)( AI *ai, lua_State *L, int data, string &newState );
+
+class AIBehaviour {
+	public:
+		virtual ~AIBehaviour() {}
+
+		virtual bool Decide( AI *ai, const string& state, string &newState );
+		virtual bool Handles( const string& state ) { return states.find( state ) != states.end(); }
+		void AddState( const string& state, AIStateFunction function ) { states[state] = function; }
+
+		static void Register( const string& machine, AIBehaviour *behaviour );
+		static AIBehaviour *Get( const string& machine );
+
+	private:
+		static void RegisterDefaults( void );
+
+		map<string,AIStateFunction> states; ///< The states that have a C++ version.
+
+		static map<string,AIBehaviour*> behaviours; ///< The behaviour of each state machine.
+		static bool registered; ///< Whether the default behaviours have been registered.
+};
+
+#endif // __H_AI_BEHAVIOUR__
@@ -13,6 +13,7 @@
 #include "Sprites/player.h"
 #include "AI/ai_lua.h"
 #include "Audio/sound.h"
+#include "Utilities/assetloader.h"
 #include "Utilities/camera.h"
 #include "Utilities/trig.h"
 #include "Engine/commodities.h"
@@ -129,9 +130,10 @@ void AI_Lua::RegisterAI(lua_State *L){
 	luaL_openlib(L, EPIAR_SHIP, shipFunctions, 0);
 
 	// This may not be the best place for this line,
-	// preloading this animation prevents an FPS
+	// preloading the explosion prevents an FPS
 	// drop the first time that a ship explodes.
-	Ani::Get("Resources/Animations/explosion1.ani");
+	AssetLoader::Prefetch( RESOURCE_ANIMATION, Ship::explosionAnimation.GetPath() );
+	AssetLoader::Prefetch( RESOURCE_SOUND, Ship::explosionSound.GetPath() );
 
 	lua_pop(L,2);
 }
@@ -139,10 +141,10 @@ void AI_Lua::RegisterAI(lua_State *L){
 /**\brief Validates Ship in Lua.
  */
 AI* AI_Lua::checkShip(lua_State *L, int index){
-	int* idptr = (int*)luaL_checkudata(L, index, EPIAR_SHIP);
-	luaL_argcheck(L, idptr != NULL, index, "`EPIAR_SHIP' expected");
-	Sprite* s;
-	s = SpriteManager::Instance()->GetSpriteByID(*idptr);
+	SpriteHandle* handle = (SpriteHandle*)luaL_checkudata(L, index, EPIAR_SHIP);
+	luaL_argcheck(L, handle != NULL, index, "`EPIAR_SHIP' expected");
+	// The handle is cleared when the Sprite is deleted, so there is no need to look up the ID
+	Sprite* s = handle->sprite;
 	/*
 	if ((s) == NULL) luaL_typerror(L, index, EPIAR_SHIP);
 	if (0==((s)->GetDrawOrder() & DRAW_ORDER_SHIP|DRAW_ORDER_PLAYER)){
@@ -208,7 +210,12 @@ int AI_Lua::ShipAccelerate(lua_State* L){
 		AI* ai = checkShip(L,1);
 		if(ai==NULL) return 0;
 		luaL_argcheck(L, ai != NULL, 1, "`array' expected");
-		(ai)->Accelerate();
+		// Keep accelerating until the AI thinks again
+		if( ai->GetDrawOrder() == DRAW_ORDER_SHIP ) {
+			ai->Thrust();
+		} else {
+			(ai)->Accelerate();
+		}
 	}
 	else
 		luaL_error(L, "Got %d arguments expected 2 (self, direction)", n);
@@ -226,7 +233,12 @@ int AI_Lua::ShipRotate(lua_State* L){
 		AI* ai = checkShip(L,1);
 		if(ai==NULL) return 0;
 		float dir = static_cast<float>( luaL_checknumber(L, 2) );
-		(ai)->Rotate(dir);
+		// Finish the turn even if the AI doesn't think again until later
+		if( ai->GetDrawOrder() == DRAW_ORDER_SHIP ) {
+			ai->Turn(dir);
+		} else {
+			(ai)->Rotate(dir);
+		}
 	}
 	else
 		luaL_error(L, "Got %d arguments expected 2 (self, direction)", n);
@@ -314,12 +326,12 @@ int AI_Lua::ShipExplode(lua_State* L){
 		if(ai==NULL) return 0;
 		LogMsg(INFO,"A %s Exploded!",(ai)->GetModelName().c_str());
 		// Play explode sound
-		Sound *explodesnd = Sound::Get("Resources/Audio/Effects/18384__inferno__largex.wav.ogg");
-		if(OPTION(int, "options/sound/explosions"))
+		Sound *explodesnd = Ship::explosionSound.Get();
+		if(OPTION(int, "options/sound/explosions") && explodesnd)
 			explodesnd->Play(
 				(ai)->GetWorldPosition() - Camera::Instance()->GetFocusCoordinate());
 		SpriteManager::Instance()->Add(
-			new Effect((ai)->GetWorldPosition(), "Resources/Animations/explosion1.ani", 0) );
+			new Effect((ai)->GetWorldPosition(), Ship::explosionAnimation.Get(), 0) );
 		SpriteManager::Instance()->Delete((Sprite*)(ai));
 	} else {
 		luaL_error(L, "Got %d arguments expected 1 (ship)", n);
@@ -0,0 +1,101 @@
+/**\file			ai_scheduler.cpp
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Decides which AI Ships think on each logical frame
+ * \details
+ */
+
+#include "includes.h"
+#include "common.h"
+#include "AI/ai_scheduler.h"
+#include "Utilities/timer.h"
+
+/**\class AIScheduler
+ * \brief Spreads the Lua AI over the logical frames.
+ * \details
+ * Ships still move every frame, but they only run their state machine when
+ * they are due.  A state machine can ask for a state to think less often by
+ * listing it in its thinkIntervals table, for example:
+ * \code
+ * Trader.thinkIntervals = { Travelling = 4 }
+ * \endcode
+ * Ships with the same interval are spread over the frames by their ID, so a
+ * large fleet doesn't all think on the same frame.
+ *
+ * Once the AI has used "options/simulation/ai-budget" milliseconds in a
+ * frame, the rest of the due Ships wait for a later frame.  They can only be
+ * put off for AI_MAX_DEFER frames, so every Ship keeps thinking.
+ * \see AI::Update
+ */
+
+Uint32 AIScheduler::currentFrame = 0;
+double AIScheduler::spent = 0;
+int AIScheduler::thoughts = 0;
+int AIScheduler::deferred = 0;
+
+static OptionHandle<float> budget("options/simulation/ai-budget");
+
+/**\brief Checks whether an AI should run its state machine this frame.
+ * \param nextThink The frame that the AI is due to think on.
+ */
+bool AIScheduler::ShouldThink( Uint32 nextThink ) {
+	Uint32 frame = Timer::GetLogicalFrameCount();
+	int late;
+
+	if( frame != currentFrame ) {
+		StartFrame( frame );
+	}
+
+	// The frame count may wrap, so compare the difference
+	late = static_cast<int>( frame - nextThink );
+	if( late < 0 ) {
+		return false;
+	}
+
+	if( (budget.Get() > 0) && (spent * 1000.0 >= budget.Get()) && (late < AI_MAX_DEFER) ) {
+		deferred++;
+		return false;
+	}
+	return true;
+}
+
+/**\brief Checks whether an AI is due to think this frame, regardless of the budget.
+ * \details AIShards uses this, since the shards think on the worker threads.
+ * \param nextThink The frame that the AI is due to think on.
+ */
+bool AIScheduler::IsDue( Uint32 nextThink ) {
+	Uint32 frame = Timer::GetLogicalFrameCount();
+	if( frame != currentFrame ) {
+		StartFrame( frame );
+	}
+	return static_cast<int>( frame - nextThink ) >= 0;
+}
+
+/**\brief Records that an AI has thought.
+ * \param id The Sprite ID of the AI, used to spread AIs over the frames.
+ * \param interval How many frames until the AI should think again.
+ * \param seconds How long the AI took to think.
+ * \return The frame that the AI should think on next.
+ */
+Uint32 AIScheduler::Thought( int id, int interval, double seconds ) {
+	Uint32 frame = Timer::GetLogicalFrameCount();
+
+	spent += seconds;
+	thoughts++;
+
+	if( interval <= 1 ) {
+		return frame + 1;
+	}
+	// Think on the frames where (frame + id) is a multiple of the interval
+	return frame + interval - ((frame + static_cast<Uint32>(id)) % interval);
+}
+
+/**\brief Resets the counters for a new frame (Internal use)
+ */
+void AIScheduler::StartFrame( Uint32 frame ) {
+	currentFrame = frame;
+	spent = 0;
+	thoughts = 0;
+	deferred = 0;
+}
@@ -0,0 +1,34 @@
+/**\file			ai_scheduler.h
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Decides which AI Ships think on each logical frame
+ * \details
+ */
+
+#ifndef __H_AI_SCHEDULER__
+#define __H_AI_SCHEDULER__
+
+#include "includes.h"
+
+#define AI_MAX_DEFER 10 ///< An AI that is this many frames late thinks even when the budget is spent.
+
+class AIScheduler {
+	public:
+		static bool ShouldThink( Uint32 nextThink );
+		static bool IsDue( Uint32 nextThink );
+		static Uint32 Thought( int id, int interval, double seconds );
+
+		static int GetThoughts( void ) { return thoughts; }
+		static int GetDeferred( void ) { return deferred; }
+
+	private:
+		static void StartFrame( Uint32 frame );
+
+		static Uint32 currentFrame; ///< The logical frame that the counters below belong to.
+		static double spent;        ///< Seconds spent thinking this frame.
+		static int thoughts;        ///< AIs that thought this frame.
+		static int deferred;        ///< AIs that were due but were put off this frame.
+};
+
+#endif // __H_AI_SCHEDULER__
@@ -0,0 +1,930 @@
+/**\file			ai_shards.cpp
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Runs the Lua AI of many Ships at once in separate Lua states
+ * \details
+ */
+
+#include "includes.h"
+#include "common.h"
+#include "AI/ai_shards.h"
+#include "AI/ai.h"
+#include "AI/ai_lua.h"
+#include "Engine/hud.h"
+#include "Engine/simulation_lua.h"
+#include "Sprites/planets.h"
+#include "Sprites/spritemanager.h"
+#include "Utilities/log.h"
+#include "Utilities/lua_profiler.h"
+#include "Utilities/timer.h"
+
+/**\class AIShards
+ * \brief Runs the Lua state machines of the AI on the worker threads.
+ * \details
+ * A lua_State can only be used by one thread at a time, so each shard is a
+ * separate Lua state with its own copy of utilities.lua and ai.lua.  Every
+ * Ship that is due to think is given to the shard (ID % number of shards),
+ * and each shard is a job for the SpriteManager's WorkerPool.  This runs
+ * after the parallel Sprites have been updated and before the Ships are, so
+ * nothing moves while the shards are thinking.
+ *
+ * A shard only has the part of the Lua API that reads the world:
+ * Epiar.getSprite, Epiar.nearestShip, Epiar.nearestPlanet, Epiar.planetNames,
+ * Epiar.gateNames, Planet.Get, and the Ship and Planet getters.  The Ship
+ * actions (Accelerate, Rotate, Fire, ChangeWeapon, SetName, Remove) and
+ * HUD.newAlert are recorded as AICommands and done on the main thread once
+ * every shard is finished, in shard order.  Ship:Fire returns the result of
+ * the Ship's previous shot.
+ *
+ * The main Lua state owns AIData.  The first time that any shard reads
+ * AIData[id] in a frame, the numbers, strings and booleans in it are copied
+ * out of the main state, which is idle while the shards run, so only the
+ * entries that are used are ever copied.  In a shard, AIData[id] reads that
+ * copy with the shard's own writes on top, and every write is recorded and
+ * done to the main AIData afterward.  Writes in one shard are not seen by the
+ * other shards until the next frame.  Tables and functions in AIData (such as
+ * the Autopilot) can't be copied, so reading or writing one is an error.
+ *
+ * When a state fails in a shard for any reason, including using something
+ * that shards don't have, whatever it did is thrown away and the Ship thinks
+ * in the main state instead, then and from then on.
+ *
+ * This is turned on by setting "options/simulation/ai-shards" to the number
+ * of shards, which only has an effect when "options/simulation/threads" is
+ * also more than 1.  The C++ versions of the states in AIBehaviour run in the
+ * main state.
+ * \see AI::WantsShard, SpriteManager::UpdateInParallel
+ */
+
+vector<Shard*> AIShards::shards;
+unsigned int AIShards::scriptVersion = 0;
+map<int,AIOriginal> AIShards::data;
+SDL_mutex *AIShards::dataLock = NULL;
+
+/**\brief Creates the shards and loads the AI scripts into them.
+ * \param numShards How many Lua states to create.  With fewer than 2, the AI only runs in the main state.
+ * \param simulation The Simulation that the Ships belong to.
+ */
+bool AIShards::Init( int numShards, Simulation *simulation ) {
+	Close();
+	if( numShards < 2 ) {
+		return true;
+	}
+
+	dataLock = SDL_CreateMutex();
+	for( int i = 0; i < numShards; i++ ) {
+		Shard *shard = new Shard;
+		shard->L = lua_open();
+		if( shard->L == NULL ) {
+			LogMsg(ERR, "Could not create the Lua state of AI shard %d.", i );
+			delete shard;
+			Close();
+			return false;
+		}
+		shards.push_back( shard );
+		LuaProfiler::Attach( shard->L, "AIShards" );
+
+		// Each shard has its own random numbers, from a different seed
+		shard->random = ( (Uint32)rand() ^ ( (Uint32)(i + 1) * 2654435761U ) ) | 1;
+
+		luaL_openlibs( shard->L );
+		lua_pushlightuserdata( shard->L, simulation );
+		lua_setfield( shard->L, LUA_REGISTRYINDEX, "EPIAR_SIMULATION" );
+		lua_pushlightuserdata( shard->L, shard );
+		lua_setfield( shard->L, LUA_REGISTRYINDEX, EPIAR_SHARD );
+		Register( shard->L );
+
+		if( !LoadScripts( shard ) ) {
+			Close();
+			return false;
+		}
+	}
+	scriptVersion = Lua::GetScriptVersion();
+
+	LogMsg(INFO, "Running the Lua AI in %d shards.", numShards );
+	return true;
+}
+
+/**\brief Closes every shard.
+ */
+void AIShards::Close( void ) {
+	for( vector<Shard*>::iterator s = shards.begin(); s != shards.end(); ++s ) {
+		LuaProfiler::Detach( (*s)->L );
+		lua_close( (*s)->L );
+		delete (*s);
+	}
+	shards.clear();
+	data.clear();
+	if( dataLock != NULL ) {
+		SDL_DestroyMutex( dataLock );
+		dataLock = NULL;
+	}
+}
+
+/**\brief Loads the AI scripts into a shard (Internal use)
+ * \details This replaces the AIData table that ai.lua creates.
+ */
+bool AIShards::LoadScripts( Shard *shard ) {
+	static const char *scripts[] = {
+		"Resources/Scripts/utilities.lua",
+		"Resources/Scripts/ai.lua",
+		NULL
+	};
+	lua_State *L = shard->L;
+
+	for( int i = 0; scripts[i] != NULL; i++ ) {
+		if( (0 != luaL_loadfile(L, scripts[i])) || (0 != lua_pcall(L, 0, 0, 0)) ) {
+			LogMsg(ERR, "Error loading '%s' into an AI shard: %s", scripts[i], lua_tostring(L, -1) );
+			lua_settop(L, 0);
+			return false;
+		}
+	}
+
+	// AIData stays empty so that every access goes through the metatable
+	lua_newtable(L);
+	lua_createtable(L, 0, 2);
+	lua_pushcfunction(L, &AIShards::AIDataIndex);
+	lua_setfield(L, -2, "__index");
+	lua_pushcfunction(L, &AIShards::AIDataNewIndex);
+	lua_setfield(L, -2, "__newindex");
+	lua_setmetatable(L, -2);
+	lua_setglobal(L, "AIData");
+	return true;
+}
+
+/**\brief Decides for every Ship that is due to think in a shard.
+ * \details The Ships that don't go to a shard (the Player, disabled Ships,
+ * Ships in a state with a C++ version, and Ships that failed in a shard
+ * before) think during their own Update, as before.
+ * \param workers The threads that run the shards.
+ * \param sprites The Sprites that will be updated on the main thread, by quadrant.
+ * \param count How many quadrants are in use.
+ */
+void AIShards::Decide( WorkerPool *workers, vector< vector<Sprite*> > &sprites, unsigned int count ) {
+	vector<Shard*>::iterator s;
+	vector<Sprite*>::iterator i;
+	bool anyShips = false;
+
+	if( shards.empty() || workers == NULL ) {
+		return;
+	}
+
+	// The main state loaded a script, which may have changed the AI
+	if( scriptVersion != Lua::GetScriptVersion() ) {
+		for( s = shards.begin(); s != shards.end(); ++s ) {
+			if( !LoadScripts( *s ) ) {
+				LogMsg(ERR, "The AI will only run in the main Lua state." );
+				Close();
+				return;
+			}
+		}
+		scriptVersion = Lua::GetScriptVersion();
+	}
+
+	for( s = shards.begin(); s != shards.end(); ++s ) {
+		(*s)->ships.clear();
+		(*s)->commands.clear();
+		(*s)->written.clear();
+		(*s)->failed.clear();
+		(*s)->errors.clear();
+	}
+
+	// Quadrant order keeps the Ships of each shard in the order that they would update
+	for( unsigned int q = 0; q < count; ++q ) {
+		for( i = sprites[q].begin(); i != sprites[q].end(); ++i ) {
+			if( (*i)->GetDrawOrder() != DRAW_ORDER_SHIP ) {
+				continue;
+			}
+			AI *ai = (AI*)(*i);
+			if( ai->WantsShard() ) {
+				shards[ static_cast<unsigned int>(ai->GetID()) % shards.size() ]->ships.push_back( ai );
+				anyShips = true;
+			}
+		}
+	}
+	if( !anyShips ) {
+		return;
+	}
+
+	ProfileScope profile("AIShards::Decide");
+	double started = Timer::GetRealTime();
+	data.clear(); // Copied again as the shards read it
+	workers->Run( DecideShard, NULL, shards.size() );
+
+	for( s = shards.begin(); s != shards.end(); ++s ) {
+		Apply( *s );
+	}
+	AI::AddDecideTime( Timer::GetRealTime() - started );
+}
+
+/**\brief Detaches a Sprite that is being deleted from its userdata in every shard.
+ * \see Simulation_Lua::forgetSprite
+ */
+void AIShards::ForgetSprite( Sprite *sprite ) {
+	for( vector<Shard*>::iterator s = shards.begin(); s != shards.end(); ++s ) {
+		Simulation_Lua::forgetSprite( (*s)->L, sprite );
+	}
+}
+
+/**\brief Worker job that runs every Ship of one shard (Internal use)
+ */
+void AIShards::DecideShard( void *unused, int job ) {
+	Shard *shard = shards[job];
+	if( LuaProfiler::IsRunning() ) {
+		LuaProfiler::Resume( shard->L );
+	}
+	for( vector<AI*>::iterator ai = shard->ships.begin(); ai != shard->ships.end(); ++ai ) {
+		Think( shard, *ai );
+	}
+}
+
+/**\brief Runs the current state of a Ship in a shard (Internal use)
+ * \details This is the shard's version of AI::DecideInLua.  It runs on a worker thread.
+ */
+void AIShards::Think( Shard *shard, AI *ai ) {
+	lua_State *L = shard->L;
+	const unsigned int mark = shard->commands.size();
+	string error;
+
+	Record( L, AICommand::THINK, ai );
+
+	lua_getglobal(L, ai->GetStateMachine().c_str() );
+	if( lua_istable(L, -1) ) {
+		lua_getfield(L, -1, ai->GetState().c_str() );
+	} else {
+		lua_pushnil(L);
+	}
+
+	if( lua_isfunction(L, -1) ) {
+		lua_pushinteger( L, ai->GetID() );
+		lua_pushnumber( L, ai->GetWorldPosition().GetX() );
+		lua_pushnumber( L, ai->GetWorldPosition().GetY() );
+		lua_pushnumber( L, ai->GetAngle() );
+		lua_pushnumber( L, ai->GetMomentum().GetMagnitude() ); // Speed
+		lua_pushnumber( L, ai->GetMomentum().GetAngle() ); // Vector
+
+		if( lua_pcall(L, 6, 1, 0) == 0 ) {
+			if( lua_isstring(L, -1) ) {
+				AICommand &change = Record( L, AICommand::CHANGE_STATE, ai );
+				change.text = lua_tostring(L, -1);
+			}
+			Record( L, AICommand::DONE, ai );
+			lua_settop(L, 0);
+			return;
+		}
+		error = lua_tostring(L, -1);
+	} else {
+		error = "the state is not in the AI shard";
+	}
+	lua_settop(L, 0);
+
+	// Forget everything that this thought did.
+	// Only the AIData commands have entries; any other would make AIData[id] appear to exist.
+	shard->commands.resize( mark );
+	shard->written.clear();
+	for( vector<AICommand>::iterator c = shard->commands.begin(); c != shard->commands.end(); ++c ) {
+		if( c->type == AICommand::SET_DATA || c->type == AICommand::RESET_DATA || c->type == AICommand::CLEAR_DATA ) {
+			Write( shard->written[c->id], *c );
+		}
+	}
+
+	shard->failed.push_back( ai );
+	shard->errors.push_back( "Ship #" + stringify( ai->GetID() ) + " in "
+		+ ai->GetStateMachine() + "(" + ai->GetState() + ") will think in the main Lua state: " + error );
+}
+
+/**\brief Does what the Ships of a shard decided, on the main thread (Internal use)
+ */
+void AIShards::Apply( Shard *shard ) {
+	lua_State *L = Lua::CurrentState();
+	vector<AICommand>::iterator c;
+	unsigned int i;
+
+	for( c = shard->commands.begin(); c != shard->commands.end(); ++c ) {
+		AI *ai = c->ai;
+		bool isAI = (ai != NULL) && (ai->GetDrawOrder() == DRAW_ORDER_SHIP);
+		switch( c->type ) {
+			case AICommand::THINK:
+				ai->StartThought();
+				break;
+			case AICommand::ACCELERATE:
+				if( isAI ) {
+					ai->Thrust();
+				} else {
+					ai->Accelerate();
+				}
+				break;
+			case AICommand::ROTATE:
+				if( isAI ) {
+					ai->Turn( c->angle );
+				} else {
+					ai->Rotate( c->angle );
+				}
+				break;
+			case AICommand::FIRE:
+			{
+				FireStatus result = ai->Fire( c->target );
+				if( isAI ) {
+					ai->SetFireResult( result );
+				}
+				break;
+			}
+			case AICommand::CHANGE_WEAPON:
+				ai->ChangeWeapon();
+				break;
+			case AICommand::SET_NAME:
+				ai->SetName( c->text );
+				break;
+			case AICommand::REMOVE:
+				SpriteManager::Instance()->Delete( (Sprite*)ai );
+				break;
+			case AICommand::ALERT:
+				Hud::Alert( "%s", c->text.c_str() );
+				break;
+			case AICommand::SET_DATA:
+			case AICommand::RESET_DATA:
+			case AICommand::CLEAR_DATA:
+				ApplyData( L, *c );
+				break;
+			case AICommand::CHANGE_STATE:
+				ai->ChangeState( c->text );
+				break;
+			case AICommand::DONE:
+				ai->FinishThought();
+				break;
+		}
+	}
+
+	for( i = 0; i < shard->failed.size(); ++i ) {
+		LogMsg(WARN, "%s", shard->errors[i].c_str() );
+		shard->failed[i]->ForbidShard();
+	}
+}
+
+/**\brief Writes to AIData in the main Lua state (Internal use)
+ */
+void AIShards::ApplyData( lua_State *L, const AICommand &command ) {
+	lua_getglobal(L, "AIData");
+	if( !lua_istable(L, -1) ) {
+		lua_pop(L, 1);
+		return;
+	}
+	switch( command.type ) {
+		case AICommand::SET_DATA:
+			lua_rawgeti(L, -1, command.id);
+			if( lua_istable(L, -1) ) {
+				PushValue( L, command.value );
+				lua_setfield(L, -2, command.text.c_str() );
+			}
+			lua_pop(L, 1);
+			break;
+		case AICommand::RESET_DATA:
+			lua_newtable(L);
+			lua_rawseti(L, -2, command.id);
+			break;
+		case AICommand::CLEAR_DATA:
+			lua_pushnil(L);
+			lua_rawseti(L, -2, command.id);
+			break;
+		default:
+			break;
+	}
+	lua_pop(L, 1);
+}
+
+/**\brief Changes what a shard sees in AIData[id] (Internal use)
+ */
+void AIShards::Write( AIEntry &entry, const AICommand &command ) {
+	switch( command.type ) {
+		case AICommand::SET_DATA:
+			entry.fields[ command.text ] = command.value;
+			break;
+		case AICommand::RESET_DATA:
+			entry.exists = true;
+			entry.reset = true;
+			entry.fields.clear();
+			break;
+		case AICommand::CLEAR_DATA:
+			entry.exists = false;
+			entry.reset = true;
+			entry.fields.clear();
+			break;
+		default:
+			break;
+	}
+}
+
+/**\brief Finds the Shard that owns a Lua state (Internal use)
+ */
+Shard *AIShards::GetShard( lua_State *L ) {
+	Shard *shard;
+	lua_getfield(L, LUA_REGISTRYINDEX, EPIAR_SHARD);
+	shard = (Shard*)lua_touserdata(L, -1);
+	lua_pop(L, 1);
+	return shard;
+}
+
+/**\brief Adds a command to the shard that owns a Lua state (Internal use)
+ * \return The new command, which is only valid until the next one is recorded.
+ */
+AICommand &AIShards::Record( lua_State *L, AICommand::CommandType type, AI *ai ) {
+	Shard *shard = GetShard( L );
+	shard->commands.push_back( AICommand() );
+	AICommand &command = shard->commands.back();
+	command.type = type;
+	command.ai = ai;
+	command.id = (ai != NULL) ? ai->GetID() : 0;
+	command.angle = 0;
+	command.target = -1;
+	return command;
+}
+
+/**\brief Copies a value out of a Lua state (Internal use)
+ * \details Values that can't be copied only keep their type.
+ */
+void AIShards::CopyValue( lua_State *L, int index, AIValue &value ) {
+	value.type = lua_type(L, index);
+	switch( value.type ) {
+		case LUA_TNUMBER:
+			value.number = lua_tonumber(L, index);
+			break;
+		case LUA_TBOOLEAN:
+			value.number = lua_toboolean(L, index);
+			break;
+		case LUA_TSTRING:
+			value.text = lua_tostring(L, index);
+			break;
+		default:
+			break;
+	}
+}
+
+/**\brief Pushes a copied value onto a Lua state (Internal use)
+ */
+void AIShards::PushValue( lua_State *L, const AIValue &value ) {
+	switch( value.type ) {
+		case LUA_TNUMBER:
+			lua_pushnumber(L, value.number);
+			break;
+		case LUA_TBOOLEAN:
+			lua_pushboolean(L, value.number != 0);
+			break;
+		case LUA_TSTRING:
+			lua_pushstring(L, value.text.c_str());
+			break;
+		default:
+			lua_pushnil(L);
+			break;
+	}
+}
+
+/**\brief Copies AIData[id] out of the main Lua state, the first time that it is read this frame (Internal use)
+ * \details Any shard may call this.  The main thread is waiting for the
+ * shards, so its Lua state is only used by whichever shard holds dataLock.
+ * \return The copy, which doesn't change until the next frame.
+ */
+const AIOriginal *AIShards::Original( int id ) {
+	lua_State *L = Lua::CurrentState();
+
+	SDL_mutexP( dataLock );
+	map<int,AIOriginal>::iterator found = data.find( id );
+	if( found == data.end() ) {
+		found = data.insert( make_pair( id, AIOriginal() ) ).first;
+		AIOriginal &original = found->second;
+		lua_getglobal(L, "AIData");
+		if( lua_istable(L, -1) ) {
+			lua_rawgeti(L, -1, id);
+			if( lua_istable(L, -1) ) {
+				original.exists = true;
+				lua_pushnil(L);
+				while( lua_next(L, -2) ) {
+					if( lua_type(L, -2) == LUA_TSTRING ) {
+						CopyValue( L, -1, original.fields[ lua_tostring(L, -2) ] );
+					}
+					lua_pop(L, 1);
+				}
+			} else if( !lua_isnil(L, -1) ) {
+				original.mainOnly = true;
+			}
+			lua_pop(L, 1);
+		}
+		lua_pop(L, 1);
+	}
+	SDL_mutexV( dataLock );
+	return &found->second;
+}
+
+/**\brief Finds a field of AIData[id] as a shard sees it (Internal use)
+ * \return The value, or NULL if the field is nil.
+ */
+const AIValue *AIShards::Lookup( Shard *shard, int id, const string& field ) {
+	map<int,AIEntry>::iterator w = shard->written.find( id );
+	map<string,AIValue>::iterator f;
+
+	if( w != shard->written.end() ) {
+		if( !w->second.exists ) {
+			return NULL;
+		}
+		f = w->second.fields.find( field );
+		if( f != w->second.fields.end() ) {
+			return (f->second.type == LUA_TNIL) ? NULL : &f->second;
+		}
+		if( w->second.reset ) {
+			return NULL;
+		}
+	}
+
+	const AIOriginal *original = Original( id );
+	if( !original->exists ) {
+		return NULL;
+	}
+	map<string,AIValue>::const_iterator o = original->fields.find( field );
+	if( o == original->fields.end() ) {
+		return NULL;
+	}
+	return &o->second;
+}
+
+/**\brief Checks whether AIData[id] is a table as a shard sees it (Internal use)
+ */
+bool AIShards::Exists( Shard *shard, int id ) {
+	map<int,AIEntry>::iterator w = shard->written.find( id );
+	if( w != shard->written.end() ) {
+		return w->second.exists;
+	}
+	return Original( id )->exists;
+}
+
+/**\brief AIData[id] in a shard (Internal use)
+ * \returns A proxy for the entry, or nil.
+ */
+int AIShards::AIDataIndex( lua_State *L ) {
+	if( lua_type(L, 2) != LUA_TNUMBER ) {
+		return 0;
+	}
+	int id = static_cast<int>( lua_tointeger(L, 2) );
+	if( Original( id )->mainOnly ) {
+		return luaL_error(L, "AIData[%d] can only be used in the main Lua state.", id);
+	}
+	if( !Exists( GetShard(L), id ) ) {
+		return 0;
+	}
+
+	int *proxy = (int*)lua_newuserdata(L, sizeof(int));
+	*proxy = id;
+	luaL_getmetatable(L, EPIAR_SHARD_DATA);
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+/**\brief AIData[id] = value in a shard (Internal use)
+ * \details The value may be nil, or a table of numbers, strings and booleans.
+ */
+int AIShards::AIDataNewIndex( lua_State *L ) {
+	Shard *shard = GetShard(L);
+	int id = luaL_checkint(L, 2);
+
+	if( Original( id )->mainOnly ) {
+		return luaL_error(L, "AIData[%d] can only be used in the main Lua state.", id);
+	}
+
+	if( lua_isnil(L, 3) ) {
+		AICommand &clear = Record( L, AICommand::CLEAR_DATA, NULL );
+		clear.id = id;
+		Write( shard->written[id], clear );
+		return 0;
+	}
+	if( !lua_istable(L, 3) ) {
+		return luaL_error(L, "AIData[%d] can only be a table in an AI shard.", id);
+	}
+
+	AICommand &reset = Record( L, AICommand::RESET_DATA, NULL );
+	reset.id = id;
+	Write( shard->written[id], reset );
+
+	lua_pushnil(L);
+	while( lua_next(L, 3) ) {
+		if( lua_type(L, -2) != LUA_TSTRING ) {
+			return luaL_error(L, "AIData[%d] can only have named fields in an AI shard.", id);
+		}
+		AIValue value;
+		CopyValue( L, -1, value );
+		if( value.type != LUA_TNUMBER && value.type != LUA_TSTRING && value.type != LUA_TBOOLEAN ) {
+			return luaL_error(L, "AIData[%d].%s can only be a number, string or boolean in an AI shard.", id, lua_tostring(L, -2));
+		}
+		AICommand &set = Record( L, AICommand::SET_DATA, NULL );
+		set.id = id;
+		set.text = lua_tostring(L, -2);
+		set.value = value;
+		Write( shard->written[id], set );
+		lua_pop(L, 1);
+	}
+	return 0;
+}
+
+/**\brief AIData[id].field in a shard (Internal use)
+ */
+int AIShards::EntryIndex( lua_State *L ) {
+	int id = *(int*)luaL_checkudata(L, 1, EPIAR_SHARD_DATA);
+	if( lua_type(L, 2) != LUA_TSTRING ) {
+		return 0;
+	}
+	const AIValue *value = Lookup( GetShard(L), id, lua_tostring(L, 2) );
+	if( value == NULL ) {
+		return 0;
+	}
+	if( value->type != LUA_TNUMBER && value->type != LUA_TSTRING && value->type != LUA_TBOOLEAN ) {
+		return luaL_error(L, "AIData[%d].%s can only be used in the main Lua state.", id, lua_tostring(L, 2));
+	}
+	PushValue( L, *value );
+	return 1;
+}
+
+/**\brief AIData[id].field = value in a shard (Internal use)
+ */
+int AIShards::EntryNewIndex( lua_State *L ) {
+	Shard *shard = GetShard(L);
+	int id = *(int*)luaL_checkudata(L, 1, EPIAR_SHARD_DATA);
+	const char *field = luaL_checkstring(L, 2);
+	AIValue value;
+
+	if( !Exists( shard, id ) ) {
+		return luaL_error(L, "AIData[%d] is nil.", id);
+	}
+	CopyValue( L, 3, value );
+	if( value.type != LUA_TNIL && value.type != LUA_TNUMBER && value.type != LUA_TSTRING && value.type != LUA_TBOOLEAN ) {
+		return luaL_error(L, "AIData[%d].%s can only be a number, string or boolean in an AI shard.", id, field);
+	}
+
+	AICommand &set = Record( L, AICommand::SET_DATA, NULL );
+	set.id = id;
+	set.text = field;
+	set.value = value;
+	Write( shard->written[id], set );
+	return 0;
+}
+
+/**\brief Ship:Accelerate() in a shard (Internal use)
+ * \sa AI_Lua::ShipAccelerate
+ */
+int AIShards::ShipAccelerate( lua_State *L ) {
+	int n = lua_gettop(L);  // Number of arguments
+	if( n != 1 ) {
+		return luaL_error(L, "Got %d arguments expected 1 (self)", n);
+	}
+	AI* ai = AI_Lua::checkShip(L,1);
+	if( ai != NULL ) {
+		Record( L, AICommand::ACCELERATE, ai );
+	}
+	return 0;
+}
+
+/**\brief Ship:Rotate(direction) in a shard (Internal use)
+ * \sa AI_Lua::ShipRotate
+ */
+int AIShards::ShipRotate( lua_State *L ) {
+	int n = lua_gettop(L);  // Number of arguments
+	if( n != 2 ) {
+		return luaL_error(L, "Got %d arguments expected 2 (self, direction)", n);
+	}
+	AI* ai = AI_Lua::checkShip(L,1);
+	float direction = static_cast<float>( luaL_checknumber(L, 2) );
+	if( ai != NULL ) {
+		AICommand &rotate = Record( L, AICommand::ROTATE, ai );
+		rotate.angle = direction;
+	}
+	return 0;
+}
+
+/**\brief Ship:Fire([target]) in a shard (Internal use)
+ * \returns The FireStatus of the Ship's previous shot.
+ * \sa AI_Lua::ShipFire
+ */
+int AIShards::ShipFire( lua_State *L ) {
+	int n = lua_gettop(L);  // Number of arguments
+	if( (n != 1) && (n != 2) ) {
+		return luaL_error(L, "Got %d arguments expected 1 or 2 (ship, [target])", n);
+	}
+	AI* ai = AI_Lua::checkShip(L,1);
+	int target = (n == 2) ? luaL_checkinteger(L, 2) : -1;
+	if( ai == NULL ) {
+		return 0;
+	}
+	AICommand &fire = Record( L, AICommand::FIRE, ai );
+	fire.target = target;
+	lua_pushinteger(L, (ai->GetDrawOrder() == DRAW_ORDER_SHIP) ? ai->GetFireResult() : FireSuccess );
+	return 1;
+}
+
+/**\brief Ship:ChangeWeapon() in a shard (Internal use)
+ * \sa AI_Lua::ShipChangeWeapon
+ */
+int AIShards::ShipChangeWeapon( lua_State *L ) {
+	int n = lua_gettop(L);  // Number of arguments
+	if( n != 1 ) {
+		return luaL_error(L, "Got %d arguments expected 1 (ship)", n);
+	}
+	AI* ai = AI_Lua::checkShip(L,1);
+	if( ai != NULL ) {
+		Record( L, AICommand::CHANGE_WEAPON, ai );
+	}
+	return 0;
+}
+
+/**\brief Ship:SetName(newName) in a shard (Internal use)
+ * \sa AI_Lua::ShipSetName
+ */
+int AIShards::ShipSetName( lua_State *L ) {
+	int n = lua_gettop(L);  // Number of arguments
+	if( n != 2 ) {
+		return luaL_error(L, "Got %d arguments expected 2 (ship, newName)", n);
+	}
+	AI* ai = AI_Lua::checkShip(L,1);
+	const char *name = luaL_checkstring(L, 2);
+	if( ai != NULL ) {
+		AICommand &rename = Record( L, AICommand::SET_NAME, ai );
+		rename.text = name;
+	}
+	return 0;
+}
+
+/**\brief Ship:Remove() in a shard (Internal use)
+ * \sa AI_Lua::ShipRemove
+ */
+int AIShards::ShipRemove( lua_State *L ) {
+	int n = lua_gettop(L);  // Number of arguments
+	if( n != 1 ) {
+		return luaL_error(L, "Got %d arguments expected 1 (ship)", n);
+	}
+	AI* ai = AI_Lua::checkShip(L,1);
+	if( ai != NULL ) {
+		Record( L, AICommand::REMOVE, ai );
+	}
+	return 0;
+}
+
+/**\brief HUD.newAlert(message) in a shard (Internal use)
+ * \sa Hud::newAlert
+ */
+int AIShards::NewAlert( lua_State *L ) {
+	int n = lua_gettop(L);  // Number of arguments
+	if( n != 1 ) {
+		return luaL_error(L, "Got %d arguments expected 1 (message)", n);
+	}
+	AICommand &alert = Record( L, AICommand::ALERT, NULL );
+	alert.text = luaL_checkstring(L, 1);
+	return 0;
+}
+
+/**\brief math.random() in a shard (Internal use)
+ * \details Lua's math.random uses rand(), which all of the shards would share
+ * between threads.  This is a xorshift generator in the Shard instead, with
+ * the same arguments and results as math.random.
+ */
+int AIShards::Random( lua_State *L ) {
+	Shard *shard = GetShard(L);
+	Uint32 x = shard->random;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	shard->random = x;
+	lua_Number r = (lua_Number)x / 4294967296.0; // [0,1)
+
+	switch( lua_gettop(L) ) {
+		case 0:
+			lua_pushnumber(L, r);
+			break;
+		case 1: {
+			int u = luaL_checkint(L, 1);
+			luaL_argcheck(L, 1 <= u, 1, "interval is empty");
+			lua_pushnumber(L, floor(r * u) + 1);
+			break;
+		}
+		case 2: {
+			int l = luaL_checkint(L, 1);
+			int u = luaL_checkint(L, 2);
+			luaL_argcheck(L, l <= u, 2, "interval is empty");
+			lua_pushnumber(L, floor(r * (u - l + 1)) + l);
+			break;
+		}
+		default:
+			return luaL_error(L, "wrong number of arguments");
+	}
+	return 1;
+}
+
+/**\brief math.randomseed(seed) in a shard (Internal use)
+ */
+int AIShards::RandomSeed( lua_State *L ) {
+	Shard *shard = GetShard(L);
+	shard->random = (Uint32)luaL_checkint(L, 1);
+	if( shard->random == 0 ) {
+		shard->random = 1; // xorshift never leaves 0
+	}
+	return 0;
+}
+
+/**\brief Registers the part of the Lua API that a shard has (Internal use)
+ */
+void AIShards::Register( lua_State *L ) {
+	static const luaL_Reg engineFunctions[] = {
+		{"getSprite", &Simulation_Lua::getSpriteByID},
+		{"nearestShip", &Simulation_Lua::getNearestShip},
+		{"nearestPlanet", &Simulation_Lua::getNearestPlanet},
+		{"planetNames", &Simulation_Lua::getPlanetNames},
+		{"gateNames", &Simulation_Lua::getGateNames},
+		{NULL, NULL}
+	};
+
+	static const luaL_Reg shipMethods[] = {
+		// Actions, which are recorded
+		{"Accelerate", &AIShards::ShipAccelerate},
+		{"Rotate", &AIShards::ShipRotate},
+		{"Fire", &AIShards::ShipFire},
+		{"ChangeWeapon", &AIShards::ShipChangeWeapon},
+		{"SetName", &AIShards::ShipSetName},
+		{"Remove", &AIShards::ShipRemove},
+
+		// Current State
+		{"GetID", &AI_Lua::ShipGetID},
+		{"GetMass", &AI_Lua::ShipGetMass},
+		{"GetName", &AI_Lua::ShipGetName},
+		{"GetAlliance", &AI_Lua::ShipGetAlliance},
+		{"GetType", &AI_Lua::ShipGetType},
+		{"GetAngle", &AI_Lua::ShipGetAngle},
+		{"GetPosition", &AI_Lua::ShipGetPosition},
+		{"GetMomentumAngle", &AI_Lua::ShipGetMomentumAngle},
+		{"GetMomentumSpeed", &AI_Lua::ShipGetMomentumSpeed},
+		{"directionTowards", &AI_Lua::ShipGetDirectionTowards},
+		{"GetFriendly", &AI_Lua::ShipGetFriendly},
+
+		// General State
+		{"GetModelName", &AI_Lua::ShipGetModelName},
+		{"GetEngine", &AI_Lua::ShipGetEngine},
+		{"GetHull", &AI_Lua::ShipGetHull},
+		{"GetShield", &AI_Lua::ShipGetShield},
+		{"GetState", &AI_Lua::ShipGetState},
+		{"GetCredits", &AI_Lua::ShipGetCredits},
+		{"IsDisabled", &AI_Lua::ShipIsDisabled},
+		{"GetHullDamage", &AI_Lua::ShipGetHullDamage},
+		{"GetShieldDamage", &AI_Lua::ShipGetShieldDamage},
+		{"GetWeaponSlotCount", &AI_Lua::ShipGetWeaponSlotCount},
+		{NULL, NULL}
+	};
+
+	static const luaL_Reg planetFunctions[] = {
+		{"Get", &Planets_Lua::Get},
+		{NULL, NULL}
+	};
+
+	static const luaL_Reg planetMethods[] = {
+		{"GetName", &Planets_Lua::GetName},
+		{"GetID", &Planets_Lua::GetID},
+		{"GetType", &Planets_Lua::GetType},
+		{"GetPosition", &Planets_Lua::GetPosition},
+		{"GetAlliance", &Planets_Lua::GetAlliance},
+		{"Traffic", &Planets_Lua::GetTraffic},
+		{"MilitiaSize", &Planets_Lua::GetMilitiaSize},
+		{"Influence", &Planets_Lua::GetInfluence},
+		{"Landable", &Planets_Lua::GetLandable},
+		{NULL, NULL}
+	};
+
+	static const luaL_Reg hudFunctions[] = {
+		{"newAlert", &AIShards::NewAlert},
+		{NULL, NULL}
+	};
+
+	// Replaces these two in the math table from luaL_openlibs
+	static const luaL_Reg mathFunctions[] = {
+		{"random", &AIShards::Random},
+		{"randomseed", &AIShards::RandomSeed},
+		{NULL, NULL}
+	};
+
+	luaL_register(L, "Epiar", engineFunctions);
+	luaL_register(L, EPIAR_HUD, hudFunctions);
+	luaL_register(L, "math", mathFunctions);
+	lua_pop(L, 3);
+
+	luaL_newmetatable(L, EPIAR_SHIP);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	luaL_register(L, NULL, shipMethods);
+	lua_pop(L, 1);
+
+	luaL_newmetatable(L, EPIAR_PLANET);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, -2, "__index");
+	luaL_register(L, NULL, planetMethods);
+	luaL_register(L, EPIAR_PLANET, planetFunctions);
+	lua_pop(L, 2);
+
+	luaL_newmetatable(L, EPIAR_SHARD_DATA);
+	lua_pushcfunction(L, &AIShards::EntryIndex);
+	lua_setfield(L, -2, "__index");
+	lua_pushcfunction(L, &AIShards::EntryNewIndex);
+	lua_setfield(L, -2, "__newindex");
+	lua_pop(L, 1);
+}
@@ -0,0 +1,139 @@
+/**\file			ai_shards.h
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Runs the Lua AI of many Ships at once in separate Lua states
+ * \details
+ */
+
+#ifndef __H_AI_SHARDS__
+#define __H_AI_SHARDS__
+
+#include "includes.h"
+#include "Utilities/lua.h"
+#include "Utilities/workerpool.h"
+
+#define EPIAR_SHARD "Epiar.Shard"          ///< The registry key of the Shard that owns a lua_State.
+#define EPIAR_SHARD_DATA "Epiar.ShardData" ///< The metatable of the AIData[id] proxies in a shard.
+
+class AI;
+class Sprite;
+class Simulation;
+
+/**\brief A number, string or boolean copied out of a Lua table.
+ */
+struct AIValue {
+	int type;      ///< LUA_TNIL, LUA_TBOOLEAN, LUA_TNUMBER or LUA_TSTRING.
+	double number; ///< The number, or 0 or 1 for a boolean.
+	string text;   ///< The string.
+
+	AIValue() : type(LUA_TNIL), number(0) {}
+};
+
+/**\brief The AIData of one Ship in the main state, as it was when a shard first read it.
+ */
+struct AIOriginal {
+	bool exists;   ///< AIData[id] is a table.
+	bool mainOnly; ///< AIData[id] is something other than a table, which a shard can't copy.
+	map<string,AIValue> fields;
+
+	AIOriginal() : exists(false), mainOnly(false) {}
+};
+
+/**\brief The AIData of one Ship as a shard sees it.
+ */
+struct AIEntry {
+	bool exists; ///< False once AIData[id] has been set to nil.
+	bool reset;  ///< The fields below replace the snapshot entirely.
+	map<string,AIValue> fields;
+
+	AIEntry() : exists(true), reset(false) {}
+};
+
+/**\brief Something that a shard asked for, done on the main thread afterward.
+ */
+struct AICommand {
+	enum CommandType {
+		THINK,         ///< The Ship starts thinking.
+		ACCELERATE,    ///< Ship:Accelerate()
+		ROTATE,        ///< Ship:Rotate(angle)
+		FIRE,          ///< Ship:Fire(target)
+		CHANGE_WEAPON, ///< Ship:ChangeWeapon()
+		SET_NAME,      ///< Ship:SetName(text)
+		REMOVE,        ///< Ship:Remove()
+		ALERT,         ///< HUD.newAlert(text)
+		SET_DATA,      ///< AIData[id][text] = value
+		RESET_DATA,    ///< AIData[id] = {}
+		CLEAR_DATA,    ///< AIData[id] = nil
+		CHANGE_STATE,  ///< The state returned text.
+		DONE           ///< The Ship finished thinking.
+	} type;
+	AI *ai;        ///< The Ship.
+	int id;        ///< The AIData entry.
+	float angle;   ///< How far to rotate.
+	int target;    ///< What to fire at.
+	string text;   ///< A name, message, field or state.
+	AIValue value; ///< The value of a field.
+};
+
+/**\brief One extra Lua state and the Ships that think in it this frame.
+ */
+struct Shard {
+	lua_State *L;
+	vector<AI*> ships;            ///< Ships that think in this shard, in the order that they think.
+	vector<AICommand> commands;   ///< What the Ships asked for, in order.
+	map<int,AIEntry> written;     ///< AIData written in this shard this frame.
+	vector<AI*> failed;           ///< Ships that have to think in the main state instead.
+	vector<string> errors;        ///< Why they failed.
+	Uint32 random;                ///< The state of math.random, which is separate in each shard.
+};
+
+class AIShards {
+	public:
+		static bool Init( int numShards, Simulation *simulation );
+		static void Close( void );
+		static bool IsEnabled( void ) { return !shards.empty(); }
+
+		static void Decide( WorkerPool *workers, vector< vector<Sprite*> > &sprites, unsigned int count );
+		static void ForgetSprite( Sprite *sprite );
+
+	private:
+		static bool LoadScripts( Shard *shard );
+		static void DecideShard( void *unused, int job );
+		static void Think( Shard *shard, AI *ai );
+		static void Apply( Shard *shard );
+		static void ApplyData( lua_State *L, const AICommand &command );
+		static void Write( AIEntry &entry, const AICommand &command );
+
+		static Shard *GetShard( lua_State *L );
+		static AICommand &Record( lua_State *L, AICommand::CommandType type, AI *ai );
+		static void CopyValue( lua_State *L, int index, AIValue &value );
+		static void PushValue( lua_State *L, const AIValue &value );
+		static const AIOriginal *Original( int id );
+		static const AIValue *Lookup( Shard *shard, int id, const string& field );
+		static bool Exists( Shard *shard, int id );
+
+		// Lua functions that behave differently in a shard
+		static int AIDataIndex( lua_State *L );
+		static int AIDataNewIndex( lua_State *L );
+		static int EntryIndex( lua_State *L );
+		static int EntryNewIndex( lua_State *L );
+		static int ShipAccelerate( lua_State *L );
+		static int ShipRotate( lua_State *L );
+		static int ShipFire( lua_State *L );
+		static int ShipChangeWeapon( lua_State *L );
+		static int ShipSetName( lua_State *L );
+		static int ShipRemove( lua_State *L );
+		static int NewAlert( lua_State *L );
+		static int Random( lua_State *L );
+		static int RandomSeed( lua_State *L );
+
+		static void Register( lua_State *L );
+
+		static vector<Shard*> shards;
+		static unsigned int scriptVersion; ///< The version of the main scripts that the shards loaded.
+		static map<int,AIOriginal> data; ///< The entries of the main AIData that the shards read this frame.
+		static SDL_mutex *dataLock;      ///< Guards data, and the main Lua state while an entry is copied.
+};
+
+#endif // __H_AI_SHARDS__
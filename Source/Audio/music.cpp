@@ -20,10 +20,10 @@
  */
 Song *Song::Get( const string& filename ){
 	Song* value;
-	value = (Song*) Resource::Get( filename );
+	value = (Song*) Resource::Get( RESOURCE_SONG, filename );
 	if( value == NULL ){
 		value = new Song( filename );
-		Resource::Store( filename, (Resource*) value );
+		Resource::Store( RESOURCE_SONG, filename, (Resource*) value );
 	}
 	return value;
 }
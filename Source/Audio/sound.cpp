@@ -9,6 +9,7 @@
 #include "includes.h"
 #include "Audio/audio.h"
 #include "Audio/sound.h"
+#include "Utilities/assetloader.h"
 #include "Utilities/log.h"
 #include "Utilities/resource.h"
 
@@ -21,7 +22,10 @@
  */
 Sound *Sound::Get( const string& filename ){
 	Sound* value;
-	value = (Sound*) Resource::Get( filename );
+	value = (Sound*) Resource::Get( RESOURCE_SOUND, filename );
+	if( value == NULL && AssetLoader::Claim( RESOURCE_SOUND, filename ) ){
+		value = (Sound*) Resource::Get( RESOURCE_SOUND, filename );
+	}
 	if( value == NULL ){
 		value = new Sound( filename );
 		// If the sound couldn't be loaded, then abort
@@ -32,7 +36,7 @@ Sound *Sound::Get( const string& filename ){
 		}
 		else
 		{
-				Resource::Store( filename, (Resource*) value );
+				Resource::Store( RESOURCE_SOUND, filename, (Resource*) value );
 		}
 	}
 	return value;
@@ -49,10 +53,52 @@ Sound::Sound( const string& filename ):
 	panfactor( 0.1f ),
 	volume( 128 )
 {
-	this->sound = Mix_LoadWAV( filename.c_str() );
-	if( this->sound == NULL )
+	this->sound = Decode( filename );
+}
+
+/**\brief Uses a sound that was already decoded.
+ * \param filename Sound file
+ * \param chunk What Sound::Decode returned for the file.
+ */
+Sound::Sound( const string& filename, Mix_Chunk *chunk ):
+	sound( chunk ),
+	pathName(filename),
+	channel( -1 ),
+	fadefactor( 0.03 ),
+	panfactor( 0.1f ),
+	volume( 128 )
+{
+}
+
+/**\brief Reads and decodes a sound file.
+ * \param filename Sound file
+ * \return The decoded sound, or NULL.
+ */
+Mix_Chunk *Sound::Decode( const string& filename ){
+	Mix_Chunk *chunk = Mix_LoadWAV( filename.c_str() );
+	if( chunk == NULL )
+		LogMsg(ERR, "Could not load sound file: '%s', Mixer error: %s",
+				filename.c_str(), Mix_GetError() );
+	return chunk;
+}
+
+/**\brief Decodes a sound file that has already been read.
+ * \details SDL_mixer isn't thread safe, so this must be called on the main
+ * thread.  The AssetLoader's workers only read the file.
+ * \param filename Sound file
+ * \param buf The contents of the file
+ * \param bufSize Bytes in buf
+ * \return The decoded sound, or NULL.
+ */
+Mix_Chunk *Sound::Decode( const string& filename, char *buf, int bufSize ){
+	Mix_Chunk *chunk = NULL;
+	SDL_RWops *rw = SDL_RWFromMem( buf, bufSize );
+	if( rw != NULL )
+		chunk = Mix_LoadWAV_RW( rw, 1 );
+	if( chunk == NULL )
 		LogMsg(ERR, "Could not load sound file: '%s', Mixer error: %s",
 				filename.c_str(), Mix_GetError() );
+	return chunk;
 }
 
 /**\brief Destructor to free the sound file.
@@ -16,6 +16,9 @@ class Sound : public Resource {
 	public:
 		static Sound *Get( const string& filename );
 		Sound( const string& filename );
+		Sound( const string& filename, Mix_Chunk *chunk );
+		static Mix_Chunk *Decode( const string& filename );
+		static Mix_Chunk *Decode( const string& filename, char *buf, int bufSize );
 		~Sound( void );
 		bool Play( void );
 		bool Play( Coordinate offset );
@@ -143,3 +143,28 @@ Alliances *Alliances::Instance( void ) {
  * \brief Creates a new Alliance object.
  */
 
+/**\brief Finds where an Alliance is in the list of names.
+ * \details The positions are kept, so this doesn't look up any names unless
+ * an Alliance was added or replaced since the last call.
+ * \return The position, counting from 1 like Epiar.alliances(), or 0 if it isn't one of these.
+ */
+int Alliances::GetIndex( Alliance *alliance ) {
+	if( alliance == NULL ) {
+		return 0;
+	}
+	map<Alliance*,int>::iterator found = indices.find( alliance );
+	if( found != indices.end() && indexed == names.size() ) {
+		return found->second;
+	}
+
+	indices.clear();
+	int index = 1;
+	for( list<string>::iterator name = names.begin(); name != names.end(); ++name, ++index ) {
+		indices[ GetAlliance( *name ) ] = index;
+	}
+	indexed = names.size();
+
+	found = indices.find( alliance );
+	return ( found != indices.end() ) ? found->second : 0;
+}
+
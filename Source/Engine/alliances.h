@@ -40,14 +40,18 @@ class Alliances : public Components {
 		static Alliances *Instance();
 		Alliance* GetAlliance(string name) { return (Alliance*) this->Get(name); }
 		Component* newComponent() { return new Alliance(); }
+		int GetIndex( Alliance *alliance );
 
 	protected:
-		Alliances() {};
+		Alliances() : indexed(0) {};
 		Alliances( const Alliances & );
 		Alliances& operator= (const Alliances&);
 
 	private:
 		static Alliances *pInstance;
+
+		map<Alliance*,int> indices; ///< The results of GetIndex.
+		unsigned int indexed; ///< The number of Alliances when indices was built.
 };
 
 #endif // __h_alliances__
@@ -17,6 +17,7 @@
 #include "Utilities/log.h"
 #include "Utilities/timer.h"
 #include "Utilities/camera.h"
+#include "Utilities/lua_gc.h"
 
 /* Length of the hull integrity bar (pixels) + 6px (the left+right side imgs) */
 #define HULL_INTEGRITY_BAR  65
@@ -35,6 +36,16 @@
 #define RADAR_WIDTH        122
 #define RADAR_HEIGHT       122
 
+// Images drawn every frame.
+static ResourceHandle<Image> barLeft("Resources/Graphics/hud_bar_left.png");
+static ResourceHandle<Image> barMiddle("Resources/Graphics/hud_bar_middle.png");
+static ResourceHandle<Image> barRight("Resources/Graphics/hud_bar_right.png");
+static ResourceHandle<Image> hullLeft("Resources/Graphics/hud_hullstr_leftbar.png");
+static ResourceHandle<Image> hullMiddle("Resources/Graphics/hud_hullstr_bar.png");
+static ResourceHandle<Image> hullRight("Resources/Graphics/hud_hullstr_rightbar.png");
+static ResourceHandle<Image> shieldIntegrity("Resources/Graphics/hud_shieldintegrity.png");
+static ResourceHandle<Image> radarNav("Resources/Graphics/hud_radarnav.png");
+
 list<AlertMessage> Hud::AlertMessages;
 StatusBar* Hud::Bars[MAX_STATUS_BARS] = {};
 int Hud::targetID = -1;
@@ -95,6 +106,12 @@ StatusBar::StatusBar(string _title, int _width, QuadPosition _pos, string _updat
 	assert(pos<=4);
 }
 
+/**\brief Frees the compiled updater.
+ */
+StatusBar::~StatusBar() {
+	Lua::Release( lua_chunk );
+}
+
 /**\brief Assignment operator for class StatusBar.
  * \return Pointer to StatusBar
  */
@@ -104,6 +121,7 @@ StatusBar& StatusBar::operator=( StatusBar& object ){
 
 	ratio = object.ratio;
 	lua_updater = object.lua_updater;
+	Lua::Release( lua_chunk ); // Compiled again by the next Update
 
 	return * this;
 }
@@ -122,9 +140,9 @@ void StatusBar::print ()
 void StatusBar::Draw(int x, int y) {
 	int widthRemaining = this->width;
 
-	Image *BackgroundLeft = Image::Get( "Resources/Graphics/hud_bar_left.png" );
-	Image *BackgroundMiddle = Image::Get( "Resources/Graphics/hud_bar_middle.png" );
-	Image *BackgroundRight= Image::Get( "Resources/Graphics/hud_bar_right.png" );
+	Image *BackgroundLeft = barLeft.Get();
+	Image *BackgroundMiddle = barMiddle.Get();
+	Image *BackgroundRight= barRight.Get();
 
 	if(pos == UPPER_RIGHT || pos == LOWER_RIGHT) {
 		x = Video::GetWidth() - BackgroundLeft->GetWidth() - width - BackgroundRight->GetWidth();
@@ -150,9 +168,9 @@ void StatusBar::Draw(int x, int y) {
 
 	// Draw the Bar
 	if ( (int)(ratio*widthRemaining) > 0 ) {
-		Image *BarLeft = Image::Get( "Resources/Graphics/hud_hullstr_leftbar.png" );
-		Image *BarMiddle = Image::Get( "Resources/Graphics/hud_hullstr_bar.png" );
-		Image *BarRight = Image::Get( "Resources/Graphics/hud_hullstr_rightbar.png" );
+		Image *BarLeft = hullLeft.Get();
+		Image *BarMiddle = hullMiddle.Get();
+		Image *BarRight = hullRight.Get();
 
 		int bar_y = y + BackgroundLeft->GetHalfHeight() - BarLeft->GetHalfHeight();
 		BarLeft->Draw( x, bar_y );
@@ -168,7 +186,11 @@ void StatusBar::Update() {
 	lua_State* L = Lua::CurrentState();
 
 	// Run the StatusBar Updater
-	returnvals = Lua::Run( lua_updater, true );
+	// Compiled on the first Update, and again if Lua was restarted since
+	if( !Lua::IsCurrent( lua_chunk ) ) {
+		lua_chunk = Lua::Compile( lua_updater, true );
+	}
+	returnvals = Lua::Run( lua_chunk, true );
 
 	// Get the new StatusBar Status
 	if (returnvals == 0) {
@@ -280,6 +302,7 @@ void Hud::Draw( int flags, float fps ) {
 	if(flags & HUD_FPS)        Hud::DrawFPS(fps) ;
 	if(flags & HUD_StatusBars) Hud::DrawStatusBars();
 	if(flags & HUD_Map)        Hud::DrawMap();
+	if(flags & HUD_Lua)        Hud::DrawLua();
 }
 
 
@@ -293,12 +316,12 @@ void Hud::HandleInput( list<InputEvent> & events ) {
 		if( i->type == MOUSE && i->mstate==MOUSELDOWN) {
 			Coordinate screenPos(i->mx, i->my), worldPos;
 			Camera::Instance()->TranslateScreenToWorld( screenPos, worldPos );
-			// Target any clicked Sprite
-			list<Sprite*> *impacts = SpriteManager::Instance()->GetSpritesNear( worldPos, 5 );
-			if( impacts->size() > 0) {
-				Target( (*(impacts->begin()))->GetID());
+			// Target the nearest clicked Sprite
+			vector<Sprite*> impacts;
+			SpriteManager::Instance()->GetSpritesNear( impacts, worldPos, 5, DRAW_ORDER_ALL, true, 1 );
+			if( impacts.size() > 0) {
+				Target( impacts[0]->GetID() );
 			}
-			delete impacts;
 		}
 	}
 }
@@ -343,14 +366,36 @@ void Hud::DrawFPS( float fps ) {
 	BitType->Render( Video::GetWidth()-100, Video::GetHeight() - 45, frameRate );
 }
 
+/**\brief Draw the Lua memory use under the framerate.
+ * \details Only shown when "options/development/debug-lua" is set.
+ * \see LuaGC
+ */
+void Hud::DrawLua( void ) {
+	static OptionHandle<int> debugLua("options/development/debug-lua");
+	char line[32];
+	if( !debugLua.Get() ) {
+		return;
+	}
+
+	BitType->SetColor( WHITE );
+	snprintf(line, sizeof(line), "%d KB Lua", LuaGC::GetHeapKB() );
+	BitType->Render( Video::GetWidth()-100, Video::GetHeight() - 60, line );
+
+	snprintf(line, sizeof(line), "%.0f us GC", LuaGC::GetStepTime() * 1000000.0 );
+	BitType->Render( Video::GetWidth()-100, Video::GetHeight() - 75, line );
+
+	snprintf(line, sizeof(line), "%d GC cycles", LuaGC::GetCollections() );
+	BitType->Render( Video::GetWidth()-100, Video::GetHeight() - 90, line );
+}
+
 /**\brief Draws the status bar.
  */
 void Hud::DrawStatusBars() {
 	// Initialize the starting Coordinates
-	int barHeight = Image::Get( "Resources/Graphics/hud_bar_left.png" )->GetHeight()+5;
+	int barHeight = barLeft.Get()->GetHeight()+5;
 	Coordinate startCoords[4];
-	startCoords[UPPER_LEFT]  = Coordinate(5,Image::Get( "Resources/Graphics/hud_shieldintegrity.png" )->GetHeight()+5);
-	startCoords[UPPER_RIGHT] = Coordinate(5,Image::Get( "Resources/Graphics/hud_radarnav.png" )->GetHeight()+5);
+	startCoords[UPPER_LEFT]  = Coordinate(5,shieldIntegrity.Get()->GetHeight()+5);
+	startCoords[UPPER_RIGHT] = Coordinate(5,radarNav.Get()->GetHeight()+5);
 	startCoords[LOWER_LEFT]  = Coordinate(5,Video::GetHeight()-barHeight);
 	startCoords[LOWER_RIGHT] = Coordinate(5,Video::GetHeight()-barHeight);
 	Coordinate offsetCoords[4]= {
@@ -376,13 +421,13 @@ void Hud::DrawStatusBars() {
 /**\brief Draw the shield bar.
  */
 void Hud::DrawShieldIntegrity() {
-	Image::Get( "Resources/Graphics/hud_shieldintegrity.png" )->Draw( 35, 5 );
+	shieldIntegrity.Get()->Draw( 35, 5 );
 }
 
 /**\brief Draw the radar.
  */
 void Hud::DrawRadarNav( void ) {
-	Image::Get( "Resources/Graphics/hud_radarnav.png" )->Draw( Video::GetWidth() - 129, 5 );
+	radarNav.Get()->Draw( Video::GetWidth() - 129, 5 );
 	Video::SetCropRect( Video::GetWidth() - 125, 9, RADAR_WIDTH-8, RADAR_HEIGHT-8 );
 	Radar::Draw();
 	Video::UnsetCropRect();
@@ -424,8 +469,8 @@ void Hud::DrawUniverseMap( void ) {
 	//Video::GetHeight()
 	float size, halfsize;
 	float scale;
-	list<Sprite*> *sprites;
-	list<Sprite*>::iterator iter;
+	vector<Sprite*> sprites;
+	vector<Sprite*>::iterator iter;
 	int startx, starty;
 	int posx, posy;
 	int posx2, posy2;
@@ -456,10 +501,12 @@ void Hud::DrawUniverseMap( void ) {
 						 DRAW_ORDER_PLANET	|
 						 DRAW_ORDER_GATE_TOP );
 	
-	if( OPTION(int,"options/development/ships-worldmap") )
+	static OptionHandle<int> shipsOnMap("options/development/ships-worldmap");
+	if( shipsOnMap.Get() )
 		retrieveSprites= retrieveSprites | DRAW_ORDER_SHIP;
 	
-	sprites = SpriteManager::Instance()->GetSprites( retrieveSprites );
+	sprites.reserve( SpriteManager::Instance()->GetNumSprites() );
+	SpriteManager::Instance()->GetSprites( sprites, retrieveSprites );
 
 	// The Backdrop
 	Video::DrawRect( startx,starty,size,size,  0,0,0,alpha);
@@ -478,7 +525,7 @@ void Hud::DrawUniverseMap( void ) {
 	}
 
 	// The Sprites
-	for( iter = sprites->begin(); iter != sprites->end(); ++iter )
+	for( iter = sprites.begin(); iter != sprites.end(); ++iter )
 	{
 		col = (*iter)->GetRadarColor();
 		posx = startx + (*iter)->GetWorldPosition().GetX() * scale + halfsize;
@@ -513,7 +560,7 @@ void Hud::DrawUniverseMap( void ) {
 	}
 
 	// Do a second pass to draw planet Names on top
-	for( iter = sprites->begin(); iter != sprites->end(); ++iter )
+	for( iter = sprites.begin(); iter != sprites.end(); ++iter )
 	{
 		if( (*iter)->GetDrawOrder() == DRAW_ORDER_PLANET )
 		{
@@ -526,9 +573,6 @@ void Hud::DrawUniverseMap( void ) {
 	posx = startx + Camera::Instance()->GetFocusCoordinate().GetX() * scale + halfsize;
 	posy = starty + Camera::Instance()->GetFocusCoordinate().GetY() * scale + halfsize;
 	Video::DrawFilledCircle( posx, posy, Radar::GetVisibility()*scale, 0.9, 0.9, 0.9, alpha*.25 );
-
-	delete sprites;
-	sprites = NULL;
 }
 
 /**\brief Adds a new AlertMessage.
@@ -831,8 +875,9 @@ void Radar::Draw( void ) {
 	short int radar_mid_y = RADAR_MIDDLE_Y + 5;
 	int radarSize;
 
-	list<Sprite*> *spriteList = SpriteManager::Instance()->GetSpritesNear(Camera::Instance()->GetFocusCoordinate(), (float)visibility);
-	for( list<Sprite*>::const_iterator iter = spriteList->begin(); iter != spriteList->end(); iter++)
+	vector<Sprite*> spriteList;
+	SpriteManager::Instance()->GetSpritesNear( spriteList, Camera::Instance()->GetFocusCoordinate(), (float)visibility );
+	for( vector<Sprite*>::const_iterator iter = spriteList.begin(); iter != spriteList.end(); iter++)
 	{
 		Coordinate blip;
 		Sprite *sprite = *iter;
@@ -863,7 +908,6 @@ void Radar::Draw( void ) {
 				Video::DrawPoint( blip, sprite->GetRadarColor() );
 		}
 	}
-	delete spriteList;
 }
 
 /**\brief Gets the radar position based on world coordinate
@@ -28,6 +28,7 @@
 #define HUD_FPS         0x0010
 #define HUD_StatusBars  0x0020
 #define HUD_Map         0x0040
+#define HUD_Lua         0x0080
 #define HUD_ALL         0xFFFF
 
 
@@ -48,6 +49,7 @@ class AlertMessage {
 class StatusBar {
 	public:
 		StatusBar(string _title, int _width, QuadPosition _pos, string _updater);
+		~StatusBar();
 		StatusBar& operator=( StatusBar& object );
 		void Update();
 		void Draw(int x, int y);
@@ -69,6 +71,7 @@ class StatusBar {
 		char name[100]; // TODO: the name 'name' is bad
 		float ratio;
 		string lua_updater;
+		LuaChunk lua_chunk; ///< lua_updater compiled by Lua::Compile.
 };
 
 class Hud {
@@ -111,6 +114,7 @@ class Hud {
 		static void DrawRadarNav( void );
 		static void DrawMessages();
 		static void DrawFPS( float fps );
+		static void DrawLua( void );
 		static void DrawStatusBars();
 		static void DrawTarget();
 		static void DrawMap( void );
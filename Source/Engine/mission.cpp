@@ -9,6 +9,7 @@
 #include "includes.h"
 #include "Engine/mission.h"
 #include "Utilities/lua.h"
+#include "Utilities/lua_profiler.h"
 #include "Utilities/log.h"
 #include "Utilities/components.h"
 
@@ -154,6 +155,7 @@ bool Mission::Accept()
  */
 bool Mission::Update()
 {
+	ProfileScope profile("Mission::Update");
 	lua_State *L = Lua::CurrentState();
 	const int initialStackTop = lua_gettop(L);
 
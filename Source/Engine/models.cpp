@@ -156,7 +156,7 @@ void Model::_dbg_PrintInfo( void ) {
 	}
 	if(image!=NULL && name!=""){ 
 		cout<<"Storing Image for "<<name<<endl;
-		Image::Store(name,(Resource*)image);
+		Image::Store(name,image);
 	} else { assert(0); }
 }
 
@@ -27,8 +27,11 @@
 #include "Utilities/log.h"
 #include "Utilities/timer.h"
 #include "Utilities/lua.h"
+#include "Utilities/lua_gc.h"
+#include "Utilities/assetloader.h"
 #include "AI/ai.h"
 #include "AI/ai_lua.h"
+#include "AI/ai_shards.h"
 
 /**\class Simulation
  * \brief Handles main game loop. */
@@ -89,6 +92,8 @@ bool Simulation::SetupToRun(){
 	lua_State *L;
 
 	Timer::Update(); // Start the Timer
+
+	sprites->SetThreads( OPTION(int, "options/simulation/threads") );
 	
 
 	// Start the Lua Universe
@@ -115,6 +120,11 @@ bool Simulation::SetupToRun(){
 		return false;
 	}
 
+	// The AI can also think on the worker threads
+	if( OPTION(int, "options/simulation/threads") > 1 ) {
+		AIShards::Init( OPTION(int, "options/simulation/ai-shards"), this );
+	}
+
 	if( OPTION(int, "options/simulation/random-universe") ) {
 		if( OPTION(int, "options/simulation/random-seed") ) {
 			Lua::Call("createSystems", "i", OPTION(int, "options/simulation/random-seed") );
@@ -184,12 +194,16 @@ bool Simulation::Run() {
 	Hud::Alert("Epiar is currently under development. Please report all bugs to epiar.net");
 
 	// Generate a starfield
-	Starfield starfield( OPTION(int, "options/simulation/starfield-density") );
+	Starfield starfield( OPTION(int, "options/simulation/starfield-density"), OPTION(int, "options/simulation/starfield-layers") );
 
 	// Load sample game music
 	if(bgmusic && OPTION(int, "options/sound/background"))
 		bgmusic->Play();
 
+	// Options that are checked every second
+	OptionHandle<int> logUI("options/log/ui");
+	OptionHandle<int> logSprites("options/log/sprites");
+
 	// main game loop
 	bool lowFps = false;
 	int lowFpsFrameCount = 0;
@@ -228,6 +242,12 @@ bool Simulation::Run() {
 		console.Draw();
 		Video::Update();
 
+		// Collect Lua garbage while the frame is on screen
+		LuaGC::Step();
+
+		// Upload the assets that were decoded in the background
+		AssetLoader::Update();
+
 		// Don't kill the CPU (play nice)
 		if( paused ) {
 			Timer::Delay(50);
@@ -279,12 +299,12 @@ bool Simulation::Run() {
 				 * End Low FPS calculation
 				 ************************/
 
-			if( OPTION(int, "options/log/ui") )
+			if( logUI.Get() )
 			{
 				UI::Save();
 			}
 
-			if( OPTION(int, "options/log/sprites") )
+			if( logSprites.Get() )
 			{
 				sprites->Save();
 			}
@@ -297,11 +317,80 @@ bool Simulation::Run() {
 	optionsfile->Save();
 	
 	Hud::Close();
+	AIShards::Close();
 
 	LogMsg(INFO,"Average Framerate: %f Frames/Second", 1000.0 *((float)fpsTotal / Timer::GetTicks() ) );
 	return true;
 }
 
+/**\brief Measures how fast the Simulation runs without drawing anything.
+ * \details
+ * After the normal setup, numShips AI Ships are created around the Planets
+ * with createRandomShipForPlanet.  Then numFrames logical frames are run back
+ * to back, with no input, drawing or delays, since Timer::GetDelta is a fixed
+ * timestep.
+ *
+ * The results are printed to stdout as a single line of JSON.  The stages are
+ * the average milliseconds per tick spent in SpriteManager::Update; the Lua AI
+ * is part of the sprite update, so "sprites" excludes it.
+ * \param numShips How many AI Ships to create.
+ * \param numFrames How many logical frames to run.
+ * \return true if the Simulation could be set up.
+ */
+bool Simulation::Benchmark( int numShips, int numFrames ) {
+	vector<Sprite*> planetSprites;
+	UpdateTimes times;
+	double started, elapsed, aiTime;
+	int frame;
+
+	if( !SetupToRun() ) {
+		return false;
+	}
+
+	sprites->GetSprites( planetSprites, DRAW_ORDER_PLANET );
+	if( planetSprites.empty() ) {
+		LogMsg(ERR, "The Simulation '%s' has no Planets to create Ships around.", folderpath.c_str() );
+		return false;
+	}
+	for( int s = 0; s < numShips; s++ ) {
+		Lua::Call( "createRandomShipForPlanet", "i", planetSprites[ s % planetSprites.size() ]->GetID() );
+	}
+	LogMsg(INFO, "Benchmarking %d frames with %d Sprites.", numFrames, sprites->GetNumSprites() );
+
+	sprites->SetTiming( true );
+	AI::SetTiming( true );
+	started = Timer::GetRealTime();
+	for( frame = 0; frame < numFrames; frame++ ) {
+		// Projectiles and weapons read the clock, so it has to move at game speed
+		Timer::Advance( static_cast<Uint32>( 1000 / LOGIC_FPS ) );
+		Timer::IncrementFrameCount();
+		sprites->Update( false );
+	}
+	elapsed = Timer::GetRealTime() - started;
+	times = sprites->GetTimes();
+	aiTime = AI::GetDecideTime();
+	sprites->SetTiming( false );
+	AI::SetTiming( false );
+
+	// Milliseconds per tick
+	double scale = (numFrames > 0) ? (1000.0 / numFrames) : 0.0;
+	printf( "{\"simulation\":\"%s\",\"ships\":%d,\"frames\":%d,\"threads\":%d,\"sprites\":%d,\"quadrants\":%d,"
+	        "\"seconds\":%.6f,\"ticks_per_second\":%.3f,"
+	        "\"ms_per_tick\":{\"total\":%.6f,\"collision\":%.6f,\"sprites\":%.6f,\"lua_ai\":%.6f,\"rebalance\":%.6f}}\n",
+	        folderpath.c_str(), numShips, numFrames, OPTION(int, "options/simulation/threads"),
+	        sprites->GetNumSprites(), sprites->GetNumQuadrants(),
+	        elapsed, (elapsed > 0) ? (numFrames / elapsed) : 0.0,
+	        elapsed * scale,
+	        times.contacts * scale,
+	        (times.sprites - aiTime) * scale,
+	        aiTime * scale,
+	        times.rebalance * scale );
+	fflush( stdout );
+
+	AIShards::Close();
+	return true;
+}
+
 bool Simulation::SetupToEdit() {
 	bool luaLoad = true;
 	lua_State *L;
@@ -348,7 +437,7 @@ bool Simulation::SetupToEdit() {
 bool Simulation::Edit() {
 	bool quit = false;
 	// Generate a starfield
-	Starfield starfield( OPTION(int, "options/simulation/starfield-density") );
+	Starfield starfield( OPTION(int, "options/simulation/starfield-density"), OPTION(int, "options/simulation/starfield-layers") );
 
 	while( !quit ) {
 		quit = HandleInput();
@@ -369,6 +458,12 @@ bool Simulation::Edit() {
 		console.Draw();
 		Video::Update();
 
+		// Collect Lua garbage while the frame is on screen
+		LuaGC::Step();
+
+		// Upload the assets that were decoded in the background
+		AssetLoader::Update();
+
 		// Don't kill the CPU (play nice)
 		Timer::Delay( 50 );
 	}
@@ -394,6 +489,15 @@ void Simulation::LuaRegisters(lua_State *L) {
 bool Simulation::Parse( void ) {
 	LogMsg(INFO, "Simulation version %s.%s.%s.", Get("version-major").c_str(), Get("version-minor").c_str(),  Get("version-macro").c_str());
 
+	// Start decoding the images and sounds of the components before they are parsed
+	AssetLoader::PrefetchManifest( folderpath + Get("engines") );
+	AssetLoader::PrefetchManifest( folderpath + Get("models") );
+	AssetLoader::PrefetchManifest( folderpath + Get("weapons") );
+	AssetLoader::PrefetchManifest( folderpath + Get("outfits") );
+	if( 0 == OPTION(int, "options/simulation/random-universe")) {
+		AssetLoader::PrefetchManifest( folderpath + Get("planets") );
+	}
+
 	// Now load the various subsystems
 	if( commodities->Load( (folderpath + Get("commodities")) ) != true ) {
 		LogMsg(ERR, "There was an error loading the commodities from '%s'.", (folderpath + Get("commodities")).c_str() );
@@ -34,6 +34,7 @@ class Simulation : public XMLFile {
 		bool SetupToEdit();
 
 		bool Run();
+		bool Benchmark( int numShips, int numFrames );
 		bool Edit();
 		void LuaRegisters(lua_State *L);
 
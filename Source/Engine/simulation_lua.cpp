@@ -18,6 +18,8 @@
 #include "Engine/alliances.h"
 #include "Utilities/log.h"
 #include "Utilities/lua.h"
+#include "Utilities/lua_gc.h"
+#include "Utilities/lua_profiler.h"
 #include "AI/ai_lua.h"
 #include "UI/ui_lua.h"
 #include "UI/ui.h"
@@ -89,6 +91,7 @@ void Simulation_Lua::RegisterSimulation(lua_State *L) {
 		{"gates", &Simulation_Lua::getGates},
 		{"nearestShip", &Simulation_Lua::getNearestShip},
 		{"nearestPlanet", &Simulation_Lua::getNearestPlanet},
+		{"perceive", &Simulation_Lua::perceive},
 
 		// Keyboard Command Functions
 		{"RegisterKey", &Simulation_Lua::RegisterKey},
@@ -108,6 +111,12 @@ void Simulation_Lua::RegisterSimulation(lua_State *L) {
 
 		// File System Functions
 		{"listImages", &Simulation_Lua::listImages},
+
+		// Debugging Functions
+		{"luaGC", &Simulation_Lua::luaGC},
+		{"profileStart", &Simulation_Lua::profileStart},
+		{"profileStop", &Simulation_Lua::profileStop},
+		{"profileDump", &Simulation_Lua::profileDump},
 		{NULL, NULL}
 	};
 	luaL_register(L,"Epiar",EngineFunctions);
@@ -525,8 +534,21 @@ int Simulation_Lua::getGateNames(lua_State *L){
  *  \note Sprites are referenced by their ID.
  */
 void Simulation_Lua::pushSprite(lua_State *L,Sprite* s){
-	int* id = (int*)lua_newuserdata(L, sizeof(int*));
-	*id = s->GetID();
+	SpriteHandle *handle;
+	int id = s->GetID();
+
+	// Every Sprite has a single userdata that is reused until the Sprite is deleted
+	pushSpriteCache(L);
+	lua_rawgeti(L, -1, id);
+	if( !lua_isnil(L, -1) ) {
+		lua_remove(L, -2);
+		return;
+	}
+	lua_pop(L, 1);
+
+	handle = (SpriteHandle*)lua_newuserdata(L, sizeof(SpriteHandle));
+	handle->id = id;
+	handle->sprite = s;
 	switch(s->GetDrawOrder()){
 	case DRAW_ORDER_SHIP:
 	case DRAW_ORDER_PLAYER:
@@ -543,6 +565,46 @@ void Simulation_Lua::pushSprite(lua_State *L,Sprite* s){
 		luaL_getmetatable(L, EPIAR_SHIP);
 		lua_setmetatable(L, -2);
 	}
+
+	lua_pushvalue(L, -1);
+	lua_rawseti(L, -3, id);
+	lua_remove(L, -2);
+}
+
+/**\brief Detaches a Sprite that is being deleted from its userdata.
+ * \details Lua may still hold the userdata, but it will no longer find the Sprite.
+ */
+void Simulation_Lua::forgetSprite(lua_State *L,Sprite* s){
+	SpriteHandle *handle;
+
+	pushSpriteCache(L);
+	lua_rawgeti(L, -1, s->GetID());
+	handle = (SpriteHandle*)lua_touserdata(L, -1);
+	if( handle != NULL ) {
+		handle->sprite = NULL;
+		lua_pushnil(L);
+		lua_rawseti(L, -3, s->GetID());
+	}
+	lua_pop(L, 2);
+}
+
+/**\brief Pushes the table of Sprite userdata, keyed by ID (Internal use)
+ * \details The values are weak, so userdata that Lua no longer uses are still collected.
+ */
+void Simulation_Lua::pushSpriteCache(lua_State *L){
+	lua_getfield(L, LUA_REGISTRYINDEX, EPIAR_SPRITE_CACHE);
+	if( lua_istable(L, -1) ) {
+		return;
+	}
+	lua_pop(L, 1);
+
+	lua_newtable(L);
+	lua_createtable(L, 0, 1);
+	lua_pushstring(L, "v");
+	lua_setfield(L, -2, "__mode");
+	lua_setmetatable(L, -2);
+	lua_pushvalue(L, -1);
+	lua_setfield(L, LUA_REGISTRYINDEX, EPIAR_SPRITE_CACHE);
 }
 
 /*
@@ -600,29 +662,29 @@ int Simulation_Lua::getSpriteByID(lua_State *L){
 int Simulation_Lua::getSprites(lua_State *L, int kind){
 	int n = lua_gettop(L);  // Number of arguments
 
-	list<Sprite *> *sprites = NULL;
+	vector<Sprite *> sprites; // Owned by this call, since pushSprite may run Lua that asks again
 	if( n==3 ){
 		double x = luaL_checknumber (L, 1);
 		double y = luaL_checknumber (L, 2);
 		double r = luaL_checknumber (L, 3);
-		sprites = GetSimulation(L)->GetSpriteManager()->GetSpritesNear(Coordinate(x,y),static_cast<float>(r),kind);
+		// Scripts expect the nearest Sprites first
+		GetSimulation(L)->GetSpriteManager()->GetSpritesNear( sprites, Coordinate(x,y), static_cast<float>(r), kind, true );
 	} else {
-		sprites = GetSimulation(L)->GetSpriteManager()->GetSprites(kind);
+		GetSimulation(L)->GetSpriteManager()->GetSprites( sprites, kind );
 	}
 
 	// Populate a Lua table with Sprites
-	lua_createtable(L, sprites->size(), 0);
+	lua_createtable(L, sprites.size(), 0);
 	int newTable = lua_gettop(L);
 	int index = 1;
-	list<Sprite *>::const_iterator iter = sprites->begin();
-	while(iter != sprites->end()) {
+	vector<Sprite *>::const_iterator iter = sprites.begin();
+	while(iter != sprites.end()) {
 		// push userdata
 		pushSprite(L,(*iter));
 		lua_rawseti(L, newTable, index);
 		++iter;
 		++index;
 	}
-	delete sprites;
 	return 1;
 }
 
@@ -743,6 +805,114 @@ int Simulation_Lua::getNearestPlanet(lua_State *L) {
 	return Simulation_Lua::getNearestSprite(L,DRAW_ORDER_PLANET);
 }
 
+// The arrays in the table that perceive fills, in the order that they are filled
+static const char *perceptionFields[] = { "id", "x", "y", "vx", "vy", "hull", "alliance", "distance" };
+static const int numPerceptionFields = sizeof(perceptionFields) / sizeof(perceptionFields[0]);
+
+/** \brief Describe everything near a Ship with one spatial query
+ *  \param[in] The Ship that is looking.  It is not included.
+ *  \param[in] How far to look.
+ *  \param[in] (Optional) The kinds of Sprites to include.  Ships and the Player by default.
+ *  \returns A table of arrays, nearest Sprite first:
+ *   count, id, x, y, vx, vy, hull (fraction left), alliance (index into Epiar.alliances(), 0 for none) and distance.
+ *  \note Every call fills the same table, so copy anything that has to be kept.
+ */
+int Simulation_Lua::perceive(lua_State *L) {
+	vector<Sprite*> nearby;
+	int n = lua_gettop(L);  // Number of arguments
+	int table, previous, count, f;
+	vector<Sprite*>::iterator i;
+
+	if( n < 2 || n > 3 ) {
+		return luaL_error(L, "Got %d arguments expected 2 or 3 (ship, radius, [mask])", n);
+	}
+	AI* ai = AI_Lua::checkShip(L,1);
+	if( ai==NULL ) {
+		return 0;
+	}
+	float r = static_cast<float>(luaL_checknumber(L, 2));
+	int mask = (n == 3) ? luaL_checkint(L, 3) : (DRAW_ORDER_SHIP | DRAW_ORDER_PLAYER);
+	Coordinate here = ai->GetWorldPosition();
+
+	Alliances *alliances = GetSimulation(L)->GetAlliances();
+	GetSimulation(L)->GetSpriteManager()->GetSpritesNear( nearby, here, r, mask, true );
+
+	pushPerception(L);
+	table = lua_gettop(L);
+	lua_getfield(L, table, "count");
+	previous = static_cast<int>( lua_tointeger(L, -1) );
+	lua_pop(L, 1);
+	for( f = 0; f < numPerceptionFields; f++ ) {
+		lua_getfield(L, table, perceptionFields[f]); // The arrays are at table+1 to table+numPerceptionFields
+	}
+
+	count = 0;
+	for( i = nearby.begin(); i != nearby.end(); ++i ) {
+		Sprite *s = *i;
+		if( s == ai ) {
+			continue;
+		}
+		count++;
+
+		Alliance *alliance = NULL;
+		float hull = 1.0f;
+		if( s->GetDrawOrder() == DRAW_ORDER_SHIP ) {
+			alliance = ((AI*)s)->GetAlliance();
+		} else if( s->GetDrawOrder() == DRAW_ORDER_PLANET ) {
+			alliance = ((Planet*)s)->GetAlliance();
+		}
+		if( s->GetDrawOrder() & (DRAW_ORDER_SHIP | DRAW_ORDER_PLAYER) ) {
+			hull = ((Ship*)s)->GetHullIntegrityPct();
+		}
+		// Alliances are numbered in the same order as Epiar.alliances()
+		int allianceIndex = alliances->GetIndex( alliance );
+
+		Coordinate position = s->GetWorldPosition();
+		Coordinate momentum = s->GetMomentum();
+		lua_pushinteger(L, s->GetID());                     lua_rawseti(L, table + 1, count);
+		lua_pushnumber(L, position.GetX());                 lua_rawseti(L, table + 2, count);
+		lua_pushnumber(L, position.GetY());                 lua_rawseti(L, table + 3, count);
+		lua_pushnumber(L, momentum.GetX());                 lua_rawseti(L, table + 4, count);
+		lua_pushnumber(L, momentum.GetY());                 lua_rawseti(L, table + 5, count);
+		lua_pushnumber(L, hull);                            lua_rawseti(L, table + 6, count);
+		lua_pushinteger(L, allianceIndex);                  lua_rawseti(L, table + 7, count);
+		lua_pushnumber(L, (position - here).GetMagnitude()); lua_rawseti(L, table + 8, count);
+	}
+
+	// Clear what is left over from a longer perception so that # still works
+	for( int old = count + 1; old <= previous; old++ ) {
+		for( f = 1; f <= numPerceptionFields; f++ ) {
+			lua_pushnil(L);
+			lua_rawseti(L, table + f, old);
+		}
+	}
+	lua_settop(L, table);
+
+	lua_pushinteger(L, count);
+	lua_setfield(L, table, "count");
+	return 1;
+}
+
+/**\brief Pushes the table that perceive fills, creating it the first time (Internal use)
+ */
+void Simulation_Lua::pushPerception(lua_State *L) {
+	lua_getfield(L, LUA_REGISTRYINDEX, EPIAR_PERCEPTION);
+	if( lua_istable(L, -1) ) {
+		return;
+	}
+	lua_pop(L, 1);
+
+	lua_newtable(L);
+	for( int f = 0; f < numPerceptionFields; f++ ) {
+		lua_newtable(L);
+		lua_setfield(L, -2, perceptionFields[f]);
+	}
+	lua_pushinteger(L, 0);
+	lua_setfield(L, -2, "count");
+	lua_pushvalue(L, -1);
+	lua_setfield(L, LUA_REGISTRYINDEX, EPIAR_PERCEPTION);
+}
+
 /** \brief Get Information about a Commodity
  *  \returns Lua table of Commodity Information
  */
@@ -1361,3 +1531,51 @@ int Simulation_Lua::listImages(lua_State *L) {
 	return 1;
 }
 
+/** \brief Describe the Lua garbage collector for the console
+ *  \returns The heap size, the time of the last step and the number of cycles
+ *  \see LuaGC
+ */
+int Simulation_Lua::luaGC(lua_State *L) {
+	char stats[128];
+	snprintf(stats, sizeof(stats), "Lua heap: %d KB, last GC step: %.0f us, GC cycles: %d",
+		LuaGC::GetHeapKB(), LuaGC::GetStepTime() * 1000000.0, LuaGC::GetCollections() );
+	lua_pushstring(L, stats);
+	return 1;
+}
+
+/** \brief Start sampling the Lua scripts
+ *  \param[in] (Optional) Lua instructions between samples.
+ *  \see LuaProfiler
+ */
+int Simulation_Lua::profileStart(lua_State *L) {
+	int interval = luaL_optint(L, 1, LUA_PROFILER_INTERVAL);
+	LuaProfiler::Start( interval );
+	return 0;
+}
+
+/** \brief Stop sampling the Lua scripts
+ *  \see LuaProfiler
+ */
+int Simulation_Lua::profileStop(lua_State *L) {
+	LuaProfiler::Stop();
+	return 0;
+}
+
+/** \brief Write the Lua profile as collapsed stacks
+ *  \param[in] (Optional) The file to write, "lua-profile.folded" by default.
+ *  \details The file is written where Filesystem::WritablePath puts it.
+ *  \returns One string per line of the summary, for the console
+ *  \see LuaProfiler
+ */
+int Simulation_Lua::profileDump(lua_State *L) {
+	string filename = Filesystem::WritablePath( luaL_optstring(L, 1, "lua-profile.folded") );
+	list<string> summary;
+	if( !LuaProfiler::Dump( filename, summary ) ) {
+		return luaL_error(L, "Could not write '%s'", filename.c_str() );
+	}
+	luaL_checkstack(L, summary.size(), "Too many lines in the profile summary");
+	for( list<string>::iterator line = summary.begin(); line != summary.end(); ++line ) {
+		lua_pushstring(L, line->c_str() );
+	}
+	return summary.size();
+}
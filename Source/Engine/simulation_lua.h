@@ -14,6 +14,17 @@
 #include "Sprites/sprite.h"
 #include "Engine/simulation.h"
 
+#define EPIAR_SPRITE_CACHE "Epiar.SpriteCache" ///< The registry key of the table of Sprite userdata.
+#define EPIAR_PERCEPTION "Epiar.Perception" ///< The registry key of the table that Epiar.perceive fills.
+
+/**\brief The userdata that Lua holds for a Ship or Planet.
+ * \details The ID comes first so that the userdata can still be read as an int.
+ */
+struct SpriteHandle {
+	int id;         ///< The ID of the Sprite.
+	Sprite *sprite; ///< The Sprite, or NULL once it has been deleted.
+};
+
 class Simulation_Lua{
 	public:
 		static void RegisterSimulation(lua_State *L);
@@ -58,6 +69,7 @@ class Simulation_Lua{
 		static int getShips(lua_State *L);
 		static int getPlanets(lua_State *L);
 		static int getGates(lua_State *L);
+		static int perceive(lua_State *L);
 
 		// Game Components
 		static int getCommodityNames(lua_State *L);
@@ -87,9 +99,18 @@ class Simulation_Lua{
 		static int saveComponents(lua_State *L);
 		static int listImages(lua_State *L);
 
+		// Debugging Interfaces
+		static int luaGC(lua_State *L);
+		static int profileStart(lua_State *L);
+		static int profileStop(lua_State *L);
+		static int profileDump(lua_State *L);
+
 		static void pushSprite(lua_State *L,Sprite* sprite);
+		static void forgetSprite(lua_State *L,Sprite* sprite);
 		static void pushComponents(lua_State *L, list<Component*> *components);
 	private:
+		static void pushSpriteCache(lua_State *L);
+		static void pushPerception(lua_State *L);
 };
 
 #endif // __H_SIMULATION_LUA__
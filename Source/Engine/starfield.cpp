@@ -14,30 +14,40 @@
 /**\class Starfield
  * \brief Controls the starfield. */
 
-/**\struct Starfield::_stars
- * \brief Contains x,y coordinate as well as the color
- */
-
 /**\brief Initializes the starfield.
  * \param num Number of stars to initialize
+ * \param layers Number of parallax layers.  With one layer every star moves
+ *  at a speed that matches its brightness, otherwise the stars of each layer
+ *  move together and the nearer layers are brighter.
  */
-Starfield::Starfield( int num ) {
+Starfield::Starfield( int num, int layers ) {
 	int i;
 	
 	// seed the random number generator
 	srand(static_cast<unsigned int>( time(NULL) ));
 
 	// allocate space for stars
-	stars = (struct _stars *)malloc( sizeof(struct _stars) * num );
+	x.resize( num );
+	y.resize( num );
+	brightness.resize( num );
+	speed.resize( num );
+	points.resize( num * 4 * 2 );
+	colors.resize( num * 4 * 3 );
 
 	// randomly assign position and color
 	for( i = 0; i < num; i++ ) {
 		int c;
 
-		stars[i].x = (float)(rand() % (int)(1.3 * Video::GetWidth()));
-		stars[i].y = (float)(rand() % (int)(1.4 * Video::GetHeight()));
+		x[i] = (float)(rand() % (int)(1.3 * Video::GetWidth()));
+		y[i] = (float)(rand() % (int)(1.4 * Video::GetHeight()));
 		c = rand() % 225; // generate greys between 0 and 225
-		stars[i].clr = static_cast<float>( c / 256. );
+		if( layers > 1 ) {
+			speed[i] = static_cast<float>( (i % layers) + 1 ) / static_cast<float>( layers );
+			brightness[i] = speed[i] * static_cast<float>( (c / 2 + 113) / 256. );
+		} else {
+			brightness[i] = static_cast<float>( c / 256. );
+			speed[i] = brightness[i];
+		}
 	}
 
 	this->num = num;
@@ -46,17 +56,52 @@ Starfield::Starfield( int num ) {
 /**\brief Destroys Starfield
  */
 Starfield::~Starfield( void ) {
-	free( stars );
 }
 
 /**\brief Draws the Starfield
+ * \details Each star is spread over the four pixels around it, weighted by
+ *  where it falls between them, so that slow stars don't jump from pixel to
+ *  pixel.  All of the pixels are drawn with a single vertex array call.
  */
 void Starfield::Draw( void ) {
 	int i;
+	GLfloat *point, *color;
+
+	if( num <= 0 ) {
+		return;
+	}
 
+	point = &points[0];
+	color = &colors[0];
 	for( i = 0; i < num; i++ ) {
-		drawStar(stars[i].x, stars[i].y, stars[i].clr);
+		float px = floorf( x[i] );
+		float py = floorf( y[i] );
+		float fx = ( x[i] - px ) * .5f;
+		float fy = ( y[i] - py ) * .5f;
+		float b = brightness[i];
+
+		// The pixel centers of the star's pixel and its left, upper and upper-left neighbours
+		float weights[4] = { fx + fy, (.5f - fx) + fy, fx + (.5f - fy), (.5f - fx) + (.5f - fy) };
+		for( int corner = 0; corner < 4; corner++ ) {
+			*point++ = px - (corner & 1) + .5f;
+			*point++ = py - (corner >> 1) + .5f;
+			*color++ = weights[corner] * b;
+			*color++ = weights[corner] * b;
+			*color++ = weights[corner] * b;
+		}
 	}
+
+	glDisable(GL_TEXTURE_2D);
+	glPointSize( 1.f );
+	glEnableClientState( GL_VERTEX_ARRAY );
+	glEnableClientState( GL_COLOR_ARRAY );
+	glVertexPointer( 2, GL_FLOAT, 0, &points[0] );
+	glColorPointer( 3, GL_FLOAT, 0, &colors[0] );
+
+	glDrawArrays( GL_POINTS, 0, num * 4 );
+
+	glDisableClientState( GL_COLOR_ARRAY );
+	glDisableClientState( GL_VERTEX_ARRAY );
 }
 
 /**\brief Updates the Starfield
@@ -64,66 +109,34 @@ void Starfield::Draw( void ) {
 void Starfield::Update( Camera *camera ) {
 	int i;
 	double dx, dy;
-	float w, h;
+	float w, h, invw, invh;
+	float fdx, fdy;
+	float *sx, *sy;
+	const float *sspeed;
+
+	if( num <= 0 ) {
+		return;
+	}
 
 	camera->GetDelta( &dx, &dy );
+	fdx = static_cast<float>(dx);
+	fdy = static_cast<float>(dy);
 	
 	w = static_cast<float>(1.3 * Video::GetWidth());
 	h = static_cast<float>(1.4 * Video::GetHeight());
-	
+	invw = 1.f / w;
+	invh = 1.f / h;
+
+	sx = &x[0];
+	sy = &y[0];
+	sspeed = &speed[0];
 	for( i = 0; i < num; i++ ) {
-		stars[i].x -= (float)dx * stars[i].clr;
-		stars[i].y -= (float)dy * stars[i].clr;
-
-		// handle wrapping the stars around if they go offscreen top/left
-		while( stars[i].x < 0.0f )
-			stars[i].x += w;
-		while( stars[i].y < 0.0f )
-			stars[i].y += h;
-
-		// handle wrapping the stars around if they go offscreen bottom/right
-		while( stars[i].x > w )
-			stars[i].x -= w;
-		while( stars[i].y > h )
-			stars[i].y -= h;
-	}
-}
+		float nx = sx[i] - fdx * sspeed[i];
+		float ny = sy[i] - fdy * sspeed[i];
 
-/**\brief Draws the stars
- */
-void Starfield::drawStar(float x, float y, float  brightness) 
-{	
-	float drawBrightness;  
-	float xcomponent; 
-	float ycomponent; 
-
-	//Loop between both X columns 
-	for (int xcnt = 0; xcnt <= 1; xcnt++) 
-	{ 
-		//Check for clipping in the X direction (make sure it fits horizontally) 
-		if (((int)x - xcnt)>= 0 && ((int)y - xcnt) < Video::GetWidth()) 
-		{ 
-			//Loop between both Y rows 
-			for (int ycnt = 0; ycnt <= 1; ycnt++) 
-			{ 
-				//Check for clipping in the Y direction (make sure it fits vertically) 
-				if ((int)y - ycnt >= 0 && (int)y - ycnt < Video::GetHeight()) 
-				{ 
-					//Get the x component of the brightness and divide it by 2 
-					xcomponent = (((float)(xcnt - (x - (int)x)) * .5f)); 
-					
-					//Get the y component of the brightness and divide it by 2 
-					ycomponent = (((float)(ycnt - (y - (int)y)) * .5f)); 
-
-					if (ycomponent<0) ycomponent=ycomponent*(-1);
-					if (xcomponent<0) xcomponent=xcomponent*(-1);
-					
-					//Add the x anid y components of the brightness to get the total brightness at that particular location 
-					drawBrightness = ((xcomponent + ycomponent) * brightness); 
-
-					Video::DrawPoint((int)x - xcnt, (int)y - ycnt, drawBrightness, drawBrightness, drawBrightness); 
-				} 
-			} 
-		} 
-	} 
+		// wrap the stars around when they go offscreen without branching,
+		//  so that the compiler is free to vectorize this loop
+		sx[i] = nx - w * floorf( nx * invw );
+		sy[i] = ny - h * floorf( ny * invh );
+	}
 }
@@ -13,21 +13,23 @@
 
 class Starfield {
 	public:
-		Starfield( int num );
+		Starfield( int num, int layers = 1 );
 		~Starfield( void );
 
 		void Draw( void );
 		void Update( Camera *camera );
-		void drawStar( float x, float y, float brightness);
 
 	private:
-		struct _stars {
-			float x, y;
-			float clr;
-		} *stars;
+		// Each star is stored across these arrays so that Update can work on them in bulk
+		vector<float> x, y;
+		vector<float> brightness;
+		vector<float> speed; // how far the star moves for each pixel the camera moves
+
+		// Reused every frame to draw the stars with one call
+		vector<GLfloat> points;
+		vector<GLfloat> colors;
 
 		int num; // number of stars
 };
 
 #endif // __h_starfield__
-
@@ -8,6 +8,7 @@
 
 #include "includes.h"
 #include "Graphics/animation.h"
+#include "Utilities/assetloader.h"
 #include "Utilities/file.h"
 #include "Utilities/log.h"
 #include "Utilities/resource.h"
@@ -46,10 +47,13 @@
  */
 Ani* Ani::Get( string filename ) {
 	Ani* value;
-	value = (Ani*)Resource::Get(filename);
+	value = (Ani*)Resource::Get(RESOURCE_ANIMATION,filename);
+	if( value == NULL && AssetLoader::Claim(RESOURCE_ANIMATION,filename) ) {
+		value = (Ani*)Resource::Get(RESOURCE_ANIMATION,filename);
+	}
 	if( value == NULL ) {
 		value = new Ani(filename);
-		Resource::Store(filename,(Resource*)value);
+		Resource::Store(RESOURCE_ANIMATION,filename,(Resource*)value);
 	}
 	return value;
 }
@@ -80,7 +84,62 @@ Ani::Ani( string& filename ) {
  * \param filename File name of the animation
  */
 bool Ani::Load( string& filename ) {
+	vector<SDL_Surface*> surfaces;
+	vector<CachedImage> cached;
+	Uint32 fileDelay;
+
+	if( !Decode( filename, fileDelay, surfaces, cached ) ) {
+		return( false );
+	}
+	return Load( filename, fileDelay, surfaces, cached );
+}
+
+/**\brief Loads the frames that Ani::Decode returned.
+ * \param filename File name of the animation
+ * \param _delay Animation delay
+ * \param surfaces The decoded frames, which are freed, or NULL for frames that were cached.
+ * \param cached The frames that were found in the ImageCache.
+ */
+bool Ani::Load( const string& filename, Uint32 _delay, vector<SDL_Surface*> &surfaces, vector<CachedImage> &cached ) {
+	assert( !surfaces.empty() );
+	assert( surfaces.size() == cached.size() );
+
+	numFrames = surfaces.size();
+	delay = _delay;
+	// Allocate space for frames
+	frames = new Image[numFrames];
+
+	for( int i = 0; i < numFrames; i++ ) {
+		if( surfaces[i] == NULL ) {
+			frames[i].Load( cached[i] );
+		} else {
+			ImageCache::Add( ImageCache::FrameKey( filename, i ), surfaces[i], filename );
+			frames[i].Load( surfaces[i] );
+		}
+	}
+	surfaces.clear();
+	cached.clear();
+
+	w = frames[0].GetWidth();
+	h = frames[0].GetHeight();
+
+	//LogMsg(INFO, "Animation loading done." );
+
+	return( true );
+}
+
+/**\brief Reads and decodes the frames of an animation file.
+ * \details This doesn't touch OpenGL, so the AssetLoader calls it from its
+ * worker threads.
+ * \param filename File name of the animation
+ * \param delay [out] Animation delay
+ * \param surfaces [out] The decoded frames, in order, or NULL for frames that are in the ImageCache.
+ * \param cached [out] The frames that are in the ImageCache.
+ * \return false if the file is not a valid animation.
+ */
+bool Ani::Decode( const string& filename, Uint32 &delay, vector<SDL_Surface*> &surfaces, vector<CachedImage> &cached ) {
 	char byte;
+	int count;
 	const char *cName = filename.c_str();
 	File file = File( cName );
 
@@ -98,22 +157,18 @@ bool Ani::Load( string& filename ) {
 		LogMsg(ERR, "Cannot have zero or less frames" );
 		return( false );
 	}
-	numFrames = byte;
-	//cout << "\tNum Frames: " << numFrames << endl;
-	// Allocate space for frames
-	frames = new Image[byte];
+	count = byte;
+	//cout << "\tNum Frames: " << count << endl;
 
 	file.Read( 1, &byte );
 	if( byte <= 0 ) {
 		LogMsg(ERR, "Cannot have zero or less for a delay" );
-		delete [] frames;
-		frames = NULL;
 		return( false );
 	}
 	delay = byte;
 	//cout << "\tDelay: " << delay << endl;
 
-	for( int i = 0; i < numFrames; i++ ) {
+	for( int i = 0; i < count; i++ ) {
 		long pos;
 		int fs;
 
@@ -127,26 +182,43 @@ bool Ani::Load( string& filename ) {
 
 		pos = file.Tell();
 
+		// Frames that were decoded on an earlier run are used from the cache
+		CachedImage frame;
+		if( ImageCache::Find( ImageCache::FrameKey( filename, i ), &frame, filename ) ) {
+			surfaces.push_back( NULL );
+			cached.push_back( frame );
+			file.Seek( pos + fs );
+			continue;
+		}
+
 		// On OS X 10.6 with SDL_image 1.2.8, the load from fp is broken, so we load it into a buffer ourselves and SDL_image
 		// loads from that correctly. It's an extra step on our part, but performance/functionally they're identical. Hopefully
 		// this gets fixed in a future SDL_image
 		char *buf = new char [fs];
 		file.Read( fs, buf );
 
-		//frames[i].Load( fp, (int)fs );
-		frames[i].Load( buf, fs );
+		SDL_Surface *s = Image::Decode( buf, fs );
 
 		delete [] buf;
 		buf = NULL;
 
+		if( s == NULL ) {
+			LogMsg(ERR, "Could not decode frame %d of '%s'", i, cName );
+			for( unsigned int f = 0; f < surfaces.size(); f++ ) {
+				if( surfaces[f] != NULL ) {
+					SDL_FreeSurface( surfaces[f] );
+				}
+			}
+			surfaces.clear();
+			cached.clear();
+			return( false );
+		}
+		surfaces.push_back( s );
+		cached.push_back( CachedImage() );
+
 		file.Seek( pos + fs );
 	}
 
-	w = frames[0].GetWidth();
-	h = frames[0].GetHeight();
-
-	//LogMsg(INFO, "Animation loading done." );
-
 	return( true );
 }
 
@@ -206,6 +278,16 @@ Animation::Animation( string filename ) {
 	ani = Ani::Get( filename );
 }
 
+/**\brief Constructor (based on an Ani that has already been loaded).
+ * \param _ani The frames to play.
+ */
+Animation::Animation( Ani *_ani ) {
+	fnum=0;
+	startTime = 0;
+	loopPercent = 0.0f;
+	ani = _ani;
+}
+
 /**\brief Returns true while animation is still playing.
  * \details
  * false when animation is over
@@ -10,6 +10,7 @@
 #define __h_animation__
 
 #include "Graphics/image.h"
+#include "Graphics/imagecache.h"
 #include "Utilities/resource.h"
 #include "includes.h"
 
@@ -18,6 +19,8 @@ class Ani: public Resource {
 		Ani();
 		Ani( string& filename );
 		bool Load( string& filename );
+		bool Load( const string& filename, Uint32 _delay, vector<SDL_Surface*> &surfaces, vector<CachedImage> &cached );
+		static bool Decode( const string& filename, Uint32 &delay, vector<SDL_Surface*> &surfaces, vector<CachedImage> &cached );
 		static Ani* Get(string filename);
 
 		Image* GetFrame(int frameNum);
@@ -37,6 +40,7 @@ class Animation {
 	public:
 		Animation();
 		Animation( string filename );
+		Animation( Ani *_ani );
 		bool Update( void );
 		void Draw( int x, int y, float ang );
 		void SetLoopPercent( float loopPercent );
@@ -0,0 +1,129 @@
+/**\file			atlas.cpp
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Packs small Images into shared textures
+ * \details
+ */
+
+#include "includes.h"
+#include "Graphics/atlas.h"
+#include "Utilities/log.h"
+
+/**\class Atlas
+ * \brief A large texture that many small Images share.
+ * \details Images are placed left to right along horizontal shelves.  A new
+ *  shelf starts under the tallest Image of the current one when the row is
+ *  full, and a new Atlas is created when every Atlas is full.  Space is never
+ *  reclaimed, since Images are Resources that live until the game exits, and
+ *  the atlas textures go away with the OpenGL context.
+ *
+ *  Sharing a texture is what lets the SpriteBatch draw many different Sprites
+ *  with a single call.
+ *  \see SpriteBatch, Image
+ */
+
+vector<Atlas*> Atlas::atlases;
+
+/**\brief Creates an empty, transparent atlas texture.
+ */
+Atlas::Atlas() {
+	vector<unsigned char> clear( ATLAS_SIZE * ATLAS_SIZE * 4, 0 );
+
+	shelfX = shelfY = shelfHeight = 0;
+
+	glGenTextures( 1, &texture );
+	glBindTexture( GL_TEXTURE_2D, texture );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, ATLAS_SIZE, ATLAS_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, &clear[0] );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+
+	LogMsg(INFO, "Created texture atlas %d (%dx%d).", (int)atlases.size() + 1, ATLAS_SIZE, ATLAS_SIZE );
+}
+
+/**\brief Copies a surface into this atlas if there is room.
+ * \param s A 32 bit RGBA surface.
+ * \param x [out] The left edge of the Image in the atlas.
+ * \param y [out] The top edge of the Image in the atlas.
+ * \return false when this atlas is full.
+ */
+bool Atlas::Insert( SDL_Surface *s, int *x, int *y ) {
+	int w = s->w + ATLAS_PADDING;
+	int h = s->h + ATLAS_PADDING;
+
+	// Start a new shelf when this row is full
+	if( shelfX + w > ATLAS_SIZE ) {
+		shelfY += shelfHeight;
+		shelfX = 0;
+		shelfHeight = 0;
+	}
+	if( shelfY + h > ATLAS_SIZE ) {
+		return false;
+	}
+
+	*x = shelfX;
+	*y = shelfY;
+	shelfX += w;
+	if( h > shelfHeight ) shelfHeight = h;
+
+	glBindTexture( GL_TEXTURE_2D, texture );
+	glPixelStorei( GL_UNPACK_ROW_LENGTH, s->pitch / 4 );
+	glTexSubImage2D( GL_TEXTURE_2D, 0, *x, *y, s->w, s->h, GL_RGBA, GL_UNSIGNED_BYTE, s->pixels );
+	glPixelStorei( GL_UNPACK_ROW_LENGTH, 0 );
+	glBindTexture( GL_TEXTURE_2D, 0 );
+	return true;
+}
+
+/**\brief Packs a small surface into an atlas.
+ * \param s The surface to copy.  It is not freed.
+ * \param texture [out] The atlas texture that now holds the surface.
+ * \param u0 [out] Left texture coordinate.
+ * \param v0 [out] Top texture coordinate.
+ * \param u1 [out] Right texture coordinate.
+ * \param v1 [out] Bottom texture coordinate.
+ * \return false when the surface is too large to share a texture.
+ */
+bool Atlas::Pack( SDL_Surface *s, GLuint *texture, float *u0, float *v0, float *u1, float *v1 ) {
+	SDL_Surface *rgba;
+	Atlas *atlas = NULL;
+	int x = 0, y = 0;
+
+	if( s->w > ATLAS_MAX_IMAGE || s->h > ATLAS_MAX_IMAGE ) {
+		return false;
+	}
+
+	// Every atlas is RGBA, so convert whatever format the file was in
+	rgba = SDL_CreateRGBSurface( SDL_SWSURFACE, s->w, s->h, 32, ATLAS_RMASK, ATLAS_GMASK, ATLAS_BMASK, ATLAS_AMASK );
+	if( rgba == NULL ) {
+		LogMsg(WARN, "Could not convert an Image for the texture atlas: %s", SDL_GetError() );
+		return false;
+	}
+	SDL_SetAlpha( s, 0, SDL_ALPHA_OPAQUE ); // Copy the alpha channel rather than blending with it
+	SDL_BlitSurface( s, NULL, rgba, NULL );
+
+	// Earlier atlases may still have room for small Images
+	for( vector<Atlas*>::iterator i = atlases.begin(); i != atlases.end(); ++i ) {
+		if( (*i)->Insert( rgba, &x, &y ) ) {
+			atlas = *i;
+			break;
+		}
+	}
+	if( atlas == NULL ) {
+		atlas = new Atlas();
+		atlases.push_back( atlas );
+		if( !atlas->Insert( rgba, &x, &y ) ) {
+			SDL_FreeSurface( rgba );
+			return false;
+		}
+	}
+
+	*texture = atlas->texture;
+	*u0 = float(x) / float(ATLAS_SIZE);
+	*v0 = float(y) / float(ATLAS_SIZE);
+	*u1 = float(x + rgba->w) / float(ATLAS_SIZE);
+	*v1 = float(y + rgba->h) / float(ATLAS_SIZE);
+
+	SDL_FreeSurface( rgba );
+	return true;
+}
@@ -0,0 +1,47 @@
+/**\file			atlas.h
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Packs small Images into shared textures
+ * \details
+ */
+
+#ifndef __H_ATLAS__
+#define __H_ATLAS__
+
+#include "includes.h"
+
+#define ATLAS_SIZE 1024      ///< Width and height of every atlas texture.
+#define ATLAS_MAX_IMAGE 256  ///< Images wider or taller than this keep their own texture.
+#define ATLAS_PADDING 2      ///< Transparent pixels between packed Images so that filtering doesn't bleed.
+
+// Masks of a 32 bit surface whose bytes are in GL_RGBA order
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	#define ATLAS_RMASK 0xff000000
+	#define ATLAS_GMASK 0x00ff0000
+	#define ATLAS_BMASK 0x0000ff00
+	#define ATLAS_AMASK 0x000000ff
+#else
+	#define ATLAS_RMASK 0x000000ff
+	#define ATLAS_GMASK 0x0000ff00
+	#define ATLAS_BMASK 0x00ff0000
+	#define ATLAS_AMASK 0xff000000
+#endif
+
+class Atlas {
+	public:
+		static bool Pack( SDL_Surface *s, GLuint *texture, float *u0, float *v0, float *u1, float *v1 );
+		static int GetNumAtlases( void ) { return atlases.size(); }
+
+	private:
+		Atlas();
+		bool Insert( SDL_Surface *s, int *x, int *y );
+
+		GLuint texture;
+		int shelfX, shelfY;  ///< Where the next Image goes on the current shelf.
+		int shelfHeight;     ///< The tallest Image on the current shelf.
+
+		static vector<Atlas*> atlases;
+};
+
+#endif // __H_ATLAS__
@@ -34,11 +34,11 @@ Font::Font( string filename ):r(1.f),g(1.f),b(1.f),a(1.f),font(NULL) {
  */
 Font* Font::Get( string filename ) {
 	Font* value;
-	value = static_cast<Font*>(Resource::Get(filename));
+	value = static_cast<Font*>(Resource::Get(RESOURCE_FONT,filename));
 	if( value == NULL ) {
 		value = new Font();
 		if(value->Load(filename)){
-			Resource::Store(filename,(Resource*)value);
+			Resource::Store(RESOURCE_FONT,filename,(Resource*)value);
 		} else {
 			LogMsg(DEBUG1,"Couldn't Find Font '%s'",filename.c_str());
 			delete value;
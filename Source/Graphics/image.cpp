@@ -11,7 +11,11 @@
 
 #include "includes.h"
 #include "Graphics/image.h"
+#include "Graphics/atlas.h"
+#include "Graphics/imagecache.h"
+#include "Graphics/spritebatch.h"
 #include "Graphics/video.h"
+#include "Utilities/assetloader.h"
 #include "Utilities/file.h"
 #include "Utilities/log.h"
 #include "Utilities/trig.h"
@@ -25,6 +29,9 @@ Image::Image() {
 	// Initialize variables
 	w = h = real_w = real_h = image = 0;
 	scale_w = scale_h = 1.;
+	packed = false;
+	u0 = v0 = 0.;
+	u1 = v1 = 1.;
 	filepath="";
 }
 
@@ -34,6 +41,9 @@ Image::Image( const string& filename ) {
 	// Initialize variables
 	w = h = real_w = real_h = image = 0;
 	scale_w = scale_h = 1.;
+	packed = false;
+	u0 = v0 = 0.;
+	u1 = v1 = 1.;
 
 	Load(filename);
 }
@@ -41,7 +51,7 @@ Image::Image( const string& filename ) {
 /**\brief Deallocate allocations
  */
 Image::~Image() {
-	if ( image ) {
+	if ( image && !packed ) {
 		glDeleteTextures( 1, &image );
 		image = 0;
 	}
@@ -51,11 +61,14 @@ Image::~Image() {
  */
 Image* Image::Get( string filename ) {
 	Image* value;
-	value = static_cast<Image*>(Resource::Get(filename));
+	value = static_cast<Image*>(Resource::Get(RESOURCE_IMAGE,filename));
+	if( value == NULL && AssetLoader::Claim(RESOURCE_IMAGE,filename) ) {
+		value = static_cast<Image*>(Resource::Get(RESOURCE_IMAGE,filename));
+	}
 	if( value == NULL ) {
 		value = new Image();
 		if(value->Load(filename)){
-			Resource::Store(filename,(Resource*)value);
+			Resource::Store(RESOURCE_IMAGE,filename,(Resource*)value);
 		} else {
 			LogMsg(DEBUG1,"Couldn't Find Image '%s'",filename.c_str());
 			delete value;
@@ -65,9 +78,22 @@ Image* Image::Get( string filename ) {
 	return value;
 }
 
+/**\brief Stores an Image under another name, such as the name of a Model.
+ */
+void Image::Store( const string& key, Image* image ) {
+	Resource::Store( RESOURCE_IMAGE, key, (Resource*)image );
+}
+
 /**\brief Load image from file
  */
 bool Image::Load( const string& filename ) {
+	// Images that were decoded on an earlier run don't need to be decoded again
+	CachedImage cached;
+	if( ImageCache::Find( filename, &cached ) && Load( cached ) ) {
+		filepath = filename;
+		return true;
+	}
+
 	File file = File();
 	if( !file.OpenRead(filename ) ) {
 		return NULL; // File could not be opened or found.
@@ -80,11 +106,10 @@ bool Image::Load( const string& filename ) {
 		return NULL; // File could not be Read.
 	}
 
-	int retval = Load( buffer, bytesread );
+	SDL_Surface *s = Decode( buffer, bytesread );
 	delete [] buffer;
-	if ( retval ){
-        filepath=filename;
-		return true;
+	if ( s ){
+		return Load( s, filename );
 	}
 	return NULL; // Image could not be loaded. (It might not be an Image)
 }
@@ -92,13 +117,26 @@ bool Image::Load( const string& filename ) {
 /**\brief Load image from buffer
  */
 bool Image::Load( char *buf, int bufSize ) {
+	SDL_Surface *s = Decode( buf, bufSize );
+	if( !s ) {
+		return( false );
+	}
+	return Load( s );
+}
+
+/**\brief Decode image from buffer
+ * \details This doesn't touch OpenGL, so the AssetLoader calls it from its
+ * worker threads.  Load the surface that it returns on the main thread.
+ * \return The decoded surface, or NULL.
+ */
+SDL_Surface *Image::Decode( char *buf, int bufSize ) {
 	SDL_RWops *rw;
 	SDL_Surface *s = NULL;
 
 	rw = SDL_RWFromMem( buf, bufSize );
 	if( !rw ) {
 		LogMsg(WARN, "Image loading failed. Could not create RWops" );
-		return( false );
+		return( NULL );
 	}
 
 	s = IMG_Load_RW( rw, 0 );
@@ -106,18 +144,73 @@ bool Image::Load( char *buf, int bufSize ) {
 
 	if( !s ) {
 		LogMsg(WARN, "Image loading failed. Could not load image from RWops" );
-		return( false );
+		return( NULL );
 	}
 
+	return( s );
+}
+
+/**\brief Load image from a decoded surface. Will free 's'.
+ * \param s A surface from Image::Decode
+ * \param filename Where the surface came from, if anywhere.
+ */
+bool Image::Load( SDL_Surface *s, const string& filename ) {
+	assert(s);
+
 	w = s->w;
 	h = s->h;
 
+	if( filename != "" ) {
+		ImageCache::Add( filename, s );
+	}
+
 	if( ConvertToTexture( s ) == false ) {
 		LogMsg(WARN, "Failed to load image from buffer" );
 		SDL_FreeSurface( s );
 		return( false );
 	}
 
+	if( filename != "" ) {
+		filepath = filename;
+	}
+	return( true );
+}
+
+/**\brief Load image from the pixels in the ImageCache
+ * \details The pixels are already RGBA and expanded to a power of two, so
+ * they go to OpenGL without being copied.
+ */
+bool Image::Load( const CachedImage &cached ) {
+	w = cached.w;
+	h = cached.h;
+
+	// Small images share an atlas texture so that they can be batched together
+	SDL_Surface *view = SDL_CreateRGBSurfaceFrom( (void*)cached.pixels, w, h, 32, cached.realW * 4,
+	                                              ATLAS_RMASK, ATLAS_GMASK, ATLAS_BMASK, ATLAS_AMASK );
+	if( view != NULL ) {
+		bool fits = Atlas::Pack( view, &image, &u0, &v0, &u1, &v1 );
+		SDL_FreeSurface( view );
+		if( fits ) {
+			packed = true;
+			real_w = w;
+			real_h = h;
+			return( true );
+		}
+	}
+
+	real_w = cached.realW;
+	real_h = cached.realH;
+	scale_w = (float)w / (float)real_w;
+	scale_h = (float)h / (float)real_h;
+	u0 = v0 = 0.;
+	u1 = scale_w;
+	v1 = scale_h;
+
+	glGenTextures( 1, &image );
+	glBindTexture( GL_TEXTURE_2D, (unsigned int)image );
+	glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, real_w, real_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, cached.pixels );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
 
 	return( true );
 }
@@ -146,13 +239,6 @@ void Image::_Draw( int x, int y, float r, float g, float b, float alpha, float a
 		return;
 	}
 
-	glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // Clear The Background Color To Black
-	glClearDepth(1.0); // Enables Clearing Of The Depth Buffer
-	glShadeModel(GL_SMOOTH); // Enables Smooth Color Shading
-	glEnable(GL_TEXTURE_2D); // Enable 2D Texture Mapping
- 	glEnable(GL_BLEND);
-	glDisable(GL_DEPTH_TEST);
-
 	// calculate the coordinates of the quad	
 	// avoid trig when you can
 	if( angle != 0.f ) {
@@ -177,6 +263,29 @@ void Image::_Draw( int x, int y, float r, float g, float b, float alpha, float a
 		lry = static_cast<float>(y);
 	}
 
+	// the deltas are the differences needed in width, e.g. a resize_ratio_w of 1.1 would produce a value
+	// equal to the original width of the image but adding 10%. 0.9 would then be 10% smaller, etc.
+	float resize_w_delta = (w * resize_ratio_w) - w;
+	float resize_h_delta = (h * resize_ratio_h) - h;
+
+	// While a SpriteBatch is open, the quad is drawn later with its neighbours
+	if( SpriteBatch::IsBatching() ) {
+		GLfloat corners[8] = {
+			llx, lly,
+			lrx + resize_w_delta, lry,
+			urx + resize_w_delta, ury + resize_h_delta,
+			ulx, uly + resize_h_delta };
+		SpriteBatch::Add( image, corners, u0, v0, u1, v1, r, g, b, alpha );
+		return;
+	}
+
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // Clear The Background Color To Black
+	glClearDepth(1.0); // Enables Clearing Of The Depth Buffer
+	glShadeModel(GL_SMOOTH); // Enables Smooth Color Shading
+	glEnable(GL_TEXTURE_2D); // Enable 2D Texture Mapping
+ 	glEnable(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+
 	// draw!
 	glColor4f(r, g, b, alpha);
 	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
@@ -185,17 +294,12 @@ void Image::_Draw( int x, int y, float r, float g, float b, float alpha, float a
 	glBindTexture( GL_TEXTURE_2D, image );
 
 	glPushMatrix();
-	
-	// the deltas are the differences needed in width, e.g. a resize_ratio_w of 1.1 would produce a value
-	// equal to the original width of the image but adding 10%. 0.9 would then be 10% smaller, etc.
-	float resize_w_delta = (w * resize_ratio_w) - w;
-	float resize_h_delta = (h * resize_ratio_h) - h;
 
 	glBegin( GL_QUADS );
-	glTexCoord2f( 0., 0. ); glVertex2f( llx, lly );
-	glTexCoord2f( scale_w, 0. ); glVertex2f( lrx + resize_w_delta, lry );
-	glTexCoord2f( scale_w, scale_h ); glVertex2f( urx + resize_w_delta, ury + resize_h_delta );
-	glTexCoord2f( 0., scale_h ); glVertex2f( ulx, uly + resize_h_delta );
+	glTexCoord2f( u0, v0 ); glVertex2f( llx, lly );
+	glTexCoord2f( u1, v0 ); glVertex2f( lrx + resize_w_delta, lry );
+	glTexCoord2f( u1, v1 ); glVertex2f( urx + resize_w_delta, ury + resize_h_delta );
+	glTexCoord2f( u0, v1 ); glVertex2f( ulx, uly + resize_h_delta );
 	glEnd();
 
 	glPopMatrix();
@@ -261,12 +365,24 @@ bool Image::ConvertToTexture( SDL_Surface *s ) {
 
 	// delete an old loaded image if one eixsts
 	if( image ) {
-		glDeleteTextures( 1, &image );
+		if( !packed ) {
+			glDeleteTextures( 1, &image );
+		}
 		image = 0;
+		packed = false;
 
 		LogMsg(WARN, "Loading an image after another is loaded already. Deleting old ... " );
 	}
 
+	// Small images share an atlas texture so that they can be batched together
+	if( Atlas::Pack( s, &image, &u0, &v0, &u1, &v1 ) ) {
+		packed = true;
+		real_w = s->w;
+		real_h = s->h;
+		SDL_FreeSurface( s );
+		return( true );
+	}
+
 	// Check to see if we need to expand the image
 	int expanded_w = PowerOfTwo(s->w);
 	int expanded_h = PowerOfTwo(s->h);
@@ -284,6 +400,9 @@ bool Image::ConvertToTexture( SDL_Surface *s ) {
 	// real width/height always equal the expanded canvas (or original canvas if no expansion)'s w/h
 	real_w = s->w;
 	real_h = s->h;
+	u0 = v0 = 0.;
+	u1 = scale_w;
+	v1 = scale_h;
 
 	// check the pixel format, since it could depend on the file format:
 	GLenum internal_format;
@@ -343,6 +462,9 @@ void Image::DrawTiled( int x, int y, int fill_w, int fill_h, float alpha ) {
 		return;
 	}
 
+	// Tiles are cropped, so they can't join a batch
+	SpriteBatch::Flush();
+
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // Clear The Background Color To Black
 	glClearDepth(1.0); // Enables Clearing Of The Depth Buffer
 	glShadeModel(GL_SMOOTH); // Enables Smooth Color Shading
@@ -364,10 +486,10 @@ void Image::DrawTiled( int x, int y, int fill_w, int fill_h, float alpha ) {
 	glBegin( GL_QUADS );
 	for( int j = 0; j < fill_h; j += h) {
 		for( int i = 0; i < fill_w; i += w) {
-			glTexCoord2f( 0., 0. ); glVertex2f( static_cast<GLfloat>(x+i), static_cast<GLfloat>(y+j) ); // Lower Left
-			glTexCoord2f( scale_w, 0. ); glVertex2f( static_cast<GLfloat>(x+w+i) , static_cast<GLfloat>(y+j)); // Lower Right
-			glTexCoord2f( scale_w, scale_h ); glVertex2f( static_cast<GLfloat>(x+w+i) , static_cast<GLfloat>(y+h+j) ); // Upper Right
-			glTexCoord2f( 0., scale_h ); glVertex2f( static_cast<GLfloat>(x+i), static_cast<GLfloat>(y+h+j) ); // Upper Left
+			glTexCoord2f( u0, v0 ); glVertex2f( static_cast<GLfloat>(x+i), static_cast<GLfloat>(y+j) ); // Lower Left
+			glTexCoord2f( u1, v0 ); glVertex2f( static_cast<GLfloat>(x+w+i) , static_cast<GLfloat>(y+j)); // Lower Right
+			glTexCoord2f( u1, v1 ); glVertex2f( static_cast<GLfloat>(x+w+i) , static_cast<GLfloat>(y+h+j) ); // Upper Right
+			glTexCoord2f( u0, v1 ); glVertex2f( static_cast<GLfloat>(x+i), static_cast<GLfloat>(y+h+j) ); // Upper Left
 		}
 	}
 	glEnd();
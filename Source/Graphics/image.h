@@ -22,6 +22,8 @@
 #include "includes.h"
 #include "Utilities/resource.h"
 
+struct CachedImage;
+
 class Image : public Resource {
 	public:
 		Image();
@@ -30,11 +32,18 @@ class Image : public Resource {
 		~Image();
 
 		static Image* Get(string filename);
+		static void Store( const string& key, Image* image );
 
 		// Load image from file
 		bool Load( const string& filename );
 		// Load image from buffer
 		bool Load( char *buf, int bufSize );
+		// Load image from a decoded surface (frees 's')
+		bool Load( SDL_Surface *s, const string& filename = "" );
+		// Load image from the pixels in the ImageCache
+		bool Load( const CachedImage &cached );
+		// Decode image from buffer without touching OpenGL, so that it can be done on any thread
+		static SDL_Surface *Decode( char *buf, int bufSize );
 
 		// Get information about image dimensions (always the virtual/effective size)
 		int GetWidth( void ) { return w; };
@@ -77,6 +86,8 @@ class Image : public Resource {
 		                        // defaults = 1.0, this factor is always used, so non-expanded images are
 		                        // simply "scaled" at 1.0. THIS HAS NOTHING TO DO WITH RESIZE()
 		GLuint image; // OpenGL pointer to texture
+		bool packed; // true when image is a shared Atlas texture that this Image must not delete
+		float u0, v0, u1, v1; // where this Image is within the texture
 		string filepath;
 };
 
@@ -0,0 +1,358 @@
+/**\file			imagecache.cpp
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Keeps decoded Images in a file that is mapped into memory
+ * \details
+ */
+
+#include "includes.h"
+#include "common.h"
+#include "Graphics/imagecache.h"
+#include "Graphics/atlas.h"
+#include "Utilities/file.h"
+#include "Utilities/log.h"
+#include "Utilities/resource.h"
+
+/**\class ImageCache
+ * \brief A file of Images that have already been decoded.
+ * \details
+ * Decoding a PNG and expanding it to a power of two takes far longer than
+ * uploading the pixels, and the same files are decoded on every launch.  The
+ * cache file holds the expanded RGBA pixels of every Image that has been
+ * loaded from a file before, so Image::Load can hand them straight to OpenGL
+ * from the mapped file without decoding or copying anything.
+ *
+ * The file is a header, a hashed index of ImageCacheEntry slots (linear
+ * probing on the hash of the path), the paths, and then the blocks of pixels.
+ * An entry is only used while the source file has the same modification time
+ * and size as when it was cached.
+ *
+ * The frames of an Ani are cached under FrameKey, and checked against the
+ * .ani file that they came from.
+ *
+ * Images that are decoded during a run are added to the file by Close, so
+ * the first run bakes the cache and later runs use it.  The file is written
+ * next to the old one and then renamed over it.
+ *
+ * Find may be called from the AssetLoader's worker threads, since the
+ * mapping doesn't change between Open and Close.  Add may not.
+ *
+ * "options/video/image-cache" names the file, which is kept where
+ * Filesystem::WritablePath puts it.  When it is empty, nothing is cached.
+ */
+
+string ImageCache::filename = "";
+const unsigned char *ImageCache::mapping = NULL;
+long ImageCache::mappingSize = 0;
+map<string,ImageCache::BakedImage> ImageCache::added;
+MappedFile ImageCache::cacheFile;
+
+/**\brief Hashes a path for the index (Internal use)
+ * \details 0 marks an empty slot, so it is never returned.
+ */
+static Uint32 HashPath( const string& path ) {
+	Uint32 hash = ResourcePath( path ).hash();
+	return ( hash == 0 ) ? 1 : hash;
+}
+
+/**\brief The next power of two, and at least 2 (Internal use)
+ * \details This matches the canvas that Image::ConvertToTexture expands to.
+ */
+static int ExpandedSize( int num ) {
+	int c = 2;
+	while( c < num ) c *= 2;
+	return c;
+}
+
+/**\brief Rounds an offset up to the alignment of the pixel blocks (Internal use)
+ */
+static long Align( long offset ) {
+	return ( offset + IMAGE_CACHE_ALIGN - 1 ) & ~(long)( IMAGE_CACHE_ALIGN - 1 );
+}
+
+/**\brief Maps the cache file, if there is one.
+ * \param _filename Where the cache is kept.  Empty to turn the cache off.
+ * \return false if there is no usable cache yet.
+ */
+bool ImageCache::Open( const string& _filename ) {
+	Close();
+	filename = _filename;
+	if( filename == "" ) {
+		return false;
+	}
+	return Map();
+}
+
+/**\brief Writes the Images that were added during this run and unmaps the file.
+ */
+void ImageCache::Close( void ) {
+	if( !added.empty() ) {
+		Save();
+		added.clear();
+	}
+	Unmap();
+}
+
+/**\brief The key of one frame of an Ani.
+ */
+string ImageCache::FrameKey( const string& path, int frame ) {
+	char suffix[16];
+	snprintf( suffix, sizeof(suffix), "#%d", frame );
+	return path + suffix;
+}
+
+/**\brief Finds a cached Image that is still up to date.
+ * \param path The path of the source file, or a FrameKey.
+ * \param image [out] The size and pixels of the Image.
+ * \param source The file that the Image came from, if it isn't path.
+ */
+bool ImageCache::Find( const string& path, CachedImage *image, const string& source ) {
+	long modTime, fileSize;
+	const ImageCacheEntry *entry = Lookup( path );
+	if( entry == NULL ) {
+		return false;
+	}
+
+	// The source file has changed since it was cached
+	if( !File::Stat( (source == "") ? path : source, &modTime, &fileSize ) ) {
+		return false;
+	}
+	if( entry->modTime != (Sint64)modTime || entry->fileSize != (Uint32)fileSize ) {
+		return false;
+	}
+
+	image->w = entry->w;
+	image->h = entry->h;
+	image->realW = entry->realW;
+	image->realH = entry->realH;
+	image->pixels = mapping + entry->pixelOffset;
+	return true;
+}
+
+/**\brief Remembers a decoded Image so that Close can add it to the file.
+ * \param path The path of the source file, or a FrameKey.
+ * \param s The decoded surface.  It is copied, not freed.
+ * \param source The file that the Image came from, if it isn't path.
+ */
+void ImageCache::Add( const string& path, SDL_Surface *s, const string& source ) {
+	long modTime, fileSize;
+	CachedImage cached;
+	if( filename == "" || path == "" ) {
+		return;
+	}
+	if( Find( path, &cached, source ) ) {
+		return;
+	}
+	if( !File::Stat( (source == "") ? path : source, &modTime, &fileSize ) ) {
+		return;
+	}
+
+	BakedImage &baked = added[path];
+	baked.modTime = modTime;
+	baked.fileSize = fileSize;
+	baked.w = s->w;
+	baked.h = s->h;
+	baked.realW = ExpandedSize( s->w );
+	baked.realH = ExpandedSize( s->h );
+
+	SDL_Surface *rgba = SDL_CreateRGBSurface( SDL_SWSURFACE, baked.realW, baked.realH, 32, ATLAS_RMASK, ATLAS_GMASK, ATLAS_BMASK, ATLAS_AMASK );
+	if( rgba == NULL ) {
+		added.erase( path );
+		return;
+	}
+	SDL_SetAlpha( s, 0, SDL_ALPHA_OPAQUE ); // Copy the alpha channel rather than blending with it
+	SDL_BlitSurface( s, NULL, rgba, NULL );
+
+	int rowBytes = baked.realW * 4;
+	baked.pixels.resize( rowBytes * baked.realH );
+	SDL_LockSurface( rgba );
+	for( int y = 0; y < baked.realH; y++ ) {
+		memcpy( &baked.pixels[ y * rowBytes ], (unsigned char*)rgba->pixels + y * rgba->pitch, rowBytes );
+	}
+	SDL_UnlockSurface( rgba );
+	SDL_FreeSurface( rgba );
+}
+
+/**\brief Finds the index slot of a path (Internal use)
+ * \return The slot, or NULL if the path isn't cached.
+ */
+const ImageCacheEntry *ImageCache::Lookup( const string& path ) {
+	if( mapping == NULL ) {
+		return NULL;
+	}
+	const ImageCacheHeader *header = (const ImageCacheHeader*)mapping;
+	const ImageCacheEntry *table = (const ImageCacheEntry*)( mapping + sizeof(ImageCacheHeader) );
+	Uint32 mask = header->tableSize - 1;
+	Uint32 hash = HashPath( path );
+
+	for( Uint32 probe = 0; probe < header->tableSize; probe++ ) {
+		const ImageCacheEntry *entry = &table[ (hash + probe) & mask ];
+		if( entry->hash == 0 ) {
+			return NULL;
+		}
+		if( entry->hash == hash
+		 && entry->pathLength == path.length()
+		 && (long)entry->pathOffset + (long)entry->pathLength <= mappingSize
+		 && memcmp( mapping + entry->pathOffset, path.c_str(), path.length() ) == 0 ) {
+			if( (long)entry->pixelOffset + (long)entry->realW * entry->realH * 4 > mappingSize ) {
+				return NULL; // Truncated
+			}
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/**\brief Writes every Image that is still current to a new cache file (Internal use)
+ */
+bool ImageCache::Save( void ) {
+	vector<string> paths;
+	vector<ImageCacheEntry> entries;
+	vector<const unsigned char*> pixels;
+	map<string,BakedImage>::iterator b;
+	long modTime, fileSize;
+	unsigned int i;
+
+	// Keep the old Images whose files haven't changed
+	if( mapping != NULL ) {
+		const ImageCacheHeader *header = (const ImageCacheHeader*)mapping;
+		const ImageCacheEntry *table = (const ImageCacheEntry*)( mapping + sizeof(ImageCacheHeader) );
+		for( i = 0; i < header->tableSize; i++ ) {
+			if( table[i].hash == 0
+			 || (long)table[i].pathOffset + (long)table[i].pathLength > mappingSize ) {
+				continue;
+			}
+			string path( (const char*)mapping + table[i].pathOffset, table[i].pathLength );
+			if( added.find( path ) != added.end() || Lookup( path ) != &table[i] ) {
+				continue;
+			}
+			string source = path.substr( 0, path.rfind( '#' ) );
+			if( !File::Stat( source, &modTime, &fileSize )
+			 || table[i].modTime != (Sint64)modTime || table[i].fileSize != (Uint32)fileSize ) {
+				continue;
+			}
+			paths.push_back( path );
+			entries.push_back( table[i] );
+			pixels.push_back( mapping + table[i].pixelOffset );
+		}
+	}
+	for( b = added.begin(); b != added.end(); ++b ) {
+		ImageCacheEntry entry;
+		memset( &entry, 0, sizeof(entry) );
+		entry.modTime = b->second.modTime;
+		entry.fileSize = b->second.fileSize;
+		entry.w = b->second.w;
+		entry.h = b->second.h;
+		entry.realW = b->second.realW;
+		entry.realH = b->second.realH;
+		paths.push_back( b->first );
+		entries.push_back( entry );
+		pixels.push_back( &b->second.pixels[0] );
+	}
+
+	// Lay out the file
+	ImageCacheHeader header;
+	header.magic = IMAGE_CACHE_MAGIC;
+	header.version = IMAGE_CACHE_VERSION;
+	header.count = entries.size();
+	header.tableSize = 16;
+	while( header.tableSize < 2 * header.count ) {
+		header.tableSize *= 2;
+	}
+
+	long offset = sizeof(ImageCacheHeader) + header.tableSize * sizeof(ImageCacheEntry);
+	for( i = 0; i < entries.size(); i++ ) {
+		entries[i].hash = HashPath( paths[i] );
+		entries[i].pathOffset = offset;
+		entries[i].pathLength = paths[i].length();
+		offset += paths[i].length();
+	}
+	for( i = 0; i < entries.size(); i++ ) {
+		offset = Align( offset );
+		entries[i].pixelOffset = offset;
+		offset += (long)entries[i].realW * entries[i].realH * 4;
+	}
+
+	vector<ImageCacheEntry> table( header.tableSize );
+	memset( &table[0], 0, header.tableSize * sizeof(ImageCacheEntry) );
+	for( i = 0; i < entries.size(); i++ ) {
+		Uint32 slot = entries[i].hash & (header.tableSize - 1);
+		while( table[slot].hash != 0 ) {
+			slot = (slot + 1) & (header.tableSize - 1);
+		}
+		table[slot] = entries[i];
+	}
+
+	// Write it beside the old file
+	string temporary = filename + ".tmp";
+	FILE *fp = fopen( temporary.c_str(), "wb" );
+	if( fp == NULL ) {
+		LogMsg(WARN, "Could not write the image cache '%s'.", temporary.c_str() );
+		return false;
+	}
+	bool written = ( fwrite( &header, sizeof(header), 1, fp ) == 1 )
+	            && ( fwrite( &table[0], sizeof(ImageCacheEntry), table.size(), fp ) == table.size() );
+	for( i = 0; written && i < entries.size(); i++ ) {
+		written = ( fwrite( paths[i].c_str(), 1, paths[i].length(), fp ) == paths[i].length() );
+	}
+	for( i = 0; written && i < entries.size(); i++ ) {
+		static const char padding[IMAGE_CACHE_ALIGN] = {0};
+		long position = ftell( fp );
+		size_t bytes = (size_t)entries[i].realW * entries[i].realH * 4;
+		written = ( fwrite( padding, 1, entries[i].pixelOffset - position, fp ) == (size_t)(entries[i].pixelOffset - position) )
+		       && ( fwrite( pixels[i], 1, bytes, fp ) == bytes );
+	}
+	if( fclose( fp ) != 0 ) {
+		written = false;
+	}
+	if( !written ) {
+		LogMsg(WARN, "Could not write the image cache '%s'.", temporary.c_str() );
+		remove( temporary.c_str() );
+		return false;
+	}
+
+	// The old file can't be replaced while it is mapped on every platform
+	Unmap();
+	remove( filename.c_str() );
+	if( rename( temporary.c_str(), filename.c_str() ) != 0 ) {
+		LogMsg(WARN, "Could not replace the image cache '%s'.", filename.c_str() );
+		remove( temporary.c_str() );
+		return false;
+	}
+	LogMsg(INFO, "Wrote %d Images to the image cache '%s'.", (int)entries.size(), filename.c_str() );
+	return true;
+}
+
+/**\brief Maps the cache file and checks its header (Internal use)
+ */
+bool ImageCache::Map( void ) {
+	if( !cacheFile.Open( filename ) ) {
+		return false;
+	}
+	mapping = cacheFile.GetData();
+	mappingSize = cacheFile.GetLength();
+
+	const ImageCacheHeader *header = (const ImageCacheHeader*)mapping;
+	if( mappingSize < (long)sizeof(ImageCacheHeader)
+	 || header->magic != IMAGE_CACHE_MAGIC
+	 || header->version != IMAGE_CACHE_VERSION
+	 || header->tableSize == 0
+	 || ( header->tableSize & (header->tableSize - 1) ) != 0
+	 || mappingSize < (long)( sizeof(ImageCacheHeader) + header->tableSize * sizeof(ImageCacheEntry) ) ) {
+		LogMsg(WARN, "Ignoring the image cache '%s', which is from another version.", filename.c_str() );
+		Unmap();
+		return false;
+	}
+
+	LogMsg(INFO, "Using %d cached Images from '%s'.", header->count, filename.c_str() );
+	return true;
+}
+
+/**\brief Unmaps the cache file (Internal use)
+ */
+void ImageCache::Unmap( void ) {
+	cacheFile.Close();
+	mapping = NULL;
+	mappingSize = 0;
+}
@@ -0,0 +1,83 @@
+/**\file			imagecache.h
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Keeps decoded Images in a file that is mapped into memory
+ * \details
+ */
+
+#ifndef __H_IMAGECACHE__
+#define __H_IMAGECACHE__
+
+#include "includes.h"
+#include "Utilities/file.h"
+
+#define IMAGE_CACHE_MAGIC 0x43494945   ///< "EIIC" in the first four bytes of the file.
+#define IMAGE_CACHE_VERSION 1          ///< Files with any other version are ignored.
+#define IMAGE_CACHE_ALIGN 16           ///< Every block of pixels starts on a multiple of this.
+
+/**\brief The start of the cache file.
+ */
+struct ImageCacheHeader {
+	Uint32 magic;
+	Uint32 version;
+	Uint32 tableSize;  ///< Slots in the index, a power of two.
+	Uint32 count;      ///< Images in the file.
+};
+
+/**\brief One slot of the index, which follows the header.
+ * \details Offsets are from the start of the file.
+ */
+struct ImageCacheEntry {
+	Sint64 modTime;      ///< When the source file was last changed.
+	Uint32 hash;         ///< The hash of the path, or 0 for an empty slot.
+	Uint32 fileSize;     ///< Bytes in the source file.
+	Uint32 pathOffset;
+	Uint32 pathLength;
+	Uint32 w, h;         ///< Size of the Image.
+	Uint32 realW, realH; ///< Size of the block of pixels, powers of two.
+	Uint32 pixelOffset;  ///< RGBA pixels with the Image in the top left corner.
+	Uint32 unused;
+};
+
+/**\brief An Image found in the cache.
+ */
+struct CachedImage {
+	int w, h;
+	int realW, realH;
+	const unsigned char *pixels; ///< realW * realH RGBA pixels, inside the mapped file.
+};
+
+class ImageCache {
+	public:
+		static bool Open( const string& filename );
+		static void Close( void );
+
+		static bool Find( const string& path, CachedImage *image, const string& source = "" );
+		static void Add( const string& path, SDL_Surface *s, const string& source = "" );
+		static string FrameKey( const string& path, int frame );
+
+	private:
+		/**\brief An Image decoded during this run that will be written by Close.
+		 */
+		struct BakedImage {
+			long modTime;
+			long fileSize;
+			int w, h;
+			int realW, realH;
+			vector<unsigned char> pixels;
+		};
+
+		static const ImageCacheEntry *Lookup( const string& path );
+		static bool Save( void );
+		static bool Map( void );
+		static void Unmap( void );
+
+		static string filename;
+		static const unsigned char *mapping; ///< The whole file, or NULL.
+		static long mappingSize;
+		static map<string,BakedImage> added; ///< Images that the file doesn't have yet.
+		static MappedFile cacheFile;
+};
+
+#endif // __H_IMAGECACHE__
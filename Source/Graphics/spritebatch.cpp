@@ -0,0 +1,119 @@
+/**\file			spritebatch.cpp
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Draws many textured quads with few draw calls
+ * \details
+ */
+
+#include "includes.h"
+#include "Graphics/spritebatch.h"
+
+/**\class SpriteBatch
+ * \brief Collects Image quads and draws each run that shares a texture at once.
+ * \details Between Begin and End, Images add their quads here instead of
+ *  drawing them.  The quads are kept in the order they were added, so the
+ *  Sprite draw order is preserved; consecutive quads from the same texture
+ *  (usually the same Atlas) become one glDrawArrays call.
+ *
+ *  Only OpenGL 1.1 vertex arrays are used so that this works everywhere,
+ *  including software renderers.
+ *
+ *  Anything that draws without an Image (fonts, lines, circles) in the middle
+ *  of a batch must call Flush first.
+ *  \see Atlas, Image
+ */
+
+bool SpriteBatch::batching = false;
+GLuint SpriteBatch::texture = 0;
+vector<GLfloat> SpriteBatch::vertices;
+vector<GLfloat> SpriteBatch::texCoords;
+vector<GLfloat> SpriteBatch::colors;
+int SpriteBatch::drawCalls = 0;
+int SpriteBatch::quads = 0;
+
+/**\brief Starts collecting quads.
+ */
+void SpriteBatch::Begin( void ) {
+	assert( !batching );
+	batching = true;
+	drawCalls = 0;
+	quads = 0;
+}
+
+/**\brief Draws everything that is left and stops collecting quads.
+ */
+void SpriteBatch::End( void ) {
+	Flush();
+	batching = false;
+}
+
+/**\brief Adds one quad to the batch.
+ * \param _texture The texture to draw from.
+ * \param corners The lower left, lower right, upper right and upper left corners as x,y pairs.
+ * \param u0 Left texture coordinate.
+ * \param v0 Top texture coordinate.
+ * \param u1 Right texture coordinate.
+ * \param v1 Bottom texture coordinate.
+ */
+void SpriteBatch::Add( GLuint _texture, const GLfloat corners[8], float u0, float v0, float u1, float v1, float r, float g, float b, float a ) {
+	if( _texture != texture ) {
+		Flush();
+		texture = _texture;
+	}
+
+	vertices.insert( vertices.end(), corners, corners + 8 );
+
+	texCoords.push_back( u0 ); texCoords.push_back( v0 );
+	texCoords.push_back( u1 ); texCoords.push_back( v0 );
+	texCoords.push_back( u1 ); texCoords.push_back( v1 );
+	texCoords.push_back( u0 ); texCoords.push_back( v1 );
+
+	for( int c = 0; c < 4; c++ ) {
+		colors.push_back( r );
+		colors.push_back( g );
+		colors.push_back( b );
+		colors.push_back( a );
+	}
+	quads++;
+}
+
+/**\brief Draws the quads that have been collected so far.
+ * \details The OpenGL state is left the way Image drawing leaves it.
+ */
+void SpriteBatch::Flush( void ) {
+	if( vertices.empty() ) {
+		return;
+	}
+
+	glEnable(GL_TEXTURE_2D);
+	glEnable(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glBindTexture( GL_TEXTURE_2D, texture );
+
+	glEnableClientState( GL_VERTEX_ARRAY );
+	glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+	glEnableClientState( GL_COLOR_ARRAY );
+	glVertexPointer( 2, GL_FLOAT, 0, &vertices[0] );
+	glTexCoordPointer( 2, GL_FLOAT, 0, &texCoords[0] );
+	glColorPointer( 4, GL_FLOAT, 0, &colors[0] );
+
+	glDrawArrays( GL_QUADS, 0, static_cast<GLsizei>(vertices.size() / 2) );
+
+	glDisableClientState( GL_COLOR_ARRAY );
+	glDisableClientState( GL_TEXTURE_COORD_ARRAY );
+	glDisableClientState( GL_VERTEX_ARRAY );
+
+	glEnable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+	glDisable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D,0);
+
+	// Keep the capacity so that the next frame doesn't allocate
+	vertices.clear();
+	texCoords.clear();
+	colors.clear();
+	drawCalls++;
+}
@@ -0,0 +1,37 @@
+/**\file			spritebatch.h
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Draws many textured quads with few draw calls
+ * \details
+ */
+
+#ifndef __H_SPRITEBATCH__
+#define __H_SPRITEBATCH__
+
+#include "includes.h"
+
+class SpriteBatch {
+	public:
+		static void Begin( void );
+		static void End( void );
+		static void Flush( void );
+		static bool IsBatching( void ) { return batching; }
+
+		static void Add( GLuint texture, const GLfloat corners[8], float u0, float v0, float u1, float v1, float r, float g, float b, float a );
+
+		static int GetDrawCalls( void ) { return drawCalls; }
+		static int GetQuads( void ) { return quads; }
+
+	private:
+		static bool batching;
+		static GLuint texture;        ///< The texture of every quad waiting to be drawn.
+		static vector<GLfloat> vertices;  ///< Two floats for each corner.
+		static vector<GLfloat> texCoords; ///< Two floats for each corner.
+		static vector<GLfloat> colors;    ///< Four floats for each corner.
+
+		static int drawCalls; ///< Draw calls since the last Begin.
+		static int quads;     ///< Quads since the last Begin.
+};
+
+#endif // __H_SPRITEBATCH__
@@ -0,0 +1,122 @@
+/**\file			queue_lockfree.h
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			A bounded queue that many threads can use without locking.
+ * \details
+ * This is Dmitry Vyukov's bounded MPMC queue.  Every cell carries a sequence
+ * number that tells a producer when the cell is free and a consumer when it
+ * is full, so the only shared writes are one compare-and-swap per Push or Pop.
+ */
+
+#ifndef __h_queue_lockfree__
+#define __h_queue_lockfree__
+
+#include "includes.h"
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+	#define ATOMIC_CAS(ptr,oldval,newval) (_InterlockedCompareExchange((volatile long*)(ptr),(long)(newval),(long)(oldval)) == (long)(oldval))
+	#define ATOMIC_INCREMENT(ptr) ((unsigned int)_InterlockedIncrement((volatile long*)(ptr)))
+	#define MEMORY_BARRIER() MemoryBarrier()
+#else
+	#define ATOMIC_CAS(ptr,oldval,newval) __sync_bool_compare_and_swap((ptr),(oldval),(newval))
+	#define ATOMIC_INCREMENT(ptr) __sync_add_and_fetch((ptr),1)
+	#define MEMORY_BARRIER() __sync_synchronize()
+#endif
+
+template<class T>
+class LockFreeQueue {
+	public:
+		/**\brief Allocates every cell up front.
+		 * \param _capacity Rounded up to a power of two.
+		 */
+		LockFreeQueue( unsigned int _capacity ) {
+			unsigned int size = 2;
+			while( size < _capacity ) size *= 2;
+			mask = size - 1;
+			cells = new Cell[size];
+			for( unsigned int i = 0; i < size; i++ ) {
+				cells[i].sequence = i;
+			}
+			enqueuePos = 0;
+			dequeuePos = 0;
+		}
+
+		~LockFreeQueue() {
+			delete [] cells;
+		}
+
+		/**\brief Copies an item onto the back of the queue.
+		 * \return false when the queue is full.
+		 */
+		bool Push( const T& data ) {
+			Cell *cell;
+			unsigned int pos = enqueuePos;
+			for(;;) {
+				cell = &cells[pos & mask];
+				MEMORY_BARRIER();
+				int dif = (int)(cell->sequence - pos);
+				if( dif == 0 ) {
+					if( ATOMIC_CAS( &enqueuePos, pos, pos + 1 ) )
+						break;
+					pos = enqueuePos;
+				} else if( dif < 0 ) {
+					return false; // Full
+				} else {
+					pos = enqueuePos;
+				}
+			}
+			cell->data = data;
+			MEMORY_BARRIER();
+			cell->sequence = pos + 1;
+			return true;
+		}
+
+		/**\brief Copies the item at the front of the queue out and removes it.
+		 * \return false when the queue is empty.
+		 */
+		bool Pop( T& data ) {
+			Cell *cell;
+			unsigned int pos = dequeuePos;
+			for(;;) {
+				cell = &cells[pos & mask];
+				MEMORY_BARRIER();
+				int dif = (int)(cell->sequence - (pos + 1));
+				if( dif == 0 ) {
+					if( ATOMIC_CAS( &dequeuePos, pos, pos + 1 ) )
+						break;
+					pos = dequeuePos;
+				} else if( dif < 0 ) {
+					return false; // Empty
+				} else {
+					pos = dequeuePos;
+				}
+			}
+			data = cell->data;
+			MEMORY_BARRIER();
+			cell->sequence = pos + mask + 1;
+			return true;
+		}
+
+	private:
+		LockFreeQueue( const LockFreeQueue& );
+		LockFreeQueue& operator=( const LockFreeQueue& );
+
+		struct Cell {
+			volatile unsigned int sequence;
+			T data;
+		};
+
+		Cell *cells;
+		unsigned int mask;
+
+		// Keep the producer and consumer positions on separate cache lines.
+		char pad0[64];
+		volatile unsigned int enqueuePos;
+		char pad1[64];
+		volatile unsigned int dequeuePos;
+		char pad2[64];
+};
+
+#endif // __h_queue_lockfree__
@@ -25,6 +25,14 @@ Effect::Effect(Coordinate pos, string filename, float loopPercent) {
 	visual->SetLoopPercent( loopPercent );
 }
 
+/**\brief Creates a new Effect at specified coordinate with an Ani that has already been loaded
+ */
+Effect::Effect(Coordinate pos, Ani *ani, float loopPercent) {
+	SetWorldPosition(pos);
+	visual = new Animation(ani);
+	visual->SetLoopPercent( loopPercent );
+}
+
 /**\brief Destroy an Effect
  */
 Effect::~Effect() {
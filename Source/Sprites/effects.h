@@ -18,6 +18,7 @@
 class Effect : public Sprite {
 	public:
 		Effect(Coordinate pos, string filename, float loopPercent);
+		Effect(Coordinate pos, Ani *ani, float loopPercent);
 		~Effect();
 		void Update(void);
 		void Draw(void);
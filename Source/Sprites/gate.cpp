@@ -171,10 +171,11 @@ void Gate::Update() {
 	// The Bottom Gate doesn't do anything
 	if(!top) return;
 
-	SpriteManager *sprites = SpriteManager::Instance();
-	Sprite* ship = sprites->GetNearestSprite( (Sprite*)this, 50,DRAW_ORDER_SHIP|DRAW_ORDER_PLAYER );
+	// The closest Ship found by the broad phase is the one entering the Gate
+	ContactRange contacts = SpriteManager::Instance()->GetContacts( (Sprite*)this );
 
-	if(ship!=NULL) {
+	if(contacts.first != contacts.second) {
+		Sprite* ship = contacts.first->other;
 		if(exitID != 0) {
 			SendToExit(ship);
 		} else if(rand()&1) {
@@ -172,12 +172,13 @@ void Planet::Update() {
 }
 
 void Planet::GenerateTraffic() {
-	list<Sprite*> *nearbySprites = SpriteManager::Instance()->GetSpritesNear(GetWorldPosition(), TO_FLOAT(sphereOfInfluence), DRAW_ORDER_SHIP | DRAW_ORDER_PLAYER);
+	vector<Sprite*> nearbySprites;
+	nearbySprites.reserve( traffic + 1 ); // Only the count matters
+	SpriteManager::Instance()->GetSpritesNear( nearbySprites, GetWorldPosition(), TO_FLOAT(sphereOfInfluence), DRAW_ORDER_SHIP | DRAW_ORDER_PLAYER );
 
-	if( nearbySprites->size() < traffic ) {
+	if( nearbySprites.size() < traffic ) {
 		Lua::Call( "createRandomShipForPlanet", "i", GetID() );
 	}
-	delete nearbySprites;
 	lastTrafficTime = Timer::GetLogicalFrameCount();
 }
 
@@ -451,25 +452,14 @@ int Planets_Lua::NewPlanet(lua_State* L){
 	return 1;
 }
 
-/*
-Planet **Planets_Lua::pushPlanet(lua_State *L){
-	Planet **s = (Planet **)lua_newuserdata(L, sizeof(Planet*));
-	*s = new Planet();
-	luaL_getmetatable(L, EPIAR_PLANET);
-	lua_setmetatable(L, -2);
-	return s;
-}
-*/
-
 /**\brief Check that the a Lua value really is a Planet
  */
 Planet *Planets_Lua::checkPlanet(lua_State *L, int index){
-	int *idptr;
-	idptr = (int*)luaL_checkudata(L, index, EPIAR_PLANET);
-	luaL_argcheck(L, idptr != NULL, index, "`EPIAR_PLANET' expected");
+	SpriteHandle *handle;
+	handle = (SpriteHandle*)luaL_checkudata(L, index, EPIAR_PLANET);
+	luaL_argcheck(L, handle != NULL, index, "`EPIAR_PLANET' expected");
 
-	Sprite* s;
-	s = SpriteManager::Instance()->GetSpriteByID(*idptr);
+	Sprite* s = handle->sprite;
 	if ((s) == NULL) luaL_typerror(L, index, EPIAR_PLANET);
 	if (0==((s)->GetDrawOrder() & DRAW_ORDER_PLANET)){
 		luaL_typerror(L, index, EPIAR_PLANET);
@@ -95,7 +95,6 @@ class Planets : public Components {
 class Planets_Lua {
 	public:
 		static void RegisterPlanets(lua_State *L);
-		//static Planet **pushPlanet(lua_State *L);
 		static Planet *checkPlanet(lua_State *L, int index);
 		static int Get(lua_State* L);
 		static int NewPlanet(lua_State* L);
@@ -68,6 +68,7 @@ Player::Player() {
  */
 Player::~Player() {
 	pInstance = NULL;
+	Lua::Release( luaControlChunk );
 	LogMsg(INFO, "You have been destroyed..." );
 }
 
@@ -86,12 +87,32 @@ void Player::Update( void ) {
 	}
 
 	if(luaControlFunc != ""){
-		Lua::Run(luaControlFunc);
+		// Compiled again if Lua was restarted since
+		if( !Lua::IsCurrent( luaControlChunk ) ) {
+			luaControlChunk = Lua::Compile( luaControlFunc );
+		}
+		Lua::Run(luaControlChunk);
 	}
 
 	Ship::Update();
 }
 
+/**\brief Runs some Lua code every frame instead of the player's input.
+ * \details The code is compiled once here rather than on every Update.
+ */
+void Player::SetLuaControlFunc( string _luaControlFunc ) {
+	Lua::Release( luaControlChunk );
+	luaControlFunc = _luaControlFunc;
+	luaControlChunk = Lua::Compile( luaControlFunc );
+}
+
+/**\brief Gives control back to the player's input.
+ */
+void Player::RemoveLuaControlFunc() {
+	Lua::Release( luaControlChunk );
+	luaControlFunc = "";
+}
+
 /**\brief Parse one player out of an xml node
  */
 bool Player::FromXMLNode( xmlDocPtr doc, xmlNodePtr node ) {
@@ -208,6 +229,7 @@ bool Player::ConfigureWeaponSlots( xmlDocPtr doc, xmlNodePtr node ) {
 	// This makes a copy, not a pointer or reference, so we don't have to worry
 	// that it might alter the slots in the model.
 	this->weaponSlots = this->GetModel()->GetWeaponSlots();
+	WeaponSlotsChanged(); // The slots are edited below
 
 	for( slotPtr = FirstChildNamed(node,"weapSlot"); slotPtr != NULL; slotPtr = NextSiblingNamed(slotPtr,"weapSlot") ){
 		ws_t *existingSlot = NULL;
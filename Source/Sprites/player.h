@@ -13,6 +13,7 @@
 #include "includes.h"
 #include "Sprites/ship.h"
 #include "Engine/mission.h"
+#include "Utilities/lua.h"
 
 class Player : public Ship , public Component {
 	public:
@@ -22,8 +23,8 @@ class Player : public Ship , public Component {
 		void setLastPlanet( string planetName);
 		string GetLastPlanet() { return lastPlanet; }
 		string GetName() { return name; }
-		void SetLuaControlFunc( string _luaControlFunc ){ luaControlFunc = _luaControlFunc; }
-		void RemoveLuaControlFunc() { luaControlFunc = ""; }
+		void SetLuaControlFunc( string _luaControlFunc );
+		void RemoveLuaControlFunc();
 
 		void AcceptMission( Mission *mission );
 		void RejectMission( string missionName );
@@ -55,6 +56,7 @@ class Player : public Ship , public Component {
 		string lastPlanet;
 		list<Mission*> missions;
 		string luaControlFunc;
+		LuaChunk luaControlChunk; ///< luaControlFunc compiled by Lua::Compile.
 };
 
 class Players : public Components {
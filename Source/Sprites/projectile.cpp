@@ -79,18 +79,23 @@ void Projectile::Update( void ) {
 	Sprite::Update(); // update momentum and other generic sprite attributes
 	SpriteManager *sprites = SpriteManager::Instance();
 
-	// Check for projectile collisions
-	Sprite* impact = sprites->GetNearestSprite( (Sprite*)this, 100,DRAW_ORDER_SHIP|DRAW_ORDER_PLAYER );
-	if( (impact != NULL) && (impact->GetID() != ownerID) && ((this->GetWorldPosition() - impact->GetWorldPosition()).GetMagnitude() < impact->GetRadarSize() )) {
-		((Ship*)impact)->Damage( (weapon->GetPayload())*damageBoost );
+	// Check for projectile collisions against the Ships found by the broad phase
+	Sprite* impact = NULL;
+	ContactRange contacts = sprites->GetContacts( (Sprite*)this );
+	for( vector<Contact>::iterator c = contacts.first; c != contacts.second; ++c ) {
+		if( (c->other->GetID() != ownerID) && ((this->GetWorldPosition() - c->other->GetWorldPosition()).GetMagnitude() < c->other->GetRadarSize() )) {
+			impact = c->other;
+			break;
+		}
+	}
+	if( impact != NULL ) {
+		// Projectiles may be updated on a worker thread, so the SpriteManager applies the damage.
+		sprites->Damage( impact, static_cast<short int>((weapon->GetPayload())*damageBoost) );
 		sprites->Delete( (Sprite*)this );
 		
 		// Create a fire burst where this projectile hit the ship's shields.
 		// TODO: This shows how much we need to improve our collision detection.
-		Effect* hit = new Effect(this->GetWorldPosition(), "Resources/Animations/shield.ani", 0);
-		hit->SetAngle( -this->GetAngle() );
-		hit->SetMomentum( impact->GetMomentum() );
-		sprites->Add( hit );
+		sprites->AddEffect( this->GetWorldPosition(), "Resources/Animations/shield.ani", -this->GetAngle(), impact->GetMomentum() );
 	}
 
 	// Expire the projectile after a time period
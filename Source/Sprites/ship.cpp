@@ -20,6 +20,14 @@
 
 #define NON_PLAYER_SOUND_RATIO 0.4f ///< Ratio used to quiet NON-PLAYER Ship Sounds.
 
+// Sound options read by every Ship every frame.
+static OptionHandle<float> engineVolume("options/sound/engines");
+static OptionHandle<float> weaponVolume("options/sound/weapons");
+static OptionHandle<int> explosionSounds("options/sound/explosions");
+
+ResourceHandle<Sound> Ship::explosionSound("Resources/Audio/Effects/18384__inferno__largex.wav.ogg");
+ResourceHandle<Ani> Ship::explosionAnimation("Resources/Animations/explosion1.ani");
+
 /**\class Ship
  * \brief A Ship Sprite that moves, Fires Weapons, has cargo, and ultimately explodes.
  * \sa Player, AI
@@ -54,6 +62,7 @@ Ship::Ship()
 	status.lastWeaponChangeAt = 0;
 
 	memset(status.lastFiredAt, 0, sizeof(status.lastFiredAt));
+	weaponSlotsChanged = true;
 
 	status.selectedWeapon = 0;
 	status.cargoSpaceUsed = 0;
@@ -90,6 +99,7 @@ bool Ship::SetModel( Model *model) {
 
 		// Copy default weapon slot arrangement from model,
 		this->weaponSlots = model->GetWeaponSlots();
+		WeaponSlotsChanged();
 
 		// go ahead and build a weapon list from it
 		for(unsigned int i = 0; i < weaponSlots.size(); i++){
@@ -217,7 +227,7 @@ void Ship::Accelerate( void ) {
 	
 	status.isAccelerating = true;
 	// Play engine sound
-	float engvol = OPTION(float,"options/sound/engines");
+	float engvol = engineVolume.Get();
 	Coordinate offset = GetWorldPosition() - Camera::Instance()->GetFocusCoordinate();
 	if ( this->GetDrawOrder() == DRAW_ORDER_SHIP )
 		engvol = engvol * NON_PLAYER_SOUND_RATIO ;
@@ -282,15 +292,15 @@ void Ship::Update( void ) {
 		SpriteManager *sprites = SpriteManager::Instance();
 
 		// Play explode sound
-		if(OPTION(int, "options/sound/explosions")) {
-			Sound *explodesnd = Sound::Get("Resources/Audio/Effects/18384__inferno__largex.wav.ogg");
+		Sound *explodesnd = explosionSound.Get();
+		if( explosionSounds.Get() && explodesnd ) {
 			explodesnd->Play(
 				this->GetWorldPosition() - Camera::Instance()->GetFocusCoordinate());
 		}
 
 		// Create Explosion
 		sprites->Add(
-			new Effect(this->GetWorldPosition(), "Resources/Animations/explosion1.ani", 0) );
+			new Effect(this->GetWorldPosition(), explosionAnimation.Get(), 0) );
 
 		// Remove this Sprite from the SpriteManager
 		sprites->Delete( (Sprite*)this );
@@ -331,6 +341,9 @@ void Ship::Draw( void ) {
 }
 
 /**\brief Fire's ship current weapon.
+ * \details The weapon slots are looked up by PrepareWeaponSlots when they
+ * change, so firing doesn't look anything up by name.  The target and the
+ * direction towards it are only found once per volley.
  * \return FireStatus
  */
 FireStatus Ship::Fire( int target ) {
@@ -342,129 +355,111 @@ FireStatus Ship::Fire( int target ) {
 	// Check that we are always selecting either the primary or the secondary firing group
 	assert( status.selectedWeapon == 0 || status.selectedWeapon == 1 );
 
+	if( weaponSlotsChanged ) {
+		PrepareWeaponSlots();
+	}
+
 	bool fnr = false;
 	bool fna = false;
-	bool emptySlot = false;
 	bool fired = false;
 	bool emptyFiringGroup = true;
 
-	for(unsigned int slot = 0; slot < weaponSlots.size(); slot++){
+	const Uint32 now = Timer::GetTicks();
+	const float shipAngle = GetAngle();
+	bool aimed = false;
+	bool hasTarget = false;
+	float towardsTarget = 0;
+	float cosAngle = 0, sinAngle = 0;
+	SpriteManager *sprites = SpriteManager::Instance();
 
-		string weapName = weaponSlots[slot].content;
-		short int slotFiringGroup = weaponSlots[slot].firingGroup;
+	for( vector<SlotFiring>::iterator slot = slotFiring.begin(); slot != slotFiring.end(); ++slot ) {
+		Weapon* currentWeapon = slot->weapon;
 
-		Weapon* currentWeapon = Weapons::Instance()->GetWeapon(weapName);
+		if( (unsigned int)slot->firingGroup != status.selectedWeapon ){ // status.selectedWeapon now refers to the firing group
+			continue;
+		}
+		emptyFiringGroup = false;
 
-		if(currentWeapon == NULL){
-			// do nothing for this slot (this may be because the weapon slot is empty)
+		// Check that the weapon has cooled down;
+		if( !( (int)(currentWeapon->GetFireDelay()) < (int)(now - status.lastFiredAt[slot->slot])) ) {
+			fnr = true;
+			continue;
+		}
+		// Check that there is sufficient ammo
+		if( ammo[currentWeapon->GetAmmoType()] < currentWeapon->GetAmmoConsumption() ) {
+			fna = true;
+			continue;
+		}
+
+		// Aim once for the whole volley
+		if( !aimed ) {
+			Trig *trig = Trig::Instance();
+			float angle = static_cast<float>(trig->DegToRad( shipAngle ));
+			cosAngle = trig->GetCos( angle );
+			sinAngle = trig->GetSin( angle );
+
+			Sprite *targetSprite = sprites->GetSpriteByID(target);
+			if( targetSprite != NULL ) {
+				hasTarget = true;
+				towardsTarget = GetDirectionTowards(targetSprite->GetWorldPosition());
+			}
+			aimed = true;
+		}
+
+		float projectileAngle = 0;
+		bool angleAcceptable = true;
+
+		if(slot->motionAngle == 0){ // a regular fixed weapon slot
+			projectileAngle = shipAngle + slot->angle;
+		}
+		else if(hasTarget && slot->motionAngle == 360){ // a turret with full rotation
+			projectileAngle = shipAngle + towardsTarget;
+		}
+		else if(hasTarget) { // a "swivel" slot with partial rotation
+			float swivel = fabs( slot->angle - towardsTarget );
+			if( swivel < slot->motionAngle/2 || swivel > (360-slot->motionAngle/2) ) {
+				projectileAngle = shipAngle + towardsTarget;
+			}
+			else {
+				angleAcceptable = false; // out of the slot's range of motion
+			}
 		}
 		else {
-			if( (unsigned int)slotFiringGroup == status.selectedWeapon ){ // status.selectedWeapon now refers to the firing group
-				emptyFiringGroup = false;
+			// turret or swivel but there is no target
+			angleAcceptable = false;
+		}
 
-				// Check that the weapon has cooled down;
-				if( !( (int)(currentWeapon->GetFireDelay()) < (int)(Timer::GetTicks() - status.lastFiredAt[slot])) ) {
-					fnr = true;
-				}
-				// Check that there is sufficient ammo
-				else if( ammo[currentWeapon->GetAmmoType()] < currentWeapon->GetAmmoConsumption() ) {
-					fna = true;
-				}
-				else if(emptySlot){
-					// do nothing
-				}
-				else {
-					// Calculate the offset needed to fire at the position specified for this slot in the XML file
-					Trig *trig = Trig::Instance();
-					float angle = static_cast<float>(trig->DegToRad( GetAngle()));		
-					Coordinate worldPosition  = GetWorldPosition();
-					int y_offset = (int)(weaponSlots[slot].y);
-					int x_offset = (int)(weaponSlots[slot].x);
-
-					// if mode is manual, then the x,y offsets from the XML file are to be used
-					if(weaponSlots[slot].mode == "manual"){
-						// adjust for y offset
-						worldPosition += Coordinate(
-							trig->GetCos( angle ) * y_offset,
-							-trig->GetSin( angle ) * y_offset
-						);
-
-						// adjust for x offset
-						worldPosition += Coordinate(
-							trig->GetSin(angle) * x_offset,
-							trig->GetCos(angle) * x_offset
-						);
-					}
-					// if mode is auto, use the old-style firing offset behavior
-					else if(weaponSlots[slot].mode == "auto"){
-						int offset = model->GetImage()->GetHalfHeight();
-						worldPosition += Coordinate(
-							trig->GetCos( angle ) * offset,
-							-trig->GetSin( angle ) * offset
-						);
-					}
-
-					SpriteManager *sprites = SpriteManager::Instance();
-					Sprite *targetSprite = sprites->GetSpriteByID(target);
-
-					float projectileAngle;
-					bool angleAcceptable = true;
-
-					if(weaponSlots[slot].motionAngle == 0){ // a regular fixed weapon slot
-						projectileAngle = GetAngle() + weaponSlots[slot].angle;
-					}
-					else if(targetSprite != NULL && weaponSlots[slot].motionAngle == 360){ // a turret with full rotation
-						projectileAngle = GetAngle() + GetDirectionTowards(targetSprite->GetWorldPosition());
-					}
-					else if(targetSprite != NULL) { // a "swivel" slot with partial rotation
-						if(
-						    fabs( (weaponSlots[slot].angle) -
-						      (GetDirectionTowards(targetSprite->GetWorldPosition())) )
-						         < weaponSlots[slot].motionAngle/2 ||
-						    fabs( (weaponSlots[slot].angle) -
-						      (GetDirectionTowards(targetSprite->GetWorldPosition())) )
-						         > (360-weaponSlots[slot].motionAngle/2) )
-						{
-							projectileAngle = GetAngle() + GetDirectionTowards(targetSprite->GetWorldPosition());
-						}
-						else {
-							angleAcceptable = false; // out of the slot's range of motion
-						}
-					}
-					else {
-						// turret or swivel but there is no target
-						angleAcceptable = false;
-					}
-
-					if(angleAcceptable){
-
-						//Play weapon sound
-						if( currentWeapon->GetSound() != NULL ) {
-							float weapvol = OPTION(float,"options/sound/weapons");
-						
-							if ( this->GetDrawOrder() == DRAW_ORDER_SHIP ) {
-								weapvol *= NON_PLAYER_SOUND_RATIO;
-							}
-							currentWeapon->GetSound()->SetVolume( weapvol );
-							currentWeapon->GetSound()->Play( GetWorldPosition() - Camera::Instance()->GetFocusCoordinate() );
-						}
-
-						//Fire the weapon
-						Projectile *projectile = new Projectile(damageBooster, projectileAngle, worldPosition, GetMomentum(), currentWeapon);
-						projectile->SetOwnerID( this->GetID() );
-						projectile->SetTargetID( target );
-						sprites->Add( (Sprite*)projectile );
-
-						//reduce ammo
-						ammo[currentWeapon->GetAmmoType()] -=  currentWeapon->GetAmmoConsumption();
-
-						//track number of ticks the last fired occured for this weapon
-						status.lastFiredAt[slot] = Timer::GetTicks();
-
-						fired = true;
-					}
+		if(angleAcceptable){
+			// The offset of this slot, turned the way the ship is facing
+			Coordinate worldPosition = GetWorldPosition() + Coordinate(
+				cosAngle * slot->forward + sinAngle * slot->side,
+				-sinAngle * slot->forward + cosAngle * slot->side
+			);
+
+			//Play weapon sound
+			if( currentWeapon->GetSound() != NULL ) {
+				float weapvol = weaponVolume.Get();
+
+				if ( this->GetDrawOrder() == DRAW_ORDER_SHIP ) {
+					weapvol *= NON_PLAYER_SOUND_RATIO;
 				}
+				currentWeapon->GetSound()->SetVolume( weapvol );
+				currentWeapon->GetSound()->Play( GetWorldPosition() - Camera::Instance()->GetFocusCoordinate() );
 			}
+
+			//Fire the weapon
+			Projectile *projectile = new Projectile(damageBooster, projectileAngle, worldPosition, GetMomentum(), currentWeapon);
+			projectile->SetOwnerID( this->GetID() );
+			projectile->SetTargetID( target );
+			sprites->Add( (Sprite*)projectile );
+
+			//reduce ammo
+			ammo[currentWeapon->GetAmmoType()] -=  currentWeapon->GetAmmoConsumption();
+
+			//track number of ticks the last fired occured for this weapon
+			status.lastFiredAt[slot->slot] = now;
+
+			fired = true;
 		}
 	}
 
@@ -476,6 +471,44 @@ FireStatus Ship::Fire( int target ) {
 	return FireUnknown;
 }
 
+/**\brief Looks up what Fire needs to know about each loaded weapon slot (Internal use)
+ * \details This runs the first time that the Ship fires after its model or
+ * weapon slots change.  The weapons are found by name, and the "manual" and
+ * "auto" modes are turned into an offset from the center of the Ship.
+ */
+void Ship::PrepareWeaponSlots() {
+	Weapons *weapons = Weapons::Instance();
+
+	slotFiring.clear();
+	for(unsigned int slot = 0; slot < weaponSlots.size(); slot++){
+		Weapon *weapon = weapons->GetWeapon( weaponSlots[slot].content );
+		if( weapon == NULL ) {
+			continue; // this may be because the weapon slot is empty
+		}
+
+		SlotFiring firing;
+		firing.slot = slot;
+		firing.weapon = weapon;
+		firing.firingGroup = weaponSlots[slot].firingGroup;
+		firing.forward = 0;
+		firing.side = 0;
+		firing.angle = static_cast<float>( weaponSlots[slot].angle );
+		firing.motionAngle = static_cast<float>( weaponSlots[slot].motionAngle );
+
+		// if mode is manual, then the x,y offsets from the XML file are to be used
+		if(weaponSlots[slot].mode == "manual"){
+			firing.forward = (int)(weaponSlots[slot].y);
+			firing.side = (int)(weaponSlots[slot].x);
+		}
+		// if mode is auto, use the old-style firing offset behavior
+		else if(weaponSlots[slot].mode == "auto"){
+			firing.forward = model->GetImage()->GetHalfHeight();
+		}
+		slotFiring.push_back( firing );
+	}
+	weaponSlotsChanged = false;
+}
+
 /**\brief Adds a new weapon to the ship WITHOUT updating weaponSlots.
  * \param i Pointer to Weapon instance
  * \sa Weapon
@@ -512,6 +545,7 @@ int Ship::AddShipWeapon(Weapon *w){
 		ws_t *slot = &weaponSlots[s];
 		if(slot->content == ""){
 			slot->content = w->GetName(); // this will edit-in-place, so no need to shove a struct back into weaponSlots
+			WeaponSlotsChanged();
 			AddToShipWeaponList(w);
 			return 1;
 		}
@@ -590,6 +624,7 @@ void Ship::RemoveShipWeapon(Weapon *w){
 		ws_t *slot = &weaponSlots[s];
 		if(slot->content == w->GetName()){
 			slot->content = ""; // this will edit-in-place, so no need to shove a struct back into weaponSlots
+			WeaponSlotsChanged();
 			return;
 		}
 	}
@@ -851,6 +886,7 @@ string Ship::GetWeaponSlotStatus(int i) {
  */
 void Ship::SetWeaponSlotStatus(int i, string s) {
 	this->weaponSlots[i].content = s;
+	WeaponSlotsChanged();
 }
 
 /**\brief The firing group of weapon slot i
@@ -863,6 +899,7 @@ short int Ship::GetWeaponSlotFG(int i) {
  */
 void Ship::SetWeaponSlotFG(int i, short int fg) {
 	this->weaponSlots[i].firingGroup = fg;
+	WeaponSlotsChanged();
 }
 
 /**\brief returns a map<string,string> of with slotname/content pairs for use in Lua
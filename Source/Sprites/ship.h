@@ -15,6 +15,9 @@
 #include "Engine/commodities.h"
 #include "Engine/weapon.h"
 #include "Sprites/projectile.h"
+#include "Audio/sound.h"
+#include "Graphics/animation.h"
+#include "Utilities/resource.h"
 #include <map>
 
 class Ship : public Sprite {
@@ -108,10 +111,15 @@ class Ship : public Sprite {
 		void SetFriendly(int f) { friendly = (f == 1); }
 		int GetFriendly() { return (friendly ? 1 : 0 ); }
 
+		// Resources used when a Ship explodes.
+		static ResourceHandle<Sound> explosionSound;
+		static ResourceHandle<Ani> explosionAnimation;
+
 	protected:
 		typedef struct ws ws_t;
 
 		vector<ws_t> weaponSlots; ///< The weapon slot arrangement - accessed directly by Player for loading/saving
+		void WeaponSlotsChanged() { weaponSlotsChanged = true; }
 	
 	private:
 		Model *model;
@@ -122,6 +130,20 @@ class Ship : public Sprite {
 		float damageBooster, engineBooster, shieldBooster;
 	
 		void ComputeShipStats();
+		void PrepareWeaponSlots();
+
+		/**\brief A loaded weapon slot, as Fire uses it (Internal use)
+		 */
+		struct SlotFiring {
+			unsigned int slot;     ///< The index of the slot in weaponSlots.
+			Weapon *weapon;        ///< The Weapon in the slot.
+			short int firingGroup; ///< Which firing group the slot belongs to.
+			float forward, side;   ///< Where the Weapon fires from, along and across the Ship.
+			float angle;           ///< The angle that the Weapon is mounted at.
+			float motionAngle;     ///< How far the Weapon can turn: 0 when fixed, 360 for a turret.
+		};
+		vector<SlotFiring> slotFiring; ///< The loaded weapon slots, rebuilt when weaponSlots changes.
+		bool weaponSlotsChanged; ///< Whether slotFiring has to be rebuilt.
 
 		struct {
 			/* Related to ship's condition */
@@ -8,8 +8,14 @@
 #include "includes.h"
 #include "common.h"
 #include "Sprites/spritemanager.h"
+#include "Sprites/effects.h"
+#include "Sprites/ship.h"
+#include "Graphics/spritebatch.h"
+#include "Engine/simulation_lua.h"
+#include "AI/ai_shards.h"
 #include "Utilities/quadtree.h"
 #include "Utilities/camera.h"
+#include "Utilities/timer.h"
 
 
 /**\class SpriteManager
@@ -27,6 +33,9 @@ SpriteManager::SpriteManager() :
 {
 	spritelist = new list<Sprite*>();
 	spritelookup = new map<int,Sprite*>();
+	workers = NULL;
+	northEdge = southEdge = eastEdge = westEdge = 0;
+	timing = false;
 
 
 			//fill in the ticksToBandNum map based on the semiRegularPeriod and numSemiRegularBands
@@ -44,6 +53,8 @@ SpriteManager& SpriteManager::operator=( SpriteManager& object ){
 	if ( this == &object ) return * this; //block self assignment
 	
 	trees = object.trees;
+	quadrantColumns = object.quadrantColumns;
+	quadrantRows = object.quadrantRows;
 	spritelist = object.spritelist;
 	spritelookup = object.spritelookup;
 	
@@ -81,6 +92,15 @@ SpriteManager *SpriteManager::Instance( void ) {
  * \param sprite Pointer to the sprite
  */
 void SpriteManager::Add( Sprite *sprite ) {
+	vector<SpriteCommand> *commands = GetCommandBuffer();
+	if( commands != NULL ) {
+		SpriteCommand add;
+		add.type = SpriteCommand::ADD_SPRITE;
+		add.sprite = sprite;
+		commands->push_back( add );
+		return;
+	}
+
 	spritelist->push_back(sprite);
 	spritelookup->insert(make_pair(sprite->GetID(),sprite));
 	GetQuadrant( sprite->GetWorldPosition() )->Insert( sprite );
@@ -92,6 +112,11 @@ void SpriteManager::Add( Sprite *sprite ) {
  * This performs the actual deletion.
  */
 bool SpriteManager::DeleteSprite( Sprite *sprite ) {
+	// Lua may still have this Sprite
+	if( (sprite->GetDrawOrder() & (DRAW_ORDER_SHIP | DRAW_ORDER_PLAYER | DRAW_ORDER_PLANET)) && Lua::CurrentState() != NULL ) {
+		Simulation_Lua::forgetSprite( Lua::CurrentState(), sprite );
+		AIShards::ForgetSprite( sprite );
+	}
 	spritelist->remove(sprite);
 	spritelookup->erase( sprite->GetID() );
 	GetQuadrant( sprite->GetWorldPosition() )->Delete( sprite );
@@ -109,16 +134,98 @@ bool SpriteManager::DeleteSprite( Sprite *sprite ) {
  * This just queues the sprite up to be deleted.
  */
 bool SpriteManager::Delete( Sprite *sprite ) {
+	vector<SpriteCommand> *commands = GetCommandBuffer();
+	if( commands != NULL ) {
+		SpriteCommand remove;
+		remove.type = SpriteCommand::DELETE_SPRITE;
+		remove.sprite = sprite;
+		commands->push_back( remove );
+		return true;
+	}
+
 	spritesToDelete.push_back(sprite);
 	return true;
 }
 
+/**\brief Creates a new Effect.
+ * \param position Where the Effect starts
+ * \param animation The Animation file to play
+ * \param angle The Angle of the Effect
+ * \param momentum How the Effect moves
+ * \details
+ * When this is called by a worker thread, the Effect is created once the quadrants have finished updating.
+ */
+void SpriteManager::AddEffect( Coordinate position, string animation, float angle, Coordinate momentum ) {
+	vector<SpriteCommand> *commands = GetCommandBuffer();
+	if( commands != NULL ) {
+		SpriteCommand effect;
+		effect.type = SpriteCommand::ADD_EFFECT;
+		effect.sprite = NULL;
+		effect.position = position;
+		effect.animation = animation;
+		effect.angle = angle;
+		effect.momentum = momentum;
+		commands->push_back( effect );
+		return;
+	}
+
+	Effect* e = new Effect( position, animation, 0 );
+	e->SetAngle( angle );
+	e->SetMomentum( momentum );
+	Add( e );
+}
+
+/**\brief Damages a Ship.
+ * \param ship The Ship (or Player) to damage
+ * \param damage Amount of damage
+ * \details
+ * When this is called by a worker thread, the Ship is damaged once the quadrants have finished updating.
+ */
+void SpriteManager::Damage( Sprite *ship, short int damage ) {
+	assert( ship->GetDrawOrder() & (DRAW_ORDER_SHIP | DRAW_ORDER_PLAYER) );
+	vector<SpriteCommand> *commands = GetCommandBuffer();
+	if( commands != NULL ) {
+		SpriteCommand hit;
+		hit.type = SpriteCommand::DAMAGE_SHIP;
+		hit.sprite = ship;
+		hit.damage = damage;
+		commands->push_back( hit );
+		return;
+	}
+
+	((Ship*)ship)->Damage( damage );
+}
+
+/**\brief Sets the number of threads used to update the Sprites.
+ * \param numThreads Number of worker threads.  With fewer than 2, every Sprite is updated on the main thread.
+ */
+void SpriteManager::SetThreads( int numThreads ) {
+	if( workers != NULL ) {
+		delete workers;
+		workers = NULL;
+	}
+	if( numThreads > 1 ) {
+		workers = new WorkerPool( numThreads );
+		workerJobs.assign( workers->GetNumThreads(), 0 );
+		workerQuadrants.assign( workers->GetNumThreads(), vector<QuadTree*>() );
+	}
+}
+
 /**\brief SpriteManager update function.
  * \param lowFps If true, forces the wave-update method to be used rather than the full-update
  */
 void SpriteManager::Update(bool lowFps) {
+	double started = 0, contacted = 0, updated = 0;
+	if( timing ) started = Timer::GetRealTime();
+
+	// Find everything that might collide this tick before anything moves
+	FindContacts();
+	if( timing ) contacted = Timer::GetRealTime();
+
 	// Update the sprites inside each quadrant
-	list<QuadTree*> quadList;		//this will contain every quadrant that we will potentially want to update
+	// quadList will contain every quadrant that we will potentially want to update
+	// It is kept between ticks so that it doesn't need to be reallocated.
+	quadList.clear();
 	
 			//if update-all is given then we update every quadrant
 			//we do the same if tickCount == 0 even if update-all is not given
@@ -133,10 +240,9 @@ void SpriteManager::Update(bool lowFps) {
 
 					//we also ALWAYS update the 'regular' bands
 					//	the first band is at index 1 - index 0 would be the single quadrant in the middle
-					//	when we get the list of quadrants back we splice them onto the end of our overall list
+					//	when we get the list of quadrants back we append them onto the end of our overall list
 		for (int i = 1; i <= numRegularBands; i ++) {
-			list<QuadTree*> tempBandList = GetQuadrantsInBand (currentPoint, i);
-			quadList.splice (quadList.end(), tempBandList);
+			GetQuadrantsInBand (currentPoint, i, quadList);
 		}
 
 					//now - we SOMETIMES update the semi-regular bands
@@ -147,90 +253,196 @@ void SpriteManager::Update(bool lowFps) {
 		map<int,int>::iterator findBand = ticksToBandNum.find (semiRegularTick);
 		if (findBand != ticksToBandNum.end()) {		//found the key
 			//cout << "tick = " << tickCount << ", semiRegularTick = " << semiRegularTick << ", band = " << findBand->second << endl;
-			list<QuadTree*> tempBandList = GetQuadrantsInBand (currentPoint, findBand->second);
-			quadList.splice (quadList.end(), tempBandList);
+			GetQuadrantsInBand (currentPoint, findBand->second, quadList);
 		}
 		else {
 				//no semi-regular bands to update at this tick, do nothing
 		}
 	}
 
+	outOfBounds.clear();
 
-	list<Sprite *> all_oob;
+	vector<QuadTree*>::iterator iter;
+	if( workers == NULL ) {
+		for ( iter = quadList.begin(); iter != quadList.end(); ++iter ) {
+			(*iter)->Update();
+		}
+	} else {
+		UpdateInParallel();
+	}
+	if( timing ) updated = Timer::GetRealTime();
 
-	list<QuadTree*>::iterator iter;
 	for ( iter = quadList.begin(); iter != quadList.end(); ++iter ) {
-		(*iter)->Update();
-		list<Sprite *>* oob = (*iter)->FixOutOfBounds();
-		all_oob.splice(all_oob.end(), *oob );
-		delete oob;
+		(*iter)->FixOutOfBounds( outOfBounds );
 	}
 
 	// Move sprites to adjacent Quadrants as they cross boundaries
-	list<Sprite *>::iterator i;
-	for( i = all_oob.begin(); i != all_oob.end(); ++i ) {
+	vector<Sprite *>::iterator i;
+	for( i = outOfBounds.begin(); i != outOfBounds.end(); ++i ) {
 		GetQuadrant( (*i)->GetWorldPosition() )->Insert( *i );
 	}
 
 	//Delete all sprites queued to be deleted
 	if (!spritesToDelete.empty()) {
-		spritesToDelete.sort(); // The list has to be sorted or unique doesn't work correctly.
-		spritesToDelete.unique();
+		sort( spritesToDelete.begin(), spritesToDelete.end() ); // The list has to be sorted or unique doesn't work correctly.
+		spritesToDelete.erase( unique( spritesToDelete.begin(), spritesToDelete.end() ), spritesToDelete.end() );
 		for( i = spritesToDelete.begin(); i != spritesToDelete.end(); ++i ) {
 			DeleteSprite(*i);
 		}
 		spritesToDelete.clear();
 	}
 
+	// The contacts may now point at deleted Sprites
+	contacts.clear();
+
 	for ( iter = quadList.begin(); iter != quadList.end(); ++iter ) {
 		(*iter)->ReBallance();
 	}
 
 	DeleteEmptyQuadrants();
 
+	if( timing ) {
+		times.ticks++;
+		times.contacts += contacted - started;
+		times.sprites += updated - contacted;
+		times.rebalance += Timer::GetRealTime() - updated;
+	}
+
 			//update the tick count after all updates for this tick are done
 	UpdateTickCount ();
 }
 
+/**\brief Updates the quadrants in quadList on the worker threads (Internal use)
+ * \details
+ * Each quadrant is one job.  Only the DRAW_ORDER_PARALLEL Sprites are updated
+ * by the workers; anything that they change outside of themselves is recorded
+ * in the command buffer of their quadrant.  The other Sprites (Ships, which
+ * call into Lua, and Planets and Gates) are collected by the workers as well.
+ *
+ * Once every quadrant is finished the commands are run, and then the other
+ * Sprites are updated, both in quadrant order.  This means that the result
+ * doesn't depend on which thread updated which quadrant.
+ *
+ * Between the two, the AI Ships that are due to think run their Lua state
+ * machines in the AIShards, if there are any.
+ */
+void SpriteManager::UpdateInParallel() {
+	unsigned int q;
+	vector<Sprite*>::iterator i;
+
+	if( commandBuffers.size() < quadList.size() ) {
+		commandBuffers.resize( quadList.size() );
+		serialSprites.resize( quadList.size() );
+	}
+	for( q = 0; q < quadList.size(); ++q ) {
+		commandBuffers[q].clear();
+		serialSprites[q].clear();
+	}
+
+	workers->Run( UpdateQuadrant, this, quadList.size() );
+
+	for( q = 0; q < quadList.size(); ++q ) {
+		RunCommands( commandBuffers[q] );
+	}
+	AIShards::Decide( workers, serialSprites, quadList.size() );
+	for( q = 0; q < quadList.size(); ++q ) {
+		for( i = serialSprites[q].begin(); i != serialSprites[q].end(); ++i ) {
+			(*i)->Update();
+		}
+	}
+}
+
+/**\brief Worker job that updates a single quadrant (Internal use)
+ */
+void SpriteManager::UpdateQuadrant( void *spriteManager, int job ) {
+	SpriteManager *sprites = (SpriteManager*)spriteManager;
+	sprites->workerJobs[ sprites->workers->CurrentWorker() ] = job;
+	sprites->quadList[job]->Update( DRAW_ORDER_PARALLEL, sprites->serialSprites[job] );
+}
+
+/**\brief Returns the command buffer of the calling worker thread (Internal use)
+ * \return The command buffer, or NULL when called from the main thread.
+ */
+vector<SpriteCommand> *SpriteManager::GetCommandBuffer() {
+	if( workers == NULL ) {
+		return NULL;
+	}
+	int worker = workers->CurrentWorker();
+	if( worker < 0 ) {
+		return NULL;
+	}
+	return &commandBuffers[ workerJobs[worker] ];
+}
+
+/**\brief Returns the quadrant search buffer of the calling thread (Internal use)
+ * \details The AIShards search for Sprites from the worker threads.
+ */
+vector<QuadTree*> &SpriteManager::GetSearchBuffer() {
+	if( workers == NULL ) {
+		return nearbyQuadrants;
+	}
+	int worker = workers->CurrentWorker();
+	if( worker < 0 ) {
+		return nearbyQuadrants;
+	}
+	return workerQuadrants[worker];
+}
+
+/**\brief Runs the commands recorded by a worker thread (Internal use)
+ */
+void SpriteManager::RunCommands( vector<SpriteCommand> &commands ) {
+	vector<SpriteCommand>::iterator c;
+	for( c = commands.begin(); c != commands.end(); ++c ) {
+		switch( c->type ) {
+			case SpriteCommand::ADD_SPRITE:
+				Add( c->sprite );
+				break;
+			case SpriteCommand::DELETE_SPRITE:
+				Delete( c->sprite );
+				break;
+			case SpriteCommand::DAMAGE_SHIP:
+				Damage( c->sprite, c->damage );
+				break;
+			case SpriteCommand::ADD_EFFECT:
+				AddEffect( c->position, c->animation, c->angle, c->momentum );
+				break;
+		}
+	}
+	commands.clear();
+}
+
 /**\brief Deletes empty QuadTrees (Internal use)
  */
 void SpriteManager::DeleteEmptyQuadrants() {
-	map<Coordinate,QuadTree*>::iterator iter;
 	// Delete QuadTrees that are empty
 	// TODO: Delete QuadTrees that are far away from 
-	list<QuadTree*> emptyTrees;
-	// Collect empty trees
-	for ( iter = trees.begin(); iter != trees.end(); ++iter ) { 
-		if ( iter->second->Count() == 0 ) {
-			emptyTrees.push_back(iter->second);
+	for ( int pos = 0; pos < trees.capacity(); ++pos ) { 
+		if ( trees.active(pos) && trees.element(pos).tree->Count() == 0 ) {
+			QuadrantCell cell = trees.element(pos);
+			//cout<<"Deleting the empty tree at "<<cell.tree->GetCenter()<<endl;
+			trees.remove( cell );
+			AdjustBoundaries( cell.x, cell.y, -1 );
+			delete cell.tree;
 		}
 	}
-	// Delete empty trees
-	list<QuadTree*>::iterator emptyIter;
-	for ( emptyIter = emptyTrees.begin(); emptyIter != emptyTrees.end(); ++emptyIter) {
-		//cout<<"Deleting the empty tree at "<<(*emptyIter)->GetCenter()<<endl;
-		trees.erase((*emptyIter)->GetCenter());
-		delete (*emptyIter);
-	}
-	if( emptyTrees.size() ) {
-		AdjustBoundaries();
-	}
 }
 
 /**\brief Draws the current sprites
  */
 void SpriteManager::Draw() {
-	list<Sprite *>::iterator i;
-	list<Sprite*> *onscreen;
+	vector<Sprite*>::iterator i;
 	float r = (Video::GetHalfHeight() < Video::GetHalfWidth() ? Video::GetHalfWidth() : Video::GetHalfHeight()) *V_SQRT2;
-	onscreen = GetSpritesNear( Camera::Instance()->GetFocusCoordinate(), r, DRAW_ORDER_ALL);
+	GetSpritesNear( onscreen, Camera::Instance()->GetFocusCoordinate(), r, DRAW_ORDER_ALL );
 
-	onscreen->sort(compareSpritePtrs);
+	// The draw order is a total order (ties are broken by ID), so an unstable sort is fine.
+	sort( onscreen.begin(), onscreen.end(), compareSpritePtrs );
 
-	for( i = onscreen->begin(); i != onscreen->end(); ++i ) {
+	// Consecutive Sprites from the same texture atlas are drawn together
+	SpriteBatch::Begin();
+	for( i = onscreen.begin(); i != onscreen.end(); ++i ) {
 		(*i)->Draw();
 	}
-	delete onscreen;
+	SpriteBatch::End();
 }
 
 /**\brief Draws the current sprites
@@ -239,24 +451,24 @@ void SpriteManager::DrawQuadrantMap() {
 	GetQuadrant( Camera::Instance()->GetFocusCoordinate() )->Draw( GetQuadrantCenter( Camera::Instance()->GetFocusCoordinate() ) );
 }
 
-/**\brief Retrieves a list of the current sprites.
- * \return std::list of Sprite pointers.
+/**\brief Retrieves the current sprites.
+ * \param sprites [out] Cleared, then filled with the Sprites of this type.
+ * \param type A DRAW_ORDER mask used to filter for desired Sprite types.
+ * \details The caller owns the vector; reusing it between calls avoids any allocation.
  */
-list<Sprite *> *SpriteManager::GetSprites(int type) {
+void SpriteManager::GetSprites(vector<Sprite*> &sprites, int type) {
 	list<Sprite *>::iterator i;
-	list<Sprite *> *filtered;
+	sprites.clear();
 	if( type==DRAW_ORDER_ALL ){
-		filtered = new list<Sprite*>(*spritelist);
+		sprites.assign( spritelist->begin(), spritelist->end() );
 	} else {
-		filtered = new list<Sprite*>();
 		// Collect only the Sprites of this type
 		for( i = spritelist->begin(); i != spritelist->end(); ++i ) {
 			if( (*i)->GetDrawOrder() & type){
-				filtered->push_back( (*i) );
+				sprites.push_back( (*i) );
 			}
 		}
 	}
-	return( filtered);
 }
 
 /**\brief Queries for sprite by the ID
@@ -273,134 +485,106 @@ Sprite *SpriteManager::GetSpriteByID(int id) {
 /**\brief Retrieves nearby QuadTrees in a square band at <bandIndex> quadrants distant from the coordinate
  * \param c Coordinate
  * \param bandIndex number of quadrants distant from c
- * \return std::list of QuadTree pointers.
+ * \param quadrants [out] The QuadTrees in the band are appended to this.
  */
-list<QuadTree*> SpriteManager::GetQuadrantsInBand ( Coordinate c, int bandIndex) {
-	// The possibleQuadrants here are the quadrants that are in the square band
-	//  at distance bandIndex from the coordinate
-	// After we get the possible quadrants we prune them by making sure they exist
+void SpriteManager::GetQuadrantsInBand( Coordinate c, int bandIndex, vector<QuadTree*> &quadrants ) {
+	// The possible quadrants here are the cells that are in the square band
+	//  at distance bandIndex from the cell containing the coordinate
+	// We only return the quadrants that exist
 	//  (ie that something is in them)
 
-	list<QuadTree*> nearbyQuadrants;
-	set<Coordinate> possibleQuadrants;
-
-			//note that the QUADRANTSIZE define is the
-			//	distance from the middle to the edge of a quadrant
-			//to get the square band of co-ordinates we have to
-			//		- start at bottom left 
-			//			loop over increasing Y (to get 'west' line)
-			//			loop over increasing X (to get 'south' line)
-			//		- start at top right
-			//			loop over decreasing Y (to get 'east' line)
-			//			loop over decreasing X (to get 'north' line)
-			
-	int edgeDistance = bandIndex * QUADRANTSIZE * 2;		//number of pixels from middle to the band
-	Coordinate bottomLeft (c - Coordinate (edgeDistance, edgeDistance));
-	Coordinate topLeft (c + Coordinate (-edgeDistance, edgeDistance));
-	Coordinate topRight (c + Coordinate (edgeDistance, edgeDistance));
-	Coordinate bottomRight (c + Coordinate (edgeDistance, -edgeDistance));
-
-			//the 'full' length of one of the lines is (bandindex * 2) + 1
-			//we don't need the +1 as we deal with the corners individually, separately
-	int bandLength = (bandIndex * 2);
-
-			//deal with the un-included corners first
-			//we're using bottomLeft and topRight as the anchors, 
-			// so topLeft and bottomRight are added here
-	possibleQuadrants.insert (GetQuadrantCenter (topLeft));
-	possibleQuadrants.insert (GetQuadrantCenter (bottomRight));
-	for (int i = 0; i < bandLength; i ++) {
-		int offset = ((QUADRANTSIZE * 2) * i);
-		Coordinate west, south, north, east;
-
-		west = GetQuadrantCenter (bottomLeft + Coordinate (0, offset));
-		south = GetQuadrantCenter (bottomLeft + Coordinate (offset, 0));
-		north = GetQuadrantCenter (topRight - Coordinate (offset, 0));
-		east = GetQuadrantCenter (topRight - Coordinate (0, offset));
-
-		possibleQuadrants.insert (west);		//west
-		possibleQuadrants.insert (south);		//south
-		possibleQuadrants.insert (north);		//north
-		possibleQuadrants.insert (east);		//east
-	}
-
-				//here we're checking to see if this possible quadrant is one of the existing quadrants
-				// and if it is then we add its QuadTree to the vector we're returning
-				// if it's not then there's nothing in it anyway so we don't care about it
-	set<Coordinate>::iterator it;
-	map<Coordinate,QuadTree*>::iterator iter;
-	for(it = possibleQuadrants.begin(); it != possibleQuadrants.end(); ++it) {
-		iter = trees.find(*it);
-		if(iter != trees.end()) {
-			nearbyQuadrants.push_back(iter->second);
+	QuadTree *tree;
+	int cx, cy;
+	GetQuadrantCell( c, &cx, &cy );
+
+	if( bandIndex == 0 ) {
+		if( (tree = FindQuadrant( cx, cy )) != NULL ) {
+			quadrants.push_back( tree );
 		}
-		
+		return;
+	}
+
+			//walk the south and north lines in full,
+			// then the west and east lines without their corners
+	for( int x = cx - bandIndex; x <= cx + bandIndex; x++ ) {
+		if( (tree = FindQuadrant( x, cy - bandIndex )) != NULL )
+			quadrants.push_back( tree );		//south
+		if( (tree = FindQuadrant( x, cy + bandIndex )) != NULL )
+			quadrants.push_back( tree );		//north
+	}
+	for( int y = cy - bandIndex + 1; y < cy + bandIndex; y++ ) {
+		if( (tree = FindQuadrant( cx - bandIndex, y )) != NULL )
+			quadrants.push_back( tree );		//west
+		if( (tree = FindQuadrant( cx + bandIndex, y )) != NULL )
+			quadrants.push_back( tree );		//east
 	}
-	return nearbyQuadrants;
 }
 	
 
 /**\brief Retrieves nearby QuadTrees
  * \param c Coordinate
  * \param r Radius
- * \return std::list of QuadTree pointers.
- */
-list<QuadTree*> SpriteManager::GetQuadrantsNear( Coordinate c, float r) {
-	// The possibleQuadrants are those trees adjacent and within a radius r
-	// Gather more trees when r is greater than the size of a quadrant
-	map<Coordinate,QuadTree*>::iterator iter;
-	list<QuadTree*> nearbyQuadrants;
-	set<Coordinate> possibleQuadrants;
-
-	Coordinate center = GetQuadrantCenter(c);
-
-	possibleQuadrants.insert( center );
-	float R = r;
-	do{
-		possibleQuadrants.insert( GetQuadrantCenter(c + Coordinate(-R,-0)));
-		possibleQuadrants.insert( GetQuadrantCenter(c + Coordinate(-0,+R)));
-		possibleQuadrants.insert( GetQuadrantCenter(c + Coordinate(+0,-R)));
-		possibleQuadrants.insert( GetQuadrantCenter(c + Coordinate(+R,+0)));
-		possibleQuadrants.insert( GetQuadrantCenter(c + Coordinate(-R,-R)));
-		possibleQuadrants.insert( GetQuadrantCenter(c + Coordinate(-R,+R)));
-		possibleQuadrants.insert( GetQuadrantCenter(c + Coordinate(+R,-R)));
-		possibleQuadrants.insert( GetQuadrantCenter(c + Coordinate(+R,+R)));
-		R/=2;
-	} while(R>QUADRANTSIZE);
-	set<Coordinate>::iterator it;
-	for(it = possibleQuadrants.begin(); it != possibleQuadrants.end(); ++it) {
-				//here we're checking to see if this possible quadrant is one of the existing quadrants
-				// and if it is then we add its QuadTree to the vector we're returning
-				//how about we try creating the quadrant if it does not already exist
-		iter = trees.find(*it);
-		if(iter != trees.end() && iter->second->PossiblyNear(c,r)){
-			nearbyQuadrants.push_back(iter->second);
+ * \param quadrants [out] Cleared, then filled with the QuadTrees that could be within r.
+ */
+void SpriteManager::GetQuadrantsNear( Coordinate c, float r, vector<QuadTree*> &quadrants ) {
+	// The possible quadrants are the cells that overlap the square around c
+	// Of those, only the trees that exist and that could be within r are returned
+	QuadTree *tree;
+	int minX, minY, maxX, maxY;
+
+	quadrants.clear();
+
+	GetQuadrantCell( c - Coordinate(r,r), &minX, &minY );
+	GetQuadrantCell( c + Coordinate(r,r), &maxX, &maxY );
+
+	// When the search covers more cells than there are quadrants, just check every quadrant
+	if( double(maxX - minX + 1) * double(maxY - minY + 1) > double(trees.size()) ) {
+		for( int pos = 0; pos < trees.capacity(); ++pos ) {
+			if( trees.active(pos) && trees.element(pos).tree->PossiblyNear(c,r) ) {
+				quadrants.push_back( trees.element(pos).tree );
+			}
+		}
+		return;
+	}
+
+	for( int x = minX; x <= maxX; x++ ) {
+		for( int y = minY; y <= maxY; y++ ) {
+			tree = FindQuadrant( x, y );
+			if( tree != NULL && tree->PossiblyNear(c,r) ) {
+				quadrants.push_back( tree );
+			}
 		}
 	}
-	return nearbyQuadrants;
 }
 
-/**\brief Returns a list of sprites that are near coordinate.
+/**\brief Retrieves the sprites that are near a coordinate.
+ * \param sprites [out] Cleared, then filled with the Sprites within r of c.
  * \param c Coordinate
  * \param r Radius
- * \return std::list of Sprite pointers.
+ * \param type A DRAW_ORDER mask used to filter for desired Sprite types.
+ * \param sortByDistance When true the Sprites are sorted nearest first.
+ * \param maxCount When non-zero only this many of the nearest Sprites are kept, nearest first.
+ * \details The caller owns the vector; reusing it between calls avoids any allocation.
+ *  Sorting is skipped unless it is asked for, and a k-nearest query only partially sorts.
  */
-list<Sprite*> *SpriteManager::GetSpritesNear(Coordinate c, float r, int type) {
-	list<Sprite*> *sprites = new list<Sprite*>();
-	
+void SpriteManager::GetSpritesNear(vector<Sprite*> &sprites, Coordinate c, float r, int type, bool sortByDistance, unsigned int maxCount) {
+	vector<QuadTree*> &quadrants = GetSearchBuffer();
+	vector<QuadTree*>::iterator it;
+	sprites.clear();
+
 	// Search the possible quadrants
-	list<QuadTree*> nearbyQuadrants = GetQuadrantsNear(c,r);
-	list<QuadTree*>::iterator it;
-	for(it = nearbyQuadrants.begin(); it != nearbyQuadrants.end(); ++it) {
-			list<Sprite *>* nearby = new list<Sprite*>;
-			(*it)->GetSpritesNear(c,r,nearby,type);
-			sprites->splice(sprites->end(), *nearby);
-			delete nearby;
+	GetQuadrantsNear( c, r, quadrants );
+	for(it = quadrants.begin(); it != quadrants.end(); ++it) {
+		(*it)->GetSpritesNear( c, r, sprites, type );
 	}
 
 	// Sort sprites by their distance from the coordinate c
-	sprites->sort(compareSpriteDistFromPoint(c));
-	return( sprites );
+	if( maxCount > 0 && sprites.size() > maxCount ) {
+		partial_sort( sprites.begin(), sprites.begin() + maxCount, sprites.end(), compareSpriteDistFromPoint(c) );
+		sprites.resize( maxCount );
+	} else if( sortByDistance || maxCount > 0 ) {
+		sort( sprites.begin(), sprites.end(), compareSpriteDistFromPoint(c) );
+	}
 }
 
 Sprite* SpriteManager::GetNearestSprite(Sprite* obj, float r, int type) {
@@ -409,9 +593,10 @@ Sprite* SpriteManager::GetNearestSprite(Sprite* obj, float r, int type) {
 	Sprite* possible=NULL;
 	if(obj==NULL)
 		return (Sprite*)NULL;
-	list<QuadTree*> nearbyQuadrants = GetQuadrantsNear(obj->GetWorldPosition(),r);
-	list<QuadTree*>::iterator it;
-	for(it = nearbyQuadrants.begin(); it != nearbyQuadrants.end(); ++it) {
+	vector<QuadTree*> &quadrants = GetSearchBuffer();
+	vector<QuadTree*>::iterator it;
+	GetQuadrantsNear( obj->GetWorldPosition(), r, quadrants );
+	for(it = quadrants.begin(); it != quadrants.end(); ++it) {
 		possible = (*it)->GetNearestSprite(obj,r, type);
 		if(possible!=NULL) {
 			tmpdist = (obj->GetWorldPosition()-possible->GetWorldPosition()).GetMagnitude();
@@ -424,6 +609,106 @@ Sprite* SpriteManager::GetNearestSprite(Sprite* obj, float r, int type) {
 	return closest;
 }
 
+/**\brief Orders Sprites by their X position (Internal use).
+ */
+static bool compareSpriteX( Sprite *a, Sprite *b ) {
+	return a->GetWorldPosition().GetX() < b->GetWorldPosition().GetX();
+}
+
+/**\brief Orders a Sprite against an X position (Internal use).
+ */
+static bool compareSpriteXToValue( Sprite *a, double x ) {
+	return a->GetWorldPosition().GetX() < x;
+}
+
+/**\brief Orders Contacts by Sprite, then by distance (Internal use).
+ */
+static bool compareContacts( const Contact &a, const Contact &b ) {
+	if( a.sprite != b.sprite ) {
+		return a.sprite < b.sprite;
+	}
+	return a.distance < b.distance;
+}
+
+/**\brief Broad phase collision pass (Internal use).
+ * \details
+ * Ships and Players are sorted along the X axis once per tick.
+ * Each Projectile and Gate then only checks the slice of Ships that overlaps
+ * its search radius on that axis (sweep and prune), rather than walking the
+ * QuadTrees around it.  The resulting Contact pairs are kept until the end of
+ * the tick so that Sprites can look them up during their Update.
+ *
+ * Sprites created during this tick will not have any Contacts until the next.
+ */
+void SpriteManager::FindContacts() {
+	list<Sprite*>::iterator i;
+	vector<Sprite*>::iterator t;
+	float radius;
+	int drawOrder;
+
+	contacts.clear();
+	contactTargets.clear();
+	for( i = spritelist->begin(); i != spritelist->end(); ++i ) {
+		if( (*i)->GetDrawOrder() & (DRAW_ORDER_SHIP | DRAW_ORDER_PLAYER) ) {
+			contactTargets.push_back( *i );
+		}
+	}
+	if( contactTargets.empty() ) {
+		return;
+	}
+	sort( contactTargets.begin(), contactTargets.end(), compareSpriteX );
+
+	for( i = spritelist->begin(); i != spritelist->end(); ++i ) {
+		drawOrder = (*i)->GetDrawOrder();
+		if( drawOrder & DRAW_ORDER_WEAPON ) {
+			radius = CONTACT_RADIUS_PROJECTILE;
+		} else if( drawOrder & DRAW_ORDER_GATE_TOP ) {
+			radius = CONTACT_RADIUS_GATE;
+		} else {
+			continue;
+		}
+
+		Coordinate pos = (*i)->GetWorldPosition();
+		t = lower_bound( contactTargets.begin(), contactTargets.end(), pos.GetX() - radius, compareSpriteXToValue );
+		for( ; t != contactTargets.end(); ++t ) {
+			Coordinate offset = (*t)->GetWorldPosition() - pos;
+			if( offset.GetX() > radius ) {
+				break;
+			}
+			if( fabs( offset.GetY() ) > radius ) {
+				continue;
+			}
+			float distance = offset.GetMagnitude();
+			if( distance < radius ) {
+				Contact contact;
+				contact.sprite = *i;
+				contact.other = *t;
+				contact.distance = distance;
+				contacts.push_back( contact );
+			}
+		}
+	}
+
+	sort( contacts.begin(), contacts.end(), compareContacts );
+}
+
+/**\brief Returns the Contacts found for a Sprite during this tick.
+ * \param obj A Projectile or Gate
+ * \return Range of Contacts, closest first.  Empty if there are none.
+ */
+ContactRange SpriteManager::GetContacts(Sprite *obj) {
+	Contact key;
+	key.sprite = obj;
+	key.other = NULL;
+	key.distance = -1.0f;
+	vector<Contact>::iterator first = lower_bound( contacts.begin(), contacts.end(), key, compareContacts );
+	vector<Contact>::iterator last = first;
+	while( last != contacts.end() && last->sprite == obj ) {
+		++last;
+	}
+	return make_pair( first, last );
+}
+
 /**\brief Returns QuadTree center.
  * \param point Coordinate
  * \return Coordinate of centerpointer
@@ -431,19 +716,42 @@ Sprite* SpriteManager::GetNearestSprite(Sprite* obj, float r, int type) {
 Coordinate SpriteManager::GetQuadrantCenter(Coordinate point){
 	// Figure out where the new Tree should go.
 	// Quadrants are tiled adjacent to the central Quadrant centered at (0,0).
-	double cx, cy;
-	cx = float(floor( (point.GetX()+QUADRANTSIZE)/(QUADRANTSIZE*2.0f)) * QUADRANTSIZE*2.f);
-	cy = float(floor( (point.GetY()+QUADRANTSIZE)/(QUADRANTSIZE*2.0f)) * QUADRANTSIZE*2.f);
-	return Coordinate(cx,cy);
+	int x, y;
+	GetQuadrantCell( point, &x, &y );
+	return Coordinate( x * QUADRANTSIZE*2.f, y * QUADRANTSIZE*2.f );
+}
+
+/**\brief Returns the integer cell position of the QuadTree that contains a point (Internal use)
+ * \param point Coordinate
+ * \param x [out] Cell column
+ * \param y [out] Cell row
+ */
+void SpriteManager::GetQuadrantCell( Coordinate point, int *x, int *y ) {
+	*x = static_cast<int>(floor( (point.GetX()+QUADRANTSIZE)/(QUADRANTSIZE*2.0f)));
+	*y = static_cast<int>(floor( (point.GetY()+QUADRANTSIZE)/(QUADRANTSIZE*2.0f)));
+}
+
+/**\brief Returns the QuadTree at a cell position, if there is one (Internal use)
+ * \param x Cell column
+ * \param y Cell row
+ * \return The QuadTree, or NULL if that quadrant doesn't exist.
+ */
+QuadTree* SpriteManager::FindQuadrant( int x, int y ) {
+	QuadrantCell cell( x, y );
+	if( trees.contains( cell ) ) {
+		return cell.tree;
+	}
+	return NULL;
 }
 
 /**\brief Gets the number of Sprites in the SpriteManager
  */
 int SpriteManager::GetNumSprites() {
 	unsigned int total = 0;
-	map<Coordinate,QuadTree*>::iterator iter;
-	for ( iter = trees.begin(); iter != trees.end(); ++iter ) { 
-		total += iter->second->Count();
+	for ( int pos = 0; pos < trees.capacity(); ++pos ) { 
+		if( trees.active(pos) ) {
+			total += trees.element(pos).tree->Count();
+		}
 	}
 	assert( total == spritelist->size() );
 	assert( total == spritelookup->size() );
@@ -454,21 +762,22 @@ int SpriteManager::GetNumSprites() {
  * \param point Coordinate
  */
 QuadTree* SpriteManager::GetQuadrant( Coordinate point ) {
-	Coordinate treeCenter = GetQuadrantCenter(point);
+	int x, y;
+	GetQuadrantCell( point, &x, &y );
 
 	// Check in the known Quadrant
-	map<Coordinate,QuadTree*>::iterator iter;
-	iter = trees.find( treeCenter );
-	if( iter != trees.end() ) {
-		return iter->second;
+	QuadTree *tree = FindQuadrant( x, y );
+	if( tree != NULL ) {
+		return tree;
 	}
 
 	// Create the new Tree and attach it to the universe
+	Coordinate treeCenter( x * QUADRANTSIZE*2.f, y * QUADRANTSIZE*2.f );
 	QuadTree *newTree = new QuadTree(treeCenter, QUADRANTSIZE);
 	assert(treeCenter == newTree->GetCenter() );
 	assert(newTree->Contains(point));
-	trees.insert(make_pair(treeCenter, newTree));
-	AdjustBoundaries();
+	trees.insert( QuadrantCell( x, y, newTree ) );
+	AdjustBoundaries( x, y, +1 );
 
 	// Debug
 	//cout<<"A Tree at "<<treeCenter<<" was created to contain "<<point<<". "<<trees.size()<<" Quadrants exist now."<<endl;
@@ -485,23 +794,31 @@ void SpriteManager::GetBoundaries(float *_northEdge, float *_southEdge, float *_
 	*_westEdge  = westEdge;
 }
 
-void SpriteManager::AdjustBoundaries()
+/**\brief Keeps the boundaries up to date as quadrants are created and deleted (Internal use)
+ * \param x Cell column of the quadrant
+ * \param y Cell row of the quadrant
+ * \param change +1 when the quadrant was created, -1 when it was deleted
+ * \details
+ * The boundaries are the furthest quadrant centers in each direction,
+ * and always include the origin.
+ */
+void SpriteManager::AdjustBoundaries( int x, int y, int change )
 {
-	Coordinate c;
-	map<Coordinate,QuadTree*>::iterator iter;
+	if( (quadrantColumns[x] += change) == 0 ) quadrantColumns.erase(x);
+	if( (quadrantRows[y] += change) == 0 ) quadrantRows.erase(y);
 
 	northEdge = southEdge = eastEdge = westEdge = 0;
-	for ( iter = trees.begin(); iter != trees.end(); ++iter ) { 
-		c = iter->first;
-		if( c.GetY() > northEdge) northEdge = c.GetY();
-		if( c.GetY() < southEdge) southEdge = c.GetY();
-		if( c.GetX() > eastEdge)  eastEdge  = c.GetX();
-		if( c.GetX() < westEdge)  westEdge  = c.GetX();
+	if( !quadrantRows.empty() ) {
+		northEdge = max( 0.f, quadrantRows.rbegin()->first * QUADRANTSIZE*2.f );
+		southEdge = min( 0.f, quadrantRows.begin()->first * QUADRANTSIZE*2.f );
+	}
+	if( !quadrantColumns.empty() ) {
+		eastEdge = max( 0.f, quadrantColumns.rbegin()->first * QUADRANTSIZE*2.f );
+		westEdge = min( 0.f, quadrantColumns.begin()->first * QUADRANTSIZE*2.f );
 	}
 }
 
 void SpriteManager::Save() {
-	map<Coordinate,QuadTree*>::iterator iter;
     xmlDocPtr doc = NULL;       /* document pointer */
     xmlNodePtr root_node = NULL;/* node pointers */
 
@@ -509,8 +826,10 @@ void SpriteManager::Save() {
     root_node = xmlNewNode(NULL, BAD_CAST "Sprites" );
     xmlDocSetRootElement(doc, root_node);
 
-	for ( iter = trees.begin(); iter != trees.end(); ++iter ) { 
-		xmlAddChild( root_node, iter->second->ToNode() );
+	for ( int pos = 0; pos < trees.capacity(); ++pos ) { 
+		if( trees.active(pos) ) {
+			xmlAddChild( root_node, trees.element(pos).tree->ToNode() );
+		}
 	}
 
 	xmlSaveFormatFileEnc( "Sprites.xml" , doc, "ISO-8859-1", 1);
@@ -526,18 +845,13 @@ void SpriteManager::UpdateTickCount ()
 		tickCount -= fullUpdatePeriod;
 }
 
-		//this is shit and not very efficient, but std::transform doesn't work...
-		// (if for some reason we got transform working, the idea would be to have
-		//   a helper method to get map->second to pass as the 4th argument of transform
-		//   with the third argument being a back_inserter into the list we want)
-void SpriteManager::GetAllQuadrants (list<QuadTree*> *newList)
+/**\brief Collects every quadrant (Internal use)
+ */
+void SpriteManager::GetAllQuadrants (vector<QuadTree*> *newList)
 {
-	map<Coordinate,QuadTree*>::iterator mapIter = trees.begin();
-	while (mapIter != trees.end())
-	{
-		newList->push_back (mapIter->second);
-		++ mapIter;
+	for ( int pos = 0; pos < trees.capacity(); ++pos ) {
+		if( trees.active(pos) ) {
+			newList->push_back( trees.element(pos).tree );
+		}
 	}
 }
-
-
@@ -10,8 +10,71 @@
 #define __H_SPRITEMANAGER__
 
 #include "Sprites/sprite.h"
+#include "Utilities/hashtbl.h"
 #include "Utilities/quadtree.h"
+#include "Utilities/workerpool.h"
 
+// Search radii used by the broad phase collision pass
+#define CONTACT_RADIUS_PROJECTILE      100 ///< Projectiles look this far for Ships to hit
+#define CONTACT_RADIUS_GATE            50  ///< Gates look this far for Ships to teleport
+
+/**\brief A pair of Sprites that the broad phase found close to each other.
+ */
+struct Contact {
+	Sprite *sprite; ///< The Projectile or Gate that collides.
+	Sprite *other;  ///< The Ship or Player that it collides with.
+	float distance; ///< Distance between the two when the pair was found.
+};
+typedef pair<vector<Contact>::iterator,vector<Contact>::iterator> ContactRange;
+
+/**\brief A quadrant in the SpriteManager's HashTable, keyed by its integer cell position.
+ * \details
+ * Cell (0,0) is the quadrant centered at (0,0).  Its neighbours are (1,0), (0,1), (-1,0) and (0,-1).
+ */
+struct QuadrantCell {
+	int x, y;
+	QuadTree *tree;
+
+	QuadrantCell( int _x = 0, int _y = 0, QuadTree *_tree = NULL ) : x(_x), y(_y), tree(_tree) {}
+	int hash( void ) const {
+		return static_cast<int>( (static_cast<unsigned int>(x) * 73856093u) ^ (static_cast<unsigned int>(y) * 19349663u) );
+	}
+	bool operator!=( const QuadrantCell &other ) const {
+		return (x != other.x) || (y != other.y);
+	}
+};
+
+// Sprites of these types only change themselves during their Update (anything else goes through the SpriteManager),
+// so they can be updated on worker threads.  All other Sprites are updated on the main thread.
+#define DRAW_ORDER_PARALLEL            (DRAW_ORDER_WEAPON | DRAW_ORDER_EFFECT)
+
+/**\brief A change to the SpriteManager that was requested by a worker thread.
+ */
+struct SpriteCommand {
+	enum CommandType {
+		ADD_SPRITE,    ///< Add the Sprite.
+		DELETE_SPRITE, ///< Delete the Sprite.
+		DAMAGE_SHIP,   ///< Damage the Ship.
+		ADD_EFFECT     ///< Create an Effect.
+	} type;
+	Sprite *sprite;      ///< The Sprite to Add, Delete or Damage.
+	short int damage;    ///< Damage to deal to the Ship.
+	Coordinate position; ///< Where the Effect starts.
+	Coordinate momentum; ///< How the Effect moves.
+	float angle;         ///< The Angle of the Effect.
+	string animation;    ///< The Animation file of the Effect.
+};
+
+/**\brief Seconds spent in each stage of SpriteManager::Update.
+ */
+struct UpdateTimes {
+	int ticks;        ///< Updates that were timed.
+	double contacts;  ///< Finding the Sprites that might collide.
+	double sprites;   ///< Updating the Sprites themselves, including the AI.
+	double rebalance; ///< Moving Sprites between quadrants, deleting them and rebalancing the quadrants.
+
+	UpdateTimes() : ticks(0), contacts(0), sprites(0), rebalance(0) {}
+};
 
 class SpriteManager {
 	public:
@@ -20,15 +83,22 @@ class SpriteManager {
 		
 		void Add( Sprite *sprite );
 		bool Delete( Sprite *sprite );
+		void AddEffect( Coordinate position, string animation, float angle, Coordinate momentum );
+		void Damage( Sprite *ship, short int damage );
+
+		void SetThreads( int numThreads );
 		
 		void Update(bool lowFps);
+		void SetTiming( bool _timing ) { timing = _timing; times = UpdateTimes(); }
+		UpdateTimes GetTimes() { return times; }
 		void Draw();
 		void DrawQuadrantMap();
 
 		Sprite *GetSpriteByID(int id);
-		list<Sprite*> *GetSprites(int type = DRAW_ORDER_ALL);
-		list<Sprite*> *GetSpritesNear(Coordinate c, float r, int type = DRAW_ORDER_ALL);
+		void GetSprites(vector<Sprite*> &sprites, int type = DRAW_ORDER_ALL);
+		void GetSpritesNear(vector<Sprite*> &sprites, Coordinate c, float r, int type = DRAW_ORDER_ALL, bool sortByDistance = false, unsigned int maxCount = 0);
 		Sprite* GetNearestSprite(Sprite *obj, float r, int type = DRAW_ORDER_ALL);
+		ContactRange GetContacts(Sprite *obj);
 
 		Coordinate GetQuadrantCenter( Coordinate point );
 		int GetNumQuadrants() { return trees.size(); }
@@ -41,13 +111,15 @@ class SpriteManager {
 		SpriteManager();
 	private:
 		// Use the tree when referring to the sprites at a location.
-		map<Coordinate,QuadTree*> trees;
+		HashTable<QuadrantCell> trees;
+		// The number of quadrants in each column and row of cells, used to keep the boundaries.
+		map<int,int> quadrantColumns, quadrantRows;
 		// Use the list when referring to all sprites.
 		list<Sprite*> *spritelist;
 		// Use the map when referring to sprites by their unique ID.
 		map<int,Sprite*> *spritelookup;
 		
-		list<Sprite *> spritesToDelete;
+		vector<Sprite *> spritesToDelete;
 		static SpriteManager *pInstance;
 
 				//counts number of ticks to track updates to quadrants
@@ -63,15 +135,43 @@ class SpriteManager {
 
 		float northEdge, southEdge, eastEdge, westEdge;
 
+		bool timing; ///< Whether Update should measure its stages.
+		UpdateTimes times; ///< The total time of each stage since timing was turned on.
+
+		// Broad phase collision state, rebuilt every tick but never shrunk.
+		vector<Sprite*> contactTargets; ///< Ships and Players sorted by X.
+		vector<Contact> contacts; ///< Contact pairs sorted by Sprite then distance.
+
+		// Reused by every Update so that a steady tick doesn't allocate.
+		vector<QuadTree*> quadList; ///< The quadrants being updated this tick.
+		vector<Sprite*> outOfBounds; ///< Sprites that left their quadrant this tick.
+		vector<QuadTree*> nearbyQuadrants; ///< The quadrants searched by the main thread's current query.
+		vector<Sprite*> onscreen; ///< The Sprites being drawn this frame.
+
+		// Parallel update state.  Each buffer belongs to one quadrant of quadList.
+		WorkerPool *workers; ///< NULL when every Sprite is updated on the main thread.
+		vector<int> workerJobs; ///< The quadrant that each worker thread is updating.
+		vector< vector<SpriteCommand> > commandBuffers; ///< Changes requested while updating each quadrant.
+		vector< vector<Sprite*> > serialSprites; ///< Sprites in each quadrant that must be updated on the main thread.
+		vector< vector<QuadTree*> > workerQuadrants; ///< The quadrants searched by each worker thread's current query.
+
 		bool DeleteSprite( Sprite *sprite );
 		void DeleteEmptyQuadrants( void );
 		QuadTree* GetQuadrant( Coordinate point );
-		list<QuadTree*> GetQuadrantsNear( Coordinate c, float r);
-		list<QuadTree*> GetQuadrantsInBand ( Coordinate c, int bandIndex);
-		void AdjustBoundaries();
+		QuadTree* FindQuadrant( int x, int y );
+		void GetQuadrantCell( Coordinate point, int *x, int *y );
+		void GetQuadrantsNear( Coordinate c, float r, vector<QuadTree*> &quadrants );
+		void GetQuadrantsInBand( Coordinate c, int bandIndex, vector<QuadTree*> &quadrants );
+		void AdjustBoundaries( int x, int y, int change );
 		void UpdateTickCount();
+		void FindContacts();
+		void UpdateInParallel();
+		static void UpdateQuadrant( void *spriteManager, int job );
+		vector<SpriteCommand> *GetCommandBuffer();
+		vector<QuadTree*> &GetSearchBuffer();
+		void RunCommands( vector<SpriteCommand> &commands );
 
-		void GetAllQuadrants (list<QuadTree*> *newTree);
+		void GetAllQuadrants (vector<QuadTree*> *newTree);
 };
 
 #endif // __H_SPRITEMANAGER__
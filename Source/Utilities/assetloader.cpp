@@ -0,0 +1,381 @@
+/**\file			assetloader.cpp
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Reads and decodes Images, Anis and Sounds in the background
+ * \details
+ */
+
+#include "includes.h"
+#include "common.h"
+#include "Utilities/assetloader.h"
+#include "Audio/sound.h"
+#include "Graphics/animation.h"
+#include "Graphics/image.h"
+#include "Utilities/file.h"
+#include "Utilities/log.h"
+#include "Utilities/snapshot.h"
+#include "Utilities/timer.h"
+#include "Utilities/xml.h"
+
+/**\class AssetLoader
+ * \brief Reads and decodes Images, Anis and Sounds on worker threads.
+ * \details
+ * Prefetch queues a file.  The worker threads read and decode the queued
+ * files in batches, which leaves SDL surfaces.  Turning a surface into a
+ * texture has to happen on the main thread, so Update does that once per
+ * frame until "options/simulation/asset-budget" microseconds have passed.
+ * Finished assets are stored as normal Resources.
+ *
+ * SDL_mixer isn't thread safe, so the workers only read Sounds into memory
+ * and they are decoded along with the uploads on the main thread.
+ *
+ * Image::Get, Ani::Get and Sound::Get Claim an asset that is still pending,
+ * which finishes it immediately, waiting for the workers if they have it.
+ * So code that asks for a Resource always gets a complete one; prefetching
+ * just means that the work has usually been done by then.
+ *
+ * PrefetchManifest queues every file named in a components file (models,
+ * weapons, engines, outfits or planets), so the Simulation can start
+ * decoding everything before it parses the components that use them.
+ *
+ * Images and frames that are in the ImageCache are not decoded at all.
+ *
+ * With "options/simulation/asset-threads" at 0 there are no workers, and a
+ * Prefetch loads the file right away.
+ */
+
+WorkerPool *AssetLoader::workers = NULL;
+deque<Asset*> AssetLoader::queue;
+vector<Asset*> AssetLoader::batch;
+list<Asset*> AssetLoader::decoded;
+map<string,Asset*> AssetLoader::pending[RESOURCE_TYPES];
+
+static OptionHandle<int> budget("options/simulation/asset-budget");
+
+/**\brief Starts the worker threads.
+ * \param numThreads Number of threads.  With 0, nothing is loaded in the background.
+ */
+bool AssetLoader::Init( int numThreads ) {
+	if( workers != NULL ) {
+		return true;
+	}
+	if( numThreads < 1 ) {
+		return false;
+	}
+
+	workers = new WorkerPool( numThreads );
+	if( workers->GetNumThreads() == 0 ) {
+		LogMsg(WARN, "Assets will be loaded on the main thread." );
+		delete workers;
+		workers = NULL;
+		return false;
+	}
+	return true;
+}
+
+/**\brief Stops the worker threads and forgets anything that wasn't finished.
+ */
+void AssetLoader::Close( void ) {
+	if( workers == NULL ) {
+		return;
+	}
+	workers->Wait();
+	delete workers;
+	workers = NULL;
+
+	for( int type = 0; type < RESOURCE_TYPES; type++ ) {
+		map<string,Asset*>::iterator a;
+		for( a = pending[type].begin(); a != pending[type].end(); ++a ) {
+			Discard( a->second );
+		}
+		pending[type].clear();
+	}
+	queue.clear();
+	batch.clear();
+	decoded.clear();
+}
+
+/**\brief Starts loading a file in the background.
+ * \param type What kind of Resource the file is.  Only Images, Anis and Sounds can be prefetched.
+ * \param path The same path that will be passed to Get.
+ */
+void AssetLoader::Prefetch( ResourceType type, const string& path ) {
+	if( path == "" ) {
+		return;
+	}
+
+	if( workers == NULL ) {
+		switch( type ) {
+			case RESOURCE_IMAGE: Image::Get( path ); break;
+			case RESOURCE_ANIMATION: Ani::Get( path ); break;
+			case RESOURCE_SOUND: Sound::Get( path ); break;
+			default: break;
+		}
+		return;
+	}
+
+	if( type != RESOURCE_IMAGE && type != RESOURCE_ANIMATION && type != RESOURCE_SOUND ) {
+		LogMsg(WARN, "Cannot prefetch '%s'.", path.c_str() );
+		return;
+	}
+	if( Resource::Get( type, path ) != NULL || pending[type].find( path ) != pending[type].end() ) {
+		return;
+	}
+	// Cached Images don't need to be decoded
+	CachedImage cached;
+	if( type == RESOURCE_IMAGE && ImageCache::Find( path, &cached ) ) {
+		return;
+	}
+
+	Asset *asset = new Asset;
+	asset->state = Asset::QUEUED;
+	asset->type = type;
+	asset->path = path;
+	asset->delay = 0;
+	asset->buffer = NULL;
+	asset->length = 0;
+	pending[type][path] = asset;
+	queue.push_back( asset );
+
+	Pump();
+}
+
+/**\brief Prefetches every Image, Ani and Sound named in a components file.
+ * \param filename A models, weapons, engines, outfits or planets file.
+ */
+void AssetLoader::PrefetchManifest( const string& filename ) {
+	xmlDocPtr doc;
+
+	if( workers == NULL ) {
+		return;
+	}
+
+	// The snapshot has the same elements and is far quicker to read
+	SnapshotReader snapshot;
+	if( snapshot.Open( SnapshotName( filename ), filename ) ) {
+		xmlNodePtr node;
+		doc = xmlNewDoc( BAD_CAST "1.0" );
+		while( (node = snapshot.NextComponent( doc )) != NULL ) {
+			PrefetchNodes( doc, node );
+			xmlFreeNode( node );
+		}
+		xmlFreeDoc( doc );
+		return;
+	}
+
+	File xmlfile;
+	if( !xmlfile.OpenRead( filename ) ) {
+		return;
+	}
+	doc = xmlReadIO( ReadXMLFromFile, NULL, &xmlfile, filename.c_str(), NULL, 0 );
+	if( doc == NULL ) {
+		return;
+	}
+
+	PrefetchNodes( doc, xmlDocGetRootElement( doc ) );
+	xmlFreeDoc( doc );
+}
+
+/**\brief Prefetches the files named by a node and its children (Internal use)
+ * \details The element names match the ones that the components read.
+ */
+void AssetLoader::PrefetchNodes( xmlDocPtr doc, xmlNodePtr node ) {
+	for( ; node != NULL; node = node->next ) {
+		if( node->type != XML_ELEMENT_NODE ) {
+			continue;
+		}
+		const char *name = (const char *)node->name;
+		if( !strcmp( name, "image" ) || !strcmp( name, "imageName" ) || !strcmp( name, "picName" ) ) {
+			Prefetch( RESOURCE_IMAGE, NodeToString( doc, node ) );
+		} else if( !strcmp( name, "flareAnimation" ) ) {
+			Prefetch( RESOURCE_ANIMATION, NodeToString( doc, node ) );
+		} else if( !strcmp( name, "thrustSound" ) ) {
+			Prefetch( RESOURCE_SOUND, NodeToString( doc, node ) );
+		} else if( !strcmp( name, "sound" ) ) {
+			// Weapon sounds may leave out their folder
+			string pathPrefix = "Resources/Audio/Weapons/";
+			string value = NodeToString( doc, node );
+			if( value.find( pathPrefix ) != 0 ) {
+				value.insert( 0, pathPrefix );
+			}
+			Prefetch( RESOURCE_SOUND, value );
+		} else {
+			PrefetchNodes( doc, node->xmlChildrenNode );
+		}
+	}
+}
+
+/**\brief Finishes a pending asset right away.
+ * \details If a worker is decoding it, this waits for the worker.  There
+ * is no placeholder to hand out instead, because Sprite::SetImage and the
+ * Ship's weapon slots read the size of an Image as soon as they get it, and
+ * keep it.
+ * \return false if the asset was never prefetched.
+ */
+bool AssetLoader::Claim( ResourceType type, const string& path ) {
+	if( workers == NULL ) {
+		return false;
+	}
+	map<string,Asset*>::iterator found = pending[type].find( path );
+	if( found == pending[type].end() ) {
+		return false;
+	}
+	Asset *asset = found->second;
+
+	// Decode it in the next batch
+	if( asset->state == Asset::QUEUED ) {
+		queue.erase( find( queue.begin(), queue.end(), asset ) );
+		queue.push_front( asset );
+	}
+	while( asset->state != Asset::DECODED ) {
+		workers->Wait();
+		Pump();
+	}
+
+	decoded.remove( asset );
+	Finish( asset );
+	return true;
+}
+
+/**\brief Uploads the decoded assets until this frame's budget is spent.
+ * \details At least one asset is uploaded per frame.
+ */
+void AssetLoader::Update( void ) {
+	if( workers == NULL ) {
+		return;
+	}
+
+	Pump();
+	double start = Timer::GetRealTime();
+	double limit = budget.Get() / 1000000.0;
+	while( !decoded.empty() ) {
+		Asset *asset = decoded.front();
+		decoded.pop_front();
+		Finish( asset );
+		if( Timer::GetRealTime() - start >= limit ) {
+			break;
+		}
+	}
+	Pump();
+}
+
+/**\brief Collects the last batch and starts the next one, unless the workers are busy (Internal use)
+ */
+void AssetLoader::Pump( void ) {
+	if( workers->IsBusy() ) {
+		return;
+	}
+
+	for( vector<Asset*>::iterator a = batch.begin(); a != batch.end(); ++a ) {
+		(*a)->state = Asset::DECODED;
+		decoded.push_back( *a );
+	}
+	batch.clear();
+
+	unsigned int batchSize = ASSET_BATCH_PER_THREAD * workers->GetNumThreads();
+	while( !queue.empty() && batch.size() < batchSize ) {
+		Asset *asset = queue.front();
+		queue.pop_front();
+		asset->state = Asset::DECODING;
+		batch.push_back( asset );
+	}
+	if( !batch.empty() ) {
+		workers->Start( DecodeAsset, NULL, batch.size() );
+	}
+}
+
+/**\brief Worker job that reads and decodes one asset of the batch (Internal use)
+ * \details Only the asset itself is touched here.
+ */
+void AssetLoader::DecodeAsset( void *unused, int job ) {
+	Asset *asset = batch[job];
+
+	switch( asset->type ) {
+		case RESOURCE_IMAGE: {
+			File file = File();
+			if( !file.OpenRead( asset->path ) ) {
+				break;
+			}
+			char *buffer = file.Read();
+			if( buffer == NULL ) {
+				break;
+			}
+			SDL_Surface *s = Image::Decode( buffer, file.GetLength() );
+			delete [] buffer;
+			if( s != NULL ) {
+				asset->surfaces.push_back( s );
+			}
+			break;
+		}
+		case RESOURCE_ANIMATION:
+			Ani::Decode( asset->path, asset->delay, asset->surfaces, asset->cached );
+			break;
+		case RESOURCE_SOUND: {
+			File file = File();
+			if( !file.OpenRead( asset->path ) ) {
+				break;
+			}
+			asset->buffer = file.Read();
+			asset->length = ( asset->buffer != NULL ) ? file.GetLength() : 0;
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+/**\brief Turns a decoded asset into a Resource and forgets it (Internal use)
+ * \details If it couldn't be decoded, nothing is stored and Get will try the file again.
+ */
+void AssetLoader::Finish( Asset *asset ) {
+	assert( asset->state == Asset::DECODED );
+	pending[asset->type].erase( asset->path );
+
+	switch( asset->type ) {
+		case RESOURCE_IMAGE:
+			if( !asset->surfaces.empty() ) {
+				Image *image = new Image();
+				if( image->Load( asset->surfaces[0], asset->path ) ) {
+					Resource::Store( RESOURCE_IMAGE, asset->path, (Resource*)image );
+				} else {
+					delete image;
+				}
+				asset->surfaces.clear();
+			}
+			break;
+		case RESOURCE_ANIMATION:
+			if( !asset->surfaces.empty() ) {
+				LogMsg(INFO,"New Animation from '%s'", asset->path.c_str() );
+				Ani *ani = new Ani();
+				ani->Load( asset->path, asset->delay, asset->surfaces, asset->cached );
+				Resource::Store( RESOURCE_ANIMATION, asset->path, (Resource*)ani );
+			}
+			break;
+		case RESOURCE_SOUND:
+			if( asset->buffer != NULL ) {
+				Mix_Chunk *chunk = Sound::Decode( asset->path, asset->buffer, asset->length );
+				if( chunk != NULL ) {
+					Sound *sound = new Sound( asset->path, chunk );
+					Resource::Store( RESOURCE_SOUND, asset->path, (Resource*)sound );
+				}
+			}
+			break;
+		default:
+			break;
+	}
+
+	Discard( asset );
+}
+
+/**\brief Frees an asset and anything left in it (Internal use)
+ */
+void AssetLoader::Discard( Asset *asset ) {
+	for( unsigned int s = 0; s < asset->surfaces.size(); s++ ) {
+		if( asset->surfaces[s] != NULL ) {
+			SDL_FreeSurface( asset->surfaces[s] );
+		}
+	}
+	delete [] asset->buffer;
+	delete asset;
+}
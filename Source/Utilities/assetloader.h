@@ -0,0 +1,61 @@
+/**\file			assetloader.h
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Reads and decodes Images, Anis and Sounds in the background
+ * \details
+ */
+
+#ifndef __H_ASSETLOADER__
+#define __H_ASSETLOADER__
+
+#include "includes.h"
+#include "Graphics/imagecache.h"
+#include "Utilities/resource.h"
+#include "Utilities/workerpool.h"
+
+#define ASSET_BATCH_PER_THREAD 2 ///< Assets that each worker thread decodes per batch.
+
+/**\brief An Image, Ani or Sound that has been asked for but not finished.
+ */
+struct Asset {
+	enum AssetState {
+		QUEUED,   ///< Waiting for a worker.
+		DECODING, ///< Part of the batch that the workers are running.
+		DECODED   ///< Waiting to be uploaded on the main thread.
+	} state;
+	ResourceType type;
+	string path;
+	vector<SDL_Surface*> surfaces; ///< The Image, or the frames of an Ani (NULL for a cached frame).
+	vector<CachedImage> cached;    ///< The frames of an Ani that are in the ImageCache.
+	Uint32 delay;                  ///< The delay of an Ani.
+	char *buffer;                  ///< The Sound's file, which SDL_mixer decodes on the main thread.
+	long length;                   ///< Bytes in buffer.
+};
+
+class AssetLoader {
+	public:
+		static bool Init( int numThreads );
+		static void Close( void );
+		static bool IsEnabled( void ) { return workers != NULL; }
+
+		static void Prefetch( ResourceType type, const string& path );
+		static void PrefetchManifest( const string& filename );
+		static bool Claim( ResourceType type, const string& path );
+		static void Update( void );
+
+	private:
+		static void Pump( void );
+		static void DecodeAsset( void *unused, int job );
+		static void Finish( Asset *asset );
+		static void Discard( Asset *asset );
+		static void PrefetchNodes( xmlDocPtr doc, xmlNodePtr node );
+
+		static WorkerPool *workers;
+		static deque<Asset*> queue;    ///< Assets that no worker has started, in order.
+		static vector<Asset*> batch;   ///< Assets that the workers are decoding.
+		static list<Asset*> decoded;   ///< Assets that are ready to be uploaded, in order.
+		static map<string,Asset*> pending[RESOURCE_TYPES]; ///< Every Asset that isn't finished, by path.
+};
+
+#endif // __H_ASSETLOADER__
@@ -10,6 +10,9 @@
 #include "Utilities/log.h"
 #include "Utilities/file.h"
 #include "Utilities/components.h"
+#include "Utilities/snapshot.h"
+
+static OptionHandle<int> snapshots("options/simulation/component-snapshots");
 
 /**\class Component
  * \brief A generic entity that is loaded and saved to XML
@@ -54,6 +57,14 @@
  * \brief A list of all of the names of the Components that are in the components hashtable.
  * \todo Is there a fast way to get this information out of the hash table rather than storing it explicitely?
  *
+ * \var filepath
+ * \brief The XML file that was loaded, and that Save will write.
+ * \details When "options/simulation/component-snapshots" is set, a binary
+ *          snapshot of the file is kept in the user's directory (see
+ *          SnapshotName).  Load reads the snapshot instead of the XML while
+ *          it is up to date, and writes a new one whenever it has to parse
+ *          the XML.
+ *
  * \fn newComponent
  * \brief A virtual constuctor for the Component Class being stored in this Components Instance.
  * \details This virtual function is used while parseing an XML file.
@@ -135,90 +146,177 @@ bool Components::ParseXMLNode( xmlDocPtr doc, xmlNodePtr node )
 	return false;
 }
 
+/**\brief Warn about a file written by a different version of Epiar
+ */
+static void CheckVersion( const string& filename, int versionMajor, int versionMinor, int versionMacro ) {
+	if( ( versionMajor != EPIAR_VERSION_MAJOR ) ||
+	    ( versionMinor != EPIAR_VERSION_MINOR ) ||
+	    ( versionMacro != EPIAR_VERSION_MICRO ) ) {
+		LogMsg(WARN, "File '%s' is version %d.%d.%d. This may cause problems since it does not match the current version %d.%d.%d.",
+			filename.c_str(),
+			versionMajor, versionMinor, versionMacro,
+			EPIAR_VERSION_MAJOR, EPIAR_VERSION_MINOR, EPIAR_VERSION_MICRO );
+	}
+}
+
 /**\brief Load an XML file
+ * \details The file is parsed while it is read.  Each component element is
+ *          given to ParseXMLNode as soon as it is complete, and is freed once
+ *          the reader moves past it, so only one component is in memory at a
+ *          time.
  * \arg filename The XML file that should be parsed.
  * \arg optional  If this is true, an error is not returned if the file doesn't exist.
  */
 bool Components::Load(string filename, bool optional) {
+	xmlTextReaderPtr reader;
 	xmlDocPtr doc;
-	xmlNodePtr cur, ver;
+	xmlNodePtr cur;
 	int versionMajor = 0, versionMinor = 0, versionMacro = 0;
 	int numObjs = 0;
+	int status;
 	bool success = true;
-	
-	File xmlfile = File (filename);
-	long filelen = xmlfile.GetLength();
-	char *buffer = xmlfile.Read();
-	doc = xmlParseMemory( buffer, static_cast<int>(filelen) );
-	delete [] buffer;
 
 	// This path will be used when saving the file later.
 	filepath = filename;
 
-	if( doc == NULL ) {
+	// Once the snapshot has added anything, the XML must not add it again
+	if( snapshots.Get() && LoadSnapshot( filename, optional, &success ) ) {
+		return success;
+	}
+
+	File xmlfile;
+	if( !xmlfile.OpenRead( filename ) ) {
+		LogMsg(ERR, "Could not load '%s' for parsing.", filename.c_str() );
+		return optional;
+	}
+	reader = xmlReaderForIO( ReadXMLFromFile, NULL, &xmlfile, filename.c_str(), NULL, 0 );
+	if( reader == NULL ) {
 		LogMsg(ERR, "Could not load '%s' for parsing.", filename.c_str() );
 		return optional;
 	}
 
 	LogMsg(INFO, "Loading '%s' for parsing.", filename.c_str() );
-	
-	cur = xmlDocGetRootElement( doc );
-	
-	if( cur == NULL ) {
+
+	// Find the root element
+	while( (status = xmlTextReaderRead( reader )) == 1
+	       && xmlTextReaderNodeType( reader ) != XML_READER_TYPE_ELEMENT ) {
+	}
+	if( status != 1 ) {
 		LogMsg(ERR, "'%s' file appears to be empty.", filename.c_str() );
-		xmlFreeDoc( doc );
-		return false;
+		xmlFreeTextReader( reader );
+		return ( status < 0 ) ? optional : false;
 	}
 	
-	if( xmlStrcmp( cur->name, (const xmlChar *)rootName.c_str() ) ) {
-		LogMsg(ERR, "'%s' appears to be invalid. Root element was %s.", filename.c_str(), (char *)cur->name );
-		xmlFreeDoc( doc );
+	if( xmlStrcmp( xmlTextReaderConstName( reader ), (const xmlChar *)rootName.c_str() ) ) {
+		LogMsg(ERR, "'%s' appears to be invalid. Root element was %s.", filename.c_str(), (char *)xmlTextReaderConstName( reader ) );
+		xmlFreeTextReader( reader );
 		return false;
 	} else {
 		LogMsg(INFO, "'%s' file found and valid, parsing...", filename.c_str() );
 	}
-	
-	// Get the version number
-	if( (ver = FirstChildNamed(cur, "version-major")) != NULL ) {
-		versionMajor = NodeToInt(doc,ver);
-	}
-	if( (ver = FirstChildNamed(cur, "version-minor")) != NULL ) {
-		versionMinor = NodeToInt(doc,ver);
-	}
-	if( (ver = FirstChildNamed(cur, "version-macro")) != NULL ) {
-		versionMacro = NodeToInt(doc,ver);
-	}
-	if( ( versionMajor != EPIAR_VERSION_MAJOR ) ||
-	    ( versionMinor != EPIAR_VERSION_MINOR ) ||
-	    ( versionMacro != EPIAR_VERSION_MICRO ) ) {
-		LogMsg(WARN, "File '%s' is version %d.%d.%d. This may cause problems since it does not match the current version %d.%d.%d.",
-			filename.c_str(),
-			versionMajor, versionMinor, versionMacro,
-			EPIAR_VERSION_MAJOR, EPIAR_VERSION_MINOR, EPIAR_VERSION_MICRO );
-	}
-	
-	// Get the components
-	cur = cur->xmlChildrenNode;
-	while( success && cur != NULL ) {
-		// Parse for the version information and any children nodes
-		if( ( !xmlStrcmp( cur->name, BAD_CAST componentName.c_str() ) ) ) {
+	doc = xmlTextReaderCurrentDoc( reader );
+
+	// Get the version number and the components
+	SnapshotWriter snapshot( rootName );
+	status = xmlTextReaderIsEmptyElement( reader ) ? 0 : xmlTextReaderRead( reader );
+	while( success && status == 1 && xmlTextReaderDepth( reader ) > 0 ) {
+		if( xmlTextReaderNodeType( reader ) != XML_READER_TYPE_ELEMENT ) {
+			status = xmlTextReaderRead( reader );
+			continue;
+		}
+		if( (cur = xmlTextReaderExpand( reader )) == NULL ) {
+			status = -1;
+			break;
+		}
+
+		if( NodeNameIs( cur, "version-major" ) ) {
+			versionMajor = NodeToInt(doc,cur);
+		} else if( NodeNameIs( cur, "version-minor" ) ) {
+			versionMinor = NodeToInt(doc,cur);
+		} else if( NodeNameIs( cur, "version-macro" ) ) {
+			versionMacro = NodeToInt(doc,cur);
+		} else if( NodeNameIs( cur, componentName.c_str() ) ) {
 			// Parse a Component
+			snapshot.Add( cur );
 			success = ParseXMLNode( doc, cur );
 			assert(success || optional);
 			if(success) numObjs++;
 		}
-		
-		cur = cur->next;
+
+		// Skip to the next sibling, which frees this one
+		status = xmlTextReaderNext( reader );
 	}
-	
+
+	// Make sure that the rest of the file is well formed
+	while( success && status == 1 ) {
+		status = xmlTextReaderRead( reader );
+	}
+	// Asking for the document made it ours to free
+	xmlFreeTextReader( reader );
 	xmlFreeDoc( doc );
 
+	if( status < 0 ) {
+		LogMsg(ERR, "Could not parse '%s' after %d objects.", filename.c_str(), numObjs );
+		return optional;
+	}
+	CheckVersion( filename, versionMajor, versionMinor, versionMacro );
+
+	if( success && snapshots.Get() ) {
+		snapshot.SetFileVersion( versionMajor, versionMinor, versionMacro );
+		snapshot.Save( SnapshotName( filename ), filename );
+	}
 	
 	LogMsg(INFO, "Parsing of file '%s' done, found %d objects. File is version %d.%d.%d.", filename.c_str(), numObjs, versionMajor, versionMinor, versionMacro );
 	return success;
 }
 
+/**\brief Load the snapshot of an XML file, if it is up to date
+ * \arg filename The XML file that the snapshot was made from.
+ * \arg optional  If this is true, an error in a Component is not fatal.
+ * \arg success [out] Whether every Component in the snapshot was parsed.
+ * \return false if the snapshot can't be used, before any Component has
+ *         been parsed, so the XML file should be parsed instead.
+ */
+bool Components::LoadSnapshot( const string& filename, bool optional, bool *success ) {
+	SnapshotReader snapshot;
+	xmlDocPtr doc;
+	xmlNodePtr root, cur;
+	int versionMajor, versionMinor, versionMacro;
+	int numObjs = 0;
+
+	if( !snapshot.Open( SnapshotName( filename ), filename ) ) {
+		return false;
+	}
+	if( snapshot.GetRootName() != rootName ) {
+		LogMsg(WARN, "The snapshot of '%s' appears to be invalid. Root element was %s.", filename.c_str(), snapshot.GetRootName().c_str() );
+		return false;
+	}
+	LogMsg(INFO, "Loading '%s' from its snapshot.", filename.c_str() );
+
+	snapshot.GetFileVersion( &versionMajor, &versionMinor, &versionMacro );
+	CheckVersion( filename, versionMajor, versionMinor, versionMacro );
+
+	// Each Component is built, parsed and freed in turn
+	doc = xmlNewDoc( BAD_CAST "1.0" );
+	root = xmlNewDocNode( doc, NULL, BAD_CAST rootName.c_str(), NULL );
+	xmlDocSetRootElement( doc, root );
+	*success = true;
+	while( *success && (cur = snapshot.NextComponent( doc )) != NULL ) {
+		xmlAddChild( root, cur );
+		*success = ParseXMLNode( doc, cur );
+		assert(*success || optional);
+		if(*success) numObjs++;
+		xmlUnlinkNode( cur );
+		xmlFreeNode( cur );
+	}
+	xmlFreeDoc( doc );
+
+	LogMsg(INFO, "Parsing of the snapshot of '%s' done, found %d objects. File is version %d.%d.%d.", filename.c_str(), numObjs, versionMajor, versionMinor, versionMacro );
+	return true;
+}
+
 /**\brief Save all Components to an XML file
+ * \details The snapshot is replaced as well, so that it isn't out of date.
  */
 bool Components::Save() {
 	char buff[10];
@@ -243,6 +341,18 @@ bool Components::Save() {
 
 	LogMsg(INFO, "Saving %s file '%s'", rootName.c_str(), filepath.c_str());
 	xmlSaveFormatFileEnc( filepath.c_str(), doc, "ISO-8859-1", 1);
+
+	if( snapshots.Get() ) {
+		SnapshotWriter snapshot( rootName );
+		snapshot.SetFileVersion( EPIAR_VERSION_MAJOR, EPIAR_VERSION_MINOR, EPIAR_VERSION_MICRO );
+		for( section = root_node->xmlChildrenNode; section != NULL; section = section->next ) {
+			if( NodeNameIs( section, componentName.c_str() ) ) {
+				snapshot.Add( section );
+			}
+		}
+		snapshot.Save( SnapshotName( filepath ), filepath );
+	}
+
 	xmlFreeDoc( doc );
 	return true;
 }
@@ -44,6 +44,7 @@ class Components {
 
 		virtual Component* newComponent() = 0;
 		bool ParseXMLNode( xmlDocPtr doc, xmlNodePtr node );
+		bool LoadSnapshot( const string& filename, bool optional, bool *success );
 		string filepath;
 		string rootName;
 		string componentName;
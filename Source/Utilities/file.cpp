@@ -14,6 +14,12 @@
 #define PHYSFS_getLastError() "FAILED!"
 #endif
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 
 /** \class File
  * Low level file access abstraction through PhysicsFS. */
@@ -116,6 +122,28 @@ bool File::Read( long numBytes, char *buffer ){
 	}
 }
 
+/**Reads up to a number of bytes, stopping early at the end of the file.
+ * \param numBytes Most bytes to read.
+ * \param buffer Buffer to read bytes into.
+ * \return Number of bytes read, 0 at the end of the file, or -1 on error.*/
+long File::ReadUpTo( long numBytes, char *buffer ){
+	if ( fp == NULL )
+		return -1;
+
+#ifdef USE_PHYSICSFS
+	PHYSFS_sint64 bytesRead = PHYSFS_read( fp, buffer, 1, numBytes );
+	if ( bytesRead < 0 ){
+#else
+	size_t bytesRead = fread( buffer, 1, numBytes, fp );
+	if ( bytesRead == 0 && ferror( fp ) ){
+#endif
+		LogMsg(ERR,"%s: Unable to read from file. %s",
+			validName.c_str(), PHYSFS_getLastError());
+		return -1;
+	}
+	return static_cast<long>( bytesRead );
+}
+
 /**Reads the whole file into a buffer. Buffer will be automatically allocated
  * for you, but you must explicitly free it by using "delete [] buffer"
  * \return Pointer to buffer, NULL otherwise.*/
@@ -281,6 +309,36 @@ bool File::Exists( const string& filename ) {
 	return true;
 }
 
+/**Finds when a file was last changed and how long it is, without logging anything.
+ * \param filename The filename path.
+ * \param modTime [out] The last modification time, in seconds.
+ * \param size [out] The number of bytes in the file.
+ * \return false if the file does not exist.*/
+bool File::Stat( const string& filename, long *modTime, long *size ) {
+	const char *cName = filename.c_str();
+#ifdef USE_PHYSICSFS
+	PHYSFS_sint64 changed = PHYSFS_getLastModTime( cName );
+	if( changed < 0 ) {
+		return false;
+	}
+	PHYSFS_file *handle = PHYSFS_openRead( cName );
+	if( handle == NULL ) {
+		return false;
+	}
+	*modTime = static_cast<long>( changed );
+	*size = static_cast<long>( PHYSFS_fileLength( handle ) );
+	PHYSFS_close( handle );
+#else
+	struct stat fileStatus;
+	if( stat( cName, &fileStatus ) != 0 ) {
+		return false;
+	}
+	*modTime = static_cast<long>( fileStatus.st_mtime );
+	*size = static_cast<long>( fileStatus.st_size );
+#endif
+	return true;
+}
+
 bool File::IsDir( const string& filename ) {
 	// TODO: determine if the filename is a directory
 	// This can be used for walking a directory tree
@@ -288,6 +346,89 @@ bool File::IsDir( const string& filename ) {
 	return false;
 }
 
+/** \class MappedFile
+ * Read only view of a whole file, mapped into memory.
+ * \details The file is opened by the OS directly, not through PhysicsFS, so
+ * it must be a real file rather than part of an archive.*/
+
+/**Creates an empty mapping.*/
+MappedFile::MappedFile( void ):
+data(NULL), length(0) {
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	view = NULL;
+#endif
+}
+
+/**Unmaps the file.*/
+MappedFile::~MappedFile() {
+	Close();
+}
+
+/**Maps a file into memory.
+ * \param filename The filename path.
+ * \return true if successful, false if the file is missing or empty.*/
+bool MappedFile::Open( const string& filename ) {
+	Close();
+
+#ifdef _WIN32
+	file = CreateFileA( filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if( file == INVALID_HANDLE_VALUE ) {
+		return false;
+	}
+	length = (long)GetFileSize( file, NULL );
+	if( length > 0 ) {
+		view = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	}
+	if( view != NULL ) {
+		data = (const unsigned char*)MapViewOfFile( view, FILE_MAP_READ, 0, 0, 0 );
+	}
+#else
+	struct stat fileStatus;
+	int fd = open( filename.c_str(), O_RDONLY );
+	if( fd < 0 ) {
+		return false;
+	}
+	if( fstat( fd, &fileStatus ) == 0 && fileStatus.st_size > 0 ) {
+		length = (long)fileStatus.st_size;
+		void *mapped = mmap( NULL, length, PROT_READ, MAP_SHARED, fd, 0 );
+		if( mapped != MAP_FAILED ) {
+			data = (const unsigned char*)mapped;
+		}
+	}
+	close( fd );
+#endif
+
+	if( data == NULL ) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+/**Unmaps the file.  Pointers into it are no longer valid.*/
+void MappedFile::Close( void ) {
+#ifdef _WIN32
+	if( data != NULL ) {
+		UnmapViewOfFile( data );
+	}
+	if( view != NULL ) {
+		CloseHandle( view );
+		view = NULL;
+	}
+	if( file != INVALID_HANDLE_VALUE ) {
+		CloseHandle( file );
+		file = INVALID_HANDLE_VALUE;
+	}
+#else
+	if( data != NULL ) {
+		munmap( (void*)data, length );
+	}
+#endif
+	data = NULL;
+	length = 0;
+}
+
 bool IsBigEndian() {
 	int test_var = 1;
 	unsigned char *test_array = (unsigned char*)&test_var;
@@ -23,6 +23,7 @@ class File {
 		File( const string& filename );
 		~File();
 		bool Read( long numBytes, char *buffer );
+		long ReadUpTo( long numBytes, char *buffer );
 		long GetLength( void );
 		bool Close();
 
@@ -36,6 +37,7 @@ class File {
 
 		static bool Exists( const string& filename );
 		static bool IsDir( const string& filename );
+		static bool Stat( const string& filename, long *modTime, long *size );
 
 	private:
 #ifdef USE_PHYSICSFS
@@ -47,6 +49,28 @@ class File {
 		string validName;		/** Name of the file referenced (exists).*/
 };
 
+class MappedFile {
+	public:
+		MappedFile( void );
+		~MappedFile();
+		bool Open( const string& filename );
+		void Close( void );
+
+		const unsigned char *GetData( void ) { return data; }
+		long GetLength( void ) { return length; }
+
+	private:
+		MappedFile( const MappedFile& );
+		MappedFile& operator= ( const MappedFile& );
+
+		const unsigned char *data;	/** The whole file, or NULL. */
+		long length;			/** Number of bytes in the file. */
+#ifdef _WIN32
+		HANDLE file;
+		HANDLE view;
+#endif
+};
+
 bool IsBigEndian();
 
 #endif // __H_XML__
@@ -11,6 +11,12 @@
 #include "Utilities/filesystem.h"
 #include "Utilities/log.h"
 
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
 list<string> Filesystem::paths;
 
 #ifdef USE_PHYSICSFS
@@ -226,3 +232,57 @@ int Filesystem::DeInit() {
 
 
 #endif
+
+/**Creates a directory unless it is already there (Internal use)
+ * \return true if the directory exists afterwards. */
+static bool MakeDirectory( const string& dir ) {
+#ifdef _WIN32
+	if ( _mkdir( dir.c_str() ) == 0 || errno == EEXIST )
+#else
+	if ( mkdir( dir.c_str(), 0755 ) == 0 || errno == EEXIST )
+#endif
+		return true;
+	LogMsg(WARN,"Could not create the directory %s.", dir.c_str());
+	return false;
+}
+
+/**Finds where Epiar may write a file of its own, such as a cache.
+ * The file is kept in the PhysFS write directory, or else in
+ * $HOME/.Games/Epiar (%APPDATA%\Epiar on Windows), never in the Resources.
+ * \param name The name of the file.  Any folders in it become part of the name.
+ * \return A native path, or "" if there is nowhere to write. */
+string Filesystem::WritablePath( const string& name ) {
+	if ( name == "" )
+		return "";
+
+	string flat = name;
+	std::replace( flat.begin(), flat.end(), '/', '_' );
+	std::replace( flat.begin(), flat.end(), '\\', '_' );
+
+#ifdef USE_PHYSICSFS
+	if ( PHYSFS_getWriteDir() != NULL )
+		return string( PHYSFS_getWriteDir() ) + PHYSFS_getDirSeparator() + flat;
+#endif
+
+#ifdef _WIN32
+	const char *home = getenv( "APPDATA" );
+#else
+	const char *home = getenv( "HOME" );
+#endif
+	if ( home == NULL || home[0] == '\0' ) {
+		LogMsg(WARN,"There is no home directory to write %s in.", name.c_str());
+		return "";
+	}
+
+#ifdef _WIN32
+	string dir = string( home ) + "\\Epiar";
+	if ( !MakeDirectory( dir ) )
+		return "";
+	return dir + "\\" + flat;
+#else
+	string dir = string( home ) + "/.Games";
+	if ( !MakeDirectory( dir ) || !MakeDirectory( dir + "/Epiar" ) )
+		return "";
+	return dir + "/Epiar/" + flat;
+#endif
+}
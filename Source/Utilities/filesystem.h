@@ -26,6 +26,7 @@ class Filesystem {
 		static int AppendPath( const string &archivename );
 		static int PrependPath( const string &archivename );
 		static list<string> Enumerate( const string &path, const string &suffix="");
+		static string WritablePath( const string &name );
 		static void Version( void );
 		static void OutputArchivers( void );
 		static int DeInit( void );
@@ -20,6 +20,14 @@ class HashTable {
 		HashTable( int size = 101 ) : table( nextPrime( size ) ) {
 			makeEmpty();
 		}
+
+		// The table can be walked by position:
+		//   for( pos = 0; pos < capacity(); pos++ ) if( active( pos ) ) ... element( pos )
+		// Removing elements while walking the table is safe, inserting them is not.
+		int size( void ) const { return activeSize; }
+		int capacity( void ) const { return table.size(); }
+		bool active( int pos ) const { return isActive( pos ); }
+		const HashedObj &element( int pos ) const { return table[ pos ].element; }
 		
 		bool contains( HashedObj &x ) {
 			int pos = findPos( x );
@@ -34,6 +42,7 @@ class HashTable {
 		
 		void makeEmpty( void ) {
 			currentSize = 0;
+			activeSize = 0;
 			for( int i = 0; i < (signed)table.size(); i++ ) {
 				table[ i ].info = EMPTY;
 			}
@@ -44,9 +53,13 @@ class HashTable {
 			if( isActive( currentPos ) )
 				return false;
 			
+			// Reusing a DELETED entry doesn't use up any more of the table
+			if( table[ currentPos ].info == EMPTY )
+				++currentSize;
 			table[ currentPos ] = HashEntry( x, ACTIVE );
+			++activeSize;
 			
-			if( ++currentSize > (signed)table.size() / 2 )
+			if( currentSize > (signed)table.size() / 2 )
 				rehash();
 				
 			return true;
@@ -58,6 +71,7 @@ class HashTable {
 				return false;
 			
 			table[ currentPos ].info = DELETED;
+			--activeSize;
 			return true;
 		}
 		
@@ -73,7 +87,8 @@ class HashTable {
 		};
 		
 		vector<HashEntry> table;
-		int currentSize;
+		int currentSize; ///< ACTIVE and DELETED entries
+		int activeSize; ///< ACTIVE entries
 		
 		bool isActive( int currentPos ) const
 			{ return table[ currentPos ].info == ACTIVE; }
@@ -95,12 +110,16 @@ class HashTable {
 		void rehash( void ) {
 			vector<HashEntry> oldTable = table;
 			
-			table.resize( nextPrime( 2 * oldTable.size() ) );
+			// Only grow when the table is filling with ACTIVE entries.
+			// Otherwise this just clears out the DELETED entries.
+			if( activeSize > (signed)oldTable.size() / 4 )
+				table.resize( nextPrime( 2 * oldTable.size() ) );
 			for( int j = 0; j < (signed)table.size(); j++ )
 				table[ j ].info = EMPTY;
 			
 			// Copy table over
 			currentSize = 0;
+			activeSize = 0;
 			for( int i = 0; i < (signed)oldTable.size(); i++ )
 				if( oldTable[i].info == ACTIVE )
 					insert( oldTable[i].element );
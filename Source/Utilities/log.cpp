@@ -10,6 +10,9 @@
 #include "common.h"
 #include "Utilities/log.h"
 
+static OptionHandle<int> logOut("options/log/out");
+static OptionHandle<int> logXML("options/log/xml");
+
 /**\class Log
  * \brief Main logging facilities for the code base. */
 
@@ -76,11 +79,27 @@ void Log::Open() {
 	}	
 }
 
-/**\brief Frees the handle to the log file.*/
+/**\brief Stops the writer thread and frees the handle to the log file.*/
 void Log::Close( void ) {
+	if( writer != NULL ) {
+		writing = false;
+		SDL_WaitThread( writer, NULL );
+		writer = NULL;
+
+		// Anything that was pushed while the writer was finishing
+		Record record;
+		SDL_mutexP( writeLock );
+		while( records.Pop( record ) ) {
+			Write( record );
+		}
+		cout.flush();
+		SDL_mutexV( writeLock );
+	}
+
 	if( fp ) {
 		fprintf(fp, "</debugSession>\n");
 		fclose( fp );
+		fp = NULL;
 	}
 }
 
@@ -102,45 +121,198 @@ void Log::realLog( Level lvl, const string& func, const char *message, ... ) {
 		//	return;
 	}
 
-	va_list args;
-	time_t rawtime;
-	static char logBuffer[4096];
+	// Check where the message goes before doing any formatting.
+	// OptionHandles are main thread only, so other threads use the last values.
+	if( SDL_ThreadID() == mainThread ) {
+		toConsole = ( logOut.Get() == 1 );
+		toXML = ( logXML.Get() == 1 );
+	}
+	Record record;
+	record.toConsole = toConsole;
+	record.toXML = toXML;
+	if( !record.toConsole && !record.toXML )
+		return;
 
-	time( &rawtime );
+	time( &record.time );
+	if( RateLimited( lvl, record.time ) )
+		return;
 
-	timestamp = ctime( &rawtime );
-	timestamp[ strlen(timestamp) - 1 ] = 0;
+	va_list args;
+	size_t len;
 
+	record.lvl = lvl;
+	snprintf( record.func, sizeof(record.func), "%s", func.c_str() );
 	va_start( args, message );
-	vsnprintf( logBuffer, sizeof(logBuffer), message, args );
+	vsnprintf( record.message, sizeof(record.message), message, args );
 	va_end( args );
 
-	if( logBuffer[ strlen(logBuffer) - 1 ] == '\n' ) logBuffer[ strlen(logBuffer) - 1 ] = 0;
+	len = strlen( record.message );
+	if( len > 0 && record.message[ len - 1 ] == '\n' ) record.message[ len - 1 ] = 0;
+
+	// Without a writer thread the message is written immediately, by one thread at a time
+	if( writer == NULL ) {
+		SDL_mutexP( writeLock );
+		Write( record );
+		cout.flush();
+		SDL_mutexV( writeLock );
+		return;
+	}
+
+	// Warnings and errors wait for the writer to make room, anything less severe is dropped
+	while( !records.Push( record ) ) {
+		if( lvl > WARN ) {
+			ATOMIC_INCREMENT( &droppedFull );
+			return;
+		}
+		SDL_Delay( 1 );
+	}
+}
+
+/**\brief Starts writing log messages on a background thread.
+ * \details The options are read here, so this should be called after the
+ *  command line has been parsed.  When options/log/async is off, or the thread
+ *  can't be created, messages are still written on the thread that logs them.
+ */
+void Log::Start( void ) {
+	if( writer != NULL )
+		return;
+
+	rateLimit = OPTION(int, "options/log/rate-limit");
+	if( OPTION(int, "options/log/async") == 0 )
+		return;
+
+	writing = true;
+	writer = SDL_CreateThread( WriterThread, this );
+	if( writer == NULL ) {
+		writing = false;
+		LogMsg(WARN, "Could not start the log writer thread: %s", SDL_GetError() );
+	}
+}
+
+/**\brief Checks the per level rate limit.
+ * \details Only messages less severe than NOTICE are limited.  Two threads that
+ *  start a new second at the same time may both reset the count, which only lets
+ *  a few extra messages through.
+ * \return true when the message should be dropped.
+ */
+bool Log::RateLimited( Level lvl, time_t now ) {
+	if( rateLimit <= 0 || lvl <= NOTICE )
+		return false;
+
+	if( rateSecond[lvl] != now ) {
+		rateSecond[lvl] = now;
+		rateCount[lvl] = 0;
+	}
+	if( ATOMIC_INCREMENT( &rateCount[lvl] ) > (unsigned int)rateLimit ) {
+		ATOMIC_INCREMENT( &droppedRate );
+		return true;
+	}
+	return false;
+}
+
+/**\brief Writes one message to the console and/or the XML log.
+ * \details The caller must hold writeLock.  Worker threads log too, and a
+ *  message written before the writer thread starts may still be in progress
+ *  when it does.
+ */
+void Log::Write( const Record &record ) {
+	if( record.toConsole )
+		cout<<record.func<<" ("<<lvlStrings[record.lvl]<<") - "<< record.message <<"\n";
 
-	// Print the message:
-	if( OPTION(int, "options/log/out") == 1 )
-		cout<<func<<" ("<<lvlStrings[lvl]<<") - "<< logBuffer <<endl;;
-	
 	// Save the message to a file
-	if( OPTION(int, "options/log/xml") == 1 ) {
+	if( record.toXML ) {
+		timestamp = ctime( &record.time );
+		timestamp[ strlen(timestamp) - 1 ] = 0;
 
 		if( fp==NULL ){
 			Log::Open();
 		}
+		if( fp==NULL ){
+			return;
+		}
 
 		fprintf(fp, "<log>\n");
-		fprintf(fp, "\t<function>%s</function>\n\t<type>%s</type>\n\t<time>%s</time>\n\t<message>", func.c_str(), lvlStrings[lvl].c_str(), timestamp );
-		fprintf(fp, "%s", logBuffer );
+		fprintf(fp, "\t<function>%s</function>\n\t<type>%s</type>\n\t<time>%s</time>\n\t<message>", record.func, lvlStrings[record.lvl].c_str(), timestamp );
+		fprintf(fp, "%s", record.message );
 		fprintf(fp, "</message>\n</log>\n" );
 	}
 }
 
+/**\brief Reports how many messages were dropped since the last report.*/
+void Log::WriteDropped( bool toConsole, bool toXML ) {
+	unsigned int full, rate;
+	do { full = droppedFull; } while( !ATOMIC_CAS( &droppedFull, full, 0 ) );
+	do { rate = droppedRate; } while( !ATOMIC_CAS( &droppedRate, rate, 0 ) );
+	if( full == 0 && rate == 0 )
+		return;
+
+	Record record;
+	record.lvl = WARN;
+	time( &record.time );
+	record.toConsole = toConsole;
+	record.toXML = toXML;
+	snprintf( record.func, sizeof(record.func), "%s", __PRETTY_FUNCTION__ );
+	snprintf( record.message, sizeof(record.message), "Dropped %u log messages while the queue was full and %u over the rate limit.", full, rate );
+	Write( record );
+}
+
+/**\brief Writes queued messages in batches until the Log is closed.*/
+int Log::WriterThread( void *log ) {
+	Log *self = (Log*)log;
+	Record record;
+	bool toConsole = true, toXML = false;
+	bool stopping;
+	int written;
+
+	do {
+		// Check before draining so that everything queued before Close is written
+		stopping = !self->writing;
+
+		written = 0;
+		SDL_mutexP( self->writeLock );
+		while( self->records.Pop( record ) ) {
+			self->Write( record );
+			toConsole = record.toConsole;
+			toXML = record.toXML;
+			written++;
+		}
+		self->WriteDropped( toConsole, toXML );
+
+		if( written > 0 ) {
+			cout.flush();
+			if( self->fp ) fflush( self->fp );
+		}
+		SDL_mutexV( self->writeLock );
+
+		if( written == 0 && !stopping ) {
+			SDL_Delay( 5 );
+		}
+	} while( !stopping );
+
+	return 0;
+}
+
 /**\brief Constructor, used to initialize variables.*/
 Log::Log()
 	:loglvldefault(ALL)
+	,records(LOG_QUEUE_SIZE)
+	,writer(NULL)
+	,writeLock(SDL_CreateMutex())
+	,mainThread(SDL_ThreadID())
+	,toConsole(true)
+	,toXML(false)
+	,writing(false)
+	,rateLimit(0)
+	,droppedFull(0)
+	,droppedRate(0)
 {
 	time_t rawtime;
 
+	for( int l = 0; l <= ALL; l++ ) {
+		rateSecond[l] = 0;
+		rateCount[l] = 0;
+	}
+
 	lvlStrings[NONE]="None";
 	lvlStrings[FATAL]="Fatal";
 	lvlStrings[CRITICAL]="Critical";
@@ -10,6 +10,7 @@
 #define __H_LOG__
 
 #include "includes.h"
+#include "Server/queue_lockfree.h"
 
 // Work around for PRETTY_FUNCTIONs
 #ifndef __GNUC__
@@ -28,6 +29,10 @@
 	#define LogMsg(LVL,...) Log::Instance().realLog(Log::LVL,__PRETTY_FUNCTION__,__VA_ARGS__)
 #endif//ENABLE_LOGGING
 
+#define LOG_QUEUE_SIZE 1024 ///< Log messages that can wait for the writer thread.
+#define LOG_FUNCTION_SIZE 256
+#define LOG_MESSAGE_SIZE 1024
+
 class Log {
 	public:
 		typedef enum{INVALID=0,/**< Invalid log level, used for internal purposes.*/
@@ -51,7 +56,7 @@ class Log {
 		~Log();
 
 		static Log& Instance(void);
-		void Start( const string& _filter="", const string& _funfilter="" );
+		void Start( void );
 		bool SetLevel( const string& _loglvl );
 		bool SetLevel( Level _loglvl );
 		void SetFunFilter( const string& _funfilter );
@@ -61,11 +66,24 @@ class Log {
 		void realLog( Level lvl, const string& func, const char *message, ... );
 
 	private:
+		// A formatted message waiting to be written.
+		struct Record {
+			Level lvl;
+			time_t time;
+			bool toConsole, toXML;
+			char func[LOG_FUNCTION_SIZE];
+			char message[LOG_MESSAGE_SIZE];
+		};
+
 		Log();
 		Log(Log const&);
 		Log& operator=(Log const&);
 		void Open( void );
 		Log::Level ReverseLookUp( const string& _lvl );
+		bool RateLimited( Level lvl, time_t now );
+		void Write( const Record &record );
+		void WriteDropped( bool toConsole, bool toXML );
+		static int WriterThread( void *log );
 
 		map<Level,string> lvlStrings;
 		Level loglvl;
@@ -77,6 +95,20 @@ class Log {
 		char *timestamp;
 		string logFilename;
 		FILE *fp; // pointer to the log
+
+		// Asynchronous writing.  When the writer isn't running, messages are written immediately.
+		LockFreeQueue<Record> records;
+		SDL_Thread *writer;
+		SDL_mutex *writeLock;       ///< Held by whichever thread is calling Write.
+		Uint32 mainThread;          ///< The thread that created the Log, the only one that reads options.
+		volatile bool toConsole;    ///< options/log/out, as last read on the main thread.
+		volatile bool toXML;        ///< options/log/xml, as last read on the main thread.
+		volatile bool writing;      ///< Cleared to ask the writer thread to finish.
+		int rateLimit;              ///< Messages per second allowed at each level below NOTICE, 0 for no limit.
+		time_t rateSecond[ALL+1];   ///< The second that each level is counting messages in.
+		volatile unsigned int rateCount[ALL+1]; ///< Messages at each level in that second.
+		volatile unsigned int droppedFull; ///< Messages dropped since the queue was full.
+		volatile unsigned int droppedRate; ///< Messages dropped by the rate limit.
 };
 
 #endif // __H_LOG__
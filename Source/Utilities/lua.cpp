@@ -12,6 +12,7 @@
 
 #include "Utilities/lua.h"
 #include "Utilities/log.h"
+#include "Utilities/lua_profiler.h"
 
 
 /**\class Lua
@@ -19,6 +20,10 @@
 
 bool Lua::luaInitialized = false;
 lua_State *Lua::L = NULL;
+unsigned int Lua::scriptVersion = 1;
+unsigned int Lua::generation = 1;
+list< pair<string,int> > Lua::chunkOrder;
+map< string, list< pair<string,int> >::iterator > Lua::chunks;
 
 bool Lua::Load( const string& filename ) {
 	if( ! luaInitialized ) {
@@ -35,6 +40,8 @@ bool Lua::Load( const string& filename ) {
 	}
 
 	// Execute the lua script
+	// Anything that caches functions from the old scripts has to look them up again.
+	scriptVersion++;
 	if( 0 != lua_pcall(L, 0, 0, 0) ) {
 		LogMsg(ERR,"Error Executing '%s': %s", filename.c_str(), lua_tostring(L, -1));
 		return false;
@@ -48,42 +55,124 @@ bool Lua::Load( const string& filename ) {
 /**\brief Run an arbitrary string as Lua code
  * \returns The number of return values from that string.
  *
+ * \details The string is only compiled the first time that it is run.  The
+ * last LUA_CHUNK_CACHE_SIZE strings are kept as functions in the registry,
+ * so code that is run every frame costs no more than a function call.
+ *
  * \note If the function is known at compile time, use 'Call' instead of 'Run'.
+ * \note Code that is run often from C++ can use 'Compile' to keep its own handle.
  */
 int Lua::Run( string line, bool allowReturns ) {
-	int stack_before, stack_after;
-	//LogMsg(INFO,"Running '%s'", (char *)line.c_str() );
+	int chunk = GetChunk( line, allowReturns );
+	if( chunk == LUA_NOREF ) {
+		return 0;
+	}
+	return RunReference( chunk, allowReturns );
+}
+
+/**\brief Compiles a string of Lua code without running it.
+ * \param code The Lua code.
+ * \param allowReturns When true, the code is an expression whose values are returned.
+ * \return A handle for Run.  Its ref is LUA_NOREF if the code could not be compiled.
+ * \note The handle belongs to the caller, who should Release it when done.
+ * \note After Lua::Close the handle is no longer current, and has to be compiled again.
+ */
+LuaChunk Lua::Compile( const string& code, bool allowReturns ) {
+	string source = allowReturns ? ("return " + code) : code;
+	LuaChunk chunk;
 
 	if( ! luaInitialized ) {
 		if( Init() == false ) {
 			LogMsg(WARN, "Could not load Lua script. Unable to initialize Lua." );
-			return( false );
+			return( chunk );
 		}
 	}
 
-	// Record the stack position so that the stack can be reset if returns are not allowed.
-	stack_before = lua_gettop(L);
-	if( allowReturns ) {
-		line = "return " + line;
+	chunk.generation = generation;
+	if( 0 != luaL_loadbuffer( L, source.c_str(), source.size(), source.c_str() ) ) {
+		LogMsg(ERR,"Error compiling '%s': %s", source.c_str(), lua_tostring(L, -1));
+		lua_pop(L, 1);
+		return( chunk );
 	}
 
-	// Run the String!
-	if( luaL_dostring(L,line.c_str()) ) {
-		LogMsg(ERR,"Error running '%s': %s", line.c_str(), lua_tostring(L, -1));
-		lua_settop(L, stack_before);  /* pop error message from the stack */
+	chunk.ref = luaL_ref( L, LUA_REGISTRYINDEX );
+	return( chunk );
+}
+
+/**\brief Runs code that was compiled earlier.
+ * \param chunk A handle from Compile.  Handles from an earlier lua_State are not run.
+ * \param allowReturns Should match the value given to Compile.
+ * \returns The number of return values, which are left on the stack.
+ */
+int Lua::Run( const LuaChunk& chunk, bool allowReturns ) {
+	if( !IsCurrent( chunk ) ) {
 		return 0;
 	}
+	return RunReference( chunk.ref, allowReturns );
+}
 
-	// Reset the stack or return a count of returned values
-	if( !allowReturns ) {
-		lua_settop(L, stack_before);
-		stack_after = lua_gettop(L);
-		assert( stack_before == stack_after );
+/**\brief Runs a function in the registry (Internal use)
+ */
+int Lua::RunReference( int ref, bool allowReturns ) {
+	ProfileScope profile("Lua::Run");
+	int stack_before;
+
+	if( ref == LUA_NOREF || !luaInitialized ) {
 		return 0;
-	} else {
-		stack_after = lua_gettop(L);
-		return( stack_after - stack_before );
 	}
+
+	stack_before = lua_gettop(L);
+	lua_rawgeti( L, LUA_REGISTRYINDEX, ref );
+	if( 0 != lua_pcall( L, 0, (allowReturns ? LUA_MULTRET : 0), 0 ) ) {
+		LogMsg(ERR,"Error running Lua: %s", lua_tostring(L, -1));
+		lua_settop(L, stack_before);  /* pop error message from the stack */
+		return 0;
+	}
+
+	return( lua_gettop(L) - stack_before );
+}
+
+/**\brief Frees code that was compiled with Compile, and empties the handle.
+ * \details A handle from an earlier lua_State was freed with it.
+ */
+void Lua::Release( LuaChunk& chunk ) {
+	if( chunk.ref != LUA_NOREF && IsCurrent( chunk ) && luaInitialized ) {
+		luaL_unref( L, LUA_REGISTRYINDEX, chunk.ref );
+	}
+	chunk = LuaChunk();
+}
+
+/**\brief Finds the compiled version of a string, compiling it if needed (Internal use)
+ * \details When the cache is full, the string that was run least recently is dropped.
+ * \return A handle that belongs to the cache, or LUA_NOREF.
+ */
+int Lua::GetChunk( const string& line, bool allowReturns ) {
+	string key = allowReturns ? ("return " + line) : line;
+	map< string, list< pair<string,int> >::iterator >::iterator found;
+	int chunk;
+
+	found = chunks.find( key );
+	if( found != chunks.end() ) {
+		chunkOrder.splice( chunkOrder.begin(), chunkOrder, found->second );
+		return( found->second->second );
+	}
+
+	// The cache is emptied by Close, so it only holds references into this lua_State
+	chunk = Compile( line, allowReturns ).ref;
+	if( chunk == LUA_NOREF ) {
+		return( LUA_NOREF );
+	}
+
+	chunkOrder.push_front( make_pair( key, chunk ) );
+	chunks[key] = chunkOrder.begin();
+
+	if( chunks.size() > LUA_CHUNK_CACHE_SIZE ) {
+		luaL_unref( L, LUA_REGISTRYINDEX, chunkOrder.back().second );
+		chunks.erase( chunkOrder.back().first );
+		chunkOrder.pop_back();
+	}
+
+	return( chunk );
 }
 
 // This function is from the Lua PIL
@@ -93,6 +182,7 @@ int Lua::Run( string line, bool allowReturns ) {
 // WARNING: any s as a return must be a pointer to a string (not a c str)
 //          This allows Lua::Call to clear the stack when we're done.
 bool Lua::Call(const char *func, const char *sig, ...) {
+	ProfileScope profile("Lua::Call");
 	va_list vl;
 	int narg, nres,resultcount;  /* number of arguments and results */
 
@@ -189,7 +279,15 @@ bool Lua::Init() {
 
 bool Lua::Close() {
 	if( luaInitialized ) {
+		LuaProfiler::Stop();
+		chunks.clear();
+		chunkOrder.clear();
 		lua_close( L );
+		L = NULL;
+		luaInitialized = false;
+		// Handles from Compile that are still held are stale, and functions cached from the scripts are gone
+		generation++;
+		scriptVersion++;
 	} else {
 		LogMsg(WARN, "Cannot deinitialize Lua. It is either not initialized or a script is still loaded." );
 		return( false );
@@ -22,6 +22,18 @@ extern "C" {
 }
 #endif
 
+#define LUA_CHUNK_CACHE_SIZE 128 ///< Number of compiled strings that Lua::Run keeps.
+
+/**\brief A handle to code compiled by Lua::Compile.
+ * \details The handle remembers which lua_State it was compiled in, so one
+ * that is kept across Lua::Close is never run or released in the next state.
+ */
+struct LuaChunk {
+	LuaChunk() : ref(LUA_NOREF), generation(0) {}
+	int ref;                 ///< Registry reference, or LUA_NOREF.
+	unsigned int generation; ///< The Lua::GetGeneration that it was compiled in.
+};
+
 class Lua {
 	public:
 		static bool Init();
@@ -29,9 +41,15 @@ class Lua {
 
 		static bool Load( const string& filename );
 		static int Run( string line, bool allowReturns=false );
+		static LuaChunk Compile( const string& code, bool allowReturns=false );
+		static int Run( const LuaChunk& chunk, bool allowReturns=false );
+		static void Release( LuaChunk& chunk );
+		static bool IsCurrent( const LuaChunk& chunk ) { return chunk.generation == generation; }
 		static bool Call(const char *func, const char *sig="", ...);
 
 		static lua_State* CurrentState() { return L;}
+		static unsigned int GetScriptVersion() { return scriptVersion; }
+		static unsigned int GetGeneration() { return generation; }
 
 		static void RegisterFunctions();
 
@@ -58,10 +76,18 @@ class Lua {
 
 	private:
 		static int ErrorCatch(lua_State *L);
+		static int GetChunk( const string& line, bool allowReturns );
+		static int RunReference( int ref, bool allowReturns );
 
 		// Internal variables
 		static lua_State *L;
 		static bool luaInitialized;
+		static unsigned int scriptVersion; ///< Changes whenever a script is loaded.
+		static unsigned int generation; ///< Changes whenever the lua_State is closed.
+
+		// Chunks compiled by Run, most recently used first
+		static list< pair<string,int> > chunkOrder;
+		static map< string, list< pair<string,int> >::iterator > chunks;
 };
 
 #endif // __H_LUA__
@@ -0,0 +1,87 @@
+/**\file			lua_gc.cpp
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Collects Lua garbage a little at a time between frames
+ * \details
+ */
+
+#include "includes.h"
+#include "common.h"
+#include "Utilities/lua_gc.h"
+#include "Utilities/lua.h"
+#include "Utilities/timer.h"
+
+/**\class LuaGC
+ * \brief Runs the Lua garbage collector in the idle time after each frame.
+ * \details
+ * Lua's own collector runs whenever enough memory has been allocated, which
+ * is usually in the middle of the AI or the HUD, and a whole cycle at once
+ * can take several milliseconds.  Instead, the automatic collector is
+ * stopped and Step is called once per drawn frame, after Video::Update.
+ * Each Step does incremental work until "options/simulation/lua-gc-budget"
+ * microseconds have passed.
+ *
+ * Like Lua's collector, a new cycle only starts once the heap has grown by
+ * LUA_GC_PAUSE since the last cycle finished.  If the budget is too small
+ * to keep up and the heap grows by LUA_GC_MAX_GROWTH, the cycle is finished
+ * regardless of the budget.
+ *
+ * A budget of 0 gives the collector back to Lua.
+ * \see Epiar.luaGC, Hud::DrawLua
+ */
+
+bool LuaGC::manual = false;
+bool LuaGC::collecting = false;
+int LuaGC::heapAfterCycle = 0;
+int LuaGC::heapKB = 0;
+double LuaGC::stepTime = 0;
+int LuaGC::collections = 0;
+
+static OptionHandle<int> budget("options/simulation/lua-gc-budget");
+
+/**\brief Spends this frame's budget collecting garbage.
+ */
+void LuaGC::Step( void ) {
+	lua_State *L = Lua::CurrentState();
+	if( L == NULL ) {
+		return;
+	}
+
+	if( budget.Get() <= 0 ) {
+		if( manual ) {
+			lua_gc(L, LUA_GCRESTART, 0);
+			manual = false;
+		}
+		heapKB = lua_gc(L, LUA_GCCOUNT, 0);
+		stepTime = 0;
+		return;
+	}
+
+	double started = Timer::GetRealTime();
+	double limit = budget.Get() / 1000000.0;
+	heapKB = lua_gc(L, LUA_GCCOUNT, 0);
+
+	// Wait for the heap to grow before starting another cycle
+	if( !collecting && (heapKB >= heapAfterCycle * LUA_GC_PAUSE) ) {
+		collecting = true;
+	}
+
+	if( collecting ) {
+		bool unlimited = (heapAfterCycle > 0) && (heapKB >= heapAfterCycle * LUA_GC_MAX_GROWTH);
+		do {
+			if( lua_gc(L, LUA_GCSTEP, LUA_GC_STEP_KB) ) {
+				collecting = false;
+				collections++;
+				heapAfterCycle = lua_gc(L, LUA_GCCOUNT, 0);
+				break;
+			}
+		} while( unlimited || (Timer::GetRealTime() - started < limit) );
+		heapKB = lua_gc(L, LUA_GCCOUNT, 0);
+	}
+
+	// A step sets Lua's threshold again, so this has to follow every step
+	lua_gc(L, LUA_GCSTOP, 0);
+	manual = true;
+	stepTime = Timer::GetRealTime() - started;
+}
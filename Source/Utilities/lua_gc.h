@@ -0,0 +1,35 @@
+/**\file			lua_gc.h
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Collects Lua garbage a little at a time between frames
+ * \details
+ */
+
+#ifndef __H_LUA_GC__
+#define __H_LUA_GC__
+
+#include "includes.h"
+
+#define LUA_GC_STEP_KB 8      ///< The size of each incremental step passed to lua_gc.
+#define LUA_GC_PAUSE 2        ///< A new cycle starts once the heap has grown by this factor since the last one.
+#define LUA_GC_MAX_GROWTH 4   ///< Past this factor a cycle is finished without a budget.
+
+class LuaGC {
+	public:
+		static void Step( void );
+
+		static int GetHeapKB( void ) { return heapKB; }
+		static double GetStepTime( void ) { return stepTime; }
+		static int GetCollections( void ) { return collections; }
+
+	private:
+		static bool manual;      ///< Whether Lua's automatic collector is stopped.
+		static bool collecting;  ///< Whether a cycle is in progress.
+		static int heapAfterCycle; ///< KB in use when the last cycle finished.
+		static int heapKB;       ///< KB in use after the last Step.
+		static double stepTime;  ///< Seconds that the last Step took.
+		static int collections;  ///< Cycles finished since the game started.
+};
+
+#endif // __H_LUA_GC__
@@ -0,0 +1,300 @@
+/**\file			lua_profiler.cpp
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Samples where the Lua scripts spend their time
+ * \details
+ */
+
+#include "includes.h"
+#include "common.h"
+#include "Utilities/lua_profiler.h"
+#include "Utilities/log.h"
+#include "Utilities/timer.h"
+
+/**\class LuaProfiler
+ * \brief A sampling profiler for the Lua scripts.
+ * \details
+ * While it is running, a count hook stops Lua every few hundred instructions
+ * and files the time since the last sample under the current Lua call stack.
+ * The stack starts with the ProfileScopes that are running, such as
+ * AI::Decide or Mission::Update, so the same Lua function called from
+ * different parts of the engine shows up separately.
+ *
+ * Dump writes the stacks in the collapsed format that flamegraph.pl and
+ * similar tools read, with one line per stack and the time in microseconds:
+ * \code
+ * AI::Decide;Travelling (Resources/Scripts/ai.lua:248) 5120
+ * \endcode
+ * It also reports the functions and source lines that took the most time.
+ *
+ * The lua_States that run on worker threads, such as the AIShards, are
+ * sampled too once they are attached.  Their stacks start with the scope that
+ * they were attached with instead of the ProfileScopes of the main thread.
+ *
+ * From the console:
+ * \code
+ * Epiar.profileStart()
+ * Epiar.profileStop()
+ * Epiar.profileDump("lua.folded")
+ * \endcode
+ */
+
+bool LuaProfiler::running = false;
+int LuaProfiler::interval = LUA_PROFILER_INTERVAL;
+int LuaProfiler::samples = 0;
+double LuaProfiler::lastSample = 0;
+map<lua_State*,LuaProfiler::OtherState> LuaProfiler::others;
+SDL_mutex *LuaProfiler::lock = NULL;
+vector<const char*> LuaProfiler::scopes;
+map<string,double> LuaProfiler::stacks;
+map<string,double> LuaProfiler::functions;
+map<string,double> LuaProfiler::lines;
+map<string,LuaProfiler::ScopeTime> LuaProfiler::scopeTimes;
+
+/**\brief Forgets the last profile and starts sampling.
+ * \param _interval Lua instructions between samples.
+ */
+bool LuaProfiler::Start( int _interval ) {
+	lua_State *L = Lua::CurrentState();
+	map<lua_State*,OtherState>::iterator o;
+	if( L == NULL ) {
+		LogMsg(ERR, "Cannot profile Lua before it is initialized." );
+		return false;
+	}
+	if( lock == NULL ) {
+		lock = SDL_CreateMutex();
+	}
+	interval = (_interval < 1) ? LUA_PROFILER_INTERVAL : _interval;
+
+	samples = 0;
+	stacks.clear();
+	functions.clear();
+	lines.clear();
+	scopeTimes.clear();
+	scopes.clear();
+
+	lastSample = Timer::GetRealTime();
+	lua_sethook( L, &LuaProfiler::Hook, LUA_MASKCOUNT, interval );
+	for( o = others.begin(); o != others.end(); ++o ) {
+		o->second.lastSample = lastSample;
+		lua_sethook( o->first, &LuaProfiler::Hook, LUA_MASKCOUNT, interval );
+	}
+	running = true;
+	LogMsg(INFO, "Started the Lua profiler with a sample every %d instructions.", interval );
+	return true;
+}
+
+/**\brief Stops sampling.  The profile is kept until the next Start.
+ */
+void LuaProfiler::Stop( void ) {
+	lua_State *L = Lua::CurrentState();
+	map<lua_State*,OtherState>::iterator o;
+	if( !running ) {
+		return;
+	}
+	if( L != NULL ) {
+		lua_sethook( L, NULL, 0, 0 );
+	}
+	for( o = others.begin(); o != others.end(); ++o ) {
+		lua_sethook( o->first, NULL, 0, 0 );
+	}
+	running = false;
+	scopes.clear();
+	LogMsg(INFO, "Stopped the Lua profiler after %d samples.", samples );
+}
+
+/**\brief Samples a lua_State that a worker thread runs.
+ * \details It is sampled whenever the profiler is running, until it is detached.
+ * It must not be running while it is attached.
+ * \param L The lua_State.
+ * \param scope What its samples are filed under, such as "AIShards".
+ */
+void LuaProfiler::Attach( lua_State *L, const char *scope ) {
+	OtherState &other = others[L];
+	other.scope = scope;
+	other.lastSample = Timer::GetRealTime();
+	if( running ) {
+		lua_sethook( L, &LuaProfiler::Hook, LUA_MASKCOUNT, interval );
+	}
+}
+
+/**\brief Stops sampling a lua_State, before it is closed.
+ * \see Attach
+ */
+void LuaProfiler::Detach( lua_State *L ) {
+	if( others.erase( L ) > 0 ) {
+		lua_sethook( L, NULL, 0, 0 );
+	}
+}
+
+/**\brief Marks that a worker thread is about to run an attached lua_State.
+ * \details Like Enter, this keeps the time that it spent idle out of the profile.
+ */
+void LuaProfiler::Resume( lua_State *L ) {
+	map<lua_State*,OtherState>::iterator o = others.find( L );
+	if( o != others.end() ) {
+		o->second.lastSample = Timer::GetRealTime();
+	}
+}
+
+/**\brief Sorts the entries of a profile map by time, most first (Internal use)
+ */
+static bool MoreTime( const pair<string,double>& a, const pair<string,double>& b ) {
+	return a.second > b.second;
+}
+
+/**\brief Adds the entries that took the most time to a summary (Internal use)
+ */
+static void Summarize( const char *title, const map<string,double> &times, list<string> &summary ) {
+	vector< pair<string,double> > sorted( times.begin(), times.end() );
+	char line[256];
+
+	sort( sorted.begin(), sorted.end(), MoreTime );
+	summary.push_back( title );
+	for( unsigned int i = 0; (i < sorted.size()) && (i < LUA_PROFILER_TOP); i++ ) {
+		snprintf( line, sizeof(line), "%10.3f ms  %s", sorted[i].second * 1000.0, sorted[i].first.c_str() );
+		summary.push_back( line );
+	}
+}
+
+/**\brief Writes the profile in the collapsed stack format.
+ * \param filename Where to write the stacks.
+ * \param summary [out] The scopes, functions and lines that took the most time.
+ * \return false if the file could not be written.
+ */
+bool LuaProfiler::Dump( const string& filename, list<string> &summary ) {
+	map<string,double>::iterator s;
+	map<string,ScopeTime>::iterator t;
+	char line[256];
+	FILE *fp;
+
+	fp = fopen( filename.c_str(), "wb" );
+	if( fp == NULL ) {
+		LogMsg(ERR, "Could not write the Lua profile to '%s'.", filename.c_str() );
+		return false;
+	}
+	for( s = stacks.begin(); s != stacks.end(); ++s ) {
+		long microseconds = static_cast<long>( s->second * 1000000.0 + 0.5 );
+		if( microseconds > 0 ) {
+			fprintf( fp, "%s %ld\n", s->first.c_str(), microseconds );
+		}
+	}
+	fclose( fp );
+
+	snprintf( line, sizeof(line), "%d samples written to %s", samples, filename.c_str() );
+	summary.push_back( line );
+	for( t = scopeTimes.begin(); t != scopeTimes.end(); ++t ) {
+		snprintf( line, sizeof(line), "%10.3f ms  %s (%d calls)", t->second.seconds * 1000.0, t->first.c_str(), t->second.calls );
+		summary.push_back( line );
+	}
+	Summarize( "Functions:", functions, summary );
+	Summarize( "Lines:", lines, summary );
+
+	LogMsg(INFO, "Wrote the Lua profile to '%s'.", filename.c_str() );
+	return true;
+}
+
+/**\brief Marks the start of a ProfileScope.
+ * \return When the scope started.
+ */
+double LuaProfiler::Enter( const char *scope ) {
+	double now = Timer::GetRealTime();
+	// Time outside of the scopes isn't spent in Lua
+	if( scopes.empty() ) {
+		lastSample = now;
+	}
+	scopes.push_back( scope );
+	return now;
+}
+
+/**\brief Marks the end of a ProfileScope.
+ * \param started What Enter returned.
+ */
+void LuaProfiler::Leave( const char *scope, double started ) {
+	if( !scopes.empty() ) {
+		scopes.pop_back();
+	}
+	if( running ) {
+		ScopeTime &time = scopeTimes[scope];
+		time.calls++;
+		time.seconds += Timer::GetRealTime() - started;
+	}
+}
+
+/**\brief Names a stack frame for the collapsed stacks (Internal use)
+ */
+string LuaProfiler::FrameName( lua_Debug &frame ) {
+	string name;
+	if( frame.what != NULL && strcmp( frame.what, "C" ) == 0 ) {
+		name = string("[C] ") + (frame.name ? frame.name : "?");
+	} else if( frame.what != NULL && strcmp( frame.what, "main" ) == 0 ) {
+		name = string("main chunk (") + frame.short_src + ")";
+	} else {
+		char where[LUA_IDSIZE + 16];
+		snprintf( where, sizeof(where), " (%s:%d)", frame.short_src, frame.linedefined );
+		name = string(frame.name ? frame.name : "?") + where;
+	}
+	// Semicolons separate the frames
+	replace( name.begin(), name.end(), ';', ',' );
+	return name;
+}
+
+/**\brief Files the time since the last sample under the current stack (Internal use)
+ * \details The attached lua_States call this from the worker threads.
+ */
+void LuaProfiler::Hook( lua_State *L, lua_Debug *ar ) {
+	map<lua_State*,OtherState>::iterator other = others.find( L );
+	double now = Timer::GetRealTime();
+	double elapsed;
+	vector<string> frames;
+	lua_Debug frame;
+	string stack, leaf, where;
+	int level;
+
+	// Each attached state has its own clock, and only runs on one thread at a time
+	if( other != others.end() ) {
+		elapsed = now - other->second.lastSample;
+		other->second.lastSample = now;
+	} else {
+		elapsed = now - lastSample;
+		lastSample = now;
+	}
+
+	for( level = 0; lua_getstack( L, level, &frame ); level++ ) {
+		lua_getinfo( L, "Snl", &frame );
+		frames.push_back( FrameName( frame ) );
+		if( level == 0 ) {
+			char line[LUA_IDSIZE + 16];
+			snprintf( line, sizeof(line), "%s:%d", frame.short_src, frame.currentline );
+			where = line;
+		}
+	}
+	if( frames.empty() ) {
+		return;
+	}
+	leaf = frames.front();
+
+	if( other != others.end() ) {
+		stack += other->second.scope;
+		stack += ';';
+	} else {
+		for( vector<const char*>::iterator s = scopes.begin(); s != scopes.end(); ++s ) {
+			stack += *s;
+			stack += ';';
+		}
+	}
+	for( vector<string>::reverse_iterator f = frames.rbegin(); f != frames.rend(); ++f ) {
+		if( f != frames.rbegin() ) {
+			stack += ';';
+		}
+		stack += *f;
+	}
+
+	SDL_mutexP( lock );
+	samples++;
+	stacks[stack] += elapsed;
+	functions[leaf] += elapsed;
+	lines[where] += elapsed;
+	SDL_mutexV( lock );
+}
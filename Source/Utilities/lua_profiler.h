@@ -0,0 +1,91 @@
+/**\file			lua_profiler.h
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Samples where the Lua scripts spend their time
+ * \details
+ */
+
+#ifndef __H_LUA_PROFILER__
+#define __H_LUA_PROFILER__
+
+#include "includes.h"
+#include "Utilities/lua.h"
+
+#define LUA_PROFILER_INTERVAL 1000 ///< Lua instructions between samples.
+#define LUA_PROFILER_TOP 10 ///< How many functions and lines Dump reports.
+
+class LuaProfiler {
+	public:
+		static bool Start( int interval = LUA_PROFILER_INTERVAL );
+		static void Stop( void );
+		static bool Dump( const string& filename, list<string> &summary );
+		static bool IsRunning( void ) { return running; }
+
+		static void Attach( lua_State *L, const char *scope );
+		static void Detach( lua_State *L );
+		static void Resume( lua_State *L );
+
+		static double Enter( const char *scope );
+		static void Leave( const char *scope, double started );
+
+	private:
+		static void Hook( lua_State *L, lua_Debug *ar );
+		static string FrameName( lua_Debug &frame );
+
+		/**\brief The time spent in a C++ scope (Internal use)
+		 */
+		struct ScopeTime {
+			int calls;      ///< How many times the scope was entered.
+			double seconds; ///< Total time spent in the scope, including nested scopes.
+		};
+
+		/**\brief A lua_State other than the main one, run by a worker thread (Internal use)
+		 */
+		struct OtherState {
+			const char *scope; ///< What its samples are filed under.
+			double lastSample; ///< When its last sample was taken, or when it was resumed.
+		};
+
+		static bool running;
+		static int interval;            ///< Lua instructions between samples.
+		static int samples;             ///< Samples taken since Start.
+		static double lastSample;       ///< When the last sample was taken, or when Lua was entered.
+		static map<lua_State*,OtherState> others; ///< The attached lua_States.
+		static SDL_mutex *lock;         ///< Guards the samples while other states are running.
+		static vector<const char*> scopes; ///< The C++ scopes that are running, outermost first.
+		static map<string,double> stacks;    ///< Seconds spent in each collapsed stack.
+		static map<string,double> functions; ///< Seconds spent in each function, not counting what it calls.
+		static map<string,double> lines;     ///< Seconds spent on each source line.
+		static map<string,ScopeTime> scopeTimes; ///< Time spent in each C++ scope.
+};
+
+/**\brief Times a C++ scope that runs Lua while the LuaProfiler is running.
+ * \details Lua samples taken inside the scope are filed under its name, so
+ * the profile shows which part of the engine called the script.
+ * \code
+ * void Mission::Update() {
+ *     ProfileScope profile("Mission::Update");
+ *     ...
+ * }
+ * \endcode
+ */
+class ProfileScope {
+	public:
+		ProfileScope( const char *_name ) : name(_name), started(0) {
+			if( LuaProfiler::IsRunning() ) {
+				started = LuaProfiler::Enter( name );
+			}
+		}
+		~ProfileScope() {
+			if( started != 0 ) {
+				LuaProfiler::Leave( name, started );
+			}
+		}
+
+	private:
+		const char *name;
+		double started; ///< 0 when the profiler wasn't running at the start of the scope.
+};
+
+#endif // __H_LUA_PROFILER__
@@ -38,6 +38,11 @@ const char* PositionNames[4] = { "UPPER_LEFT", "UPPER_RIGHT", "LOWER_LEFT", "LOW
    +--------+--------+
    \endverbatim
  *
+ * The Nodes and Leaves of a QuadTree are kept in a single pool and refer to each other by index.
+ * Each Leaf stores its first QUADMAXOBJECTS Sprites inline, so that a ballanced tree does not
+ * need any other storage.  Nodes that are removed are kept for reuse, which means that once a
+ * QuadTree has grown to its working size, updating it does not allocate any memory.
+ *
  * \see GetNearestSprite
  * \see GetSpritesNear
  *
@@ -49,31 +54,114 @@ const char* PositionNames[4] = { "UPPER_LEFT", "UPPER_RIGHT", "LOWER_LEFT", "LOW
 
 QuadTree::QuadTree(Coordinate _center, float _radius){
 	// cout<<"New QT at "<<_center<<" has R="<<_radius<<endl;
-	assert(_radius>MIN_QUAD_SIZE/2);
-	for(int t=0;t<4;t++){
-		subtrees[t] = NULL;
-	}
-	this->objects = new list<Sprite*>();
 	this->radius = _radius;
 	this->center = _center;
-	this->objectcount = 0;
-	this->isLeaf = true;
-	this->isDirty = false;
+	nodes.reserve(16);
+	NewNode(_center, _radius);
 }
 
 /** \brief Destructor
  */
 
 QuadTree::~QuadTree(){
-	this->objects->clear();
-	delete objects;
-	// Delete the Subtrees (Node)
+	nodes.clear();
+	freeNodes.clear();
+}
+
+/** \brief Take a Leaf from the pool
+ * \arg _center The center of the new Leaf.
+ * \arg _radius The radius of the new Leaf.
+ * \returns The pool index of the new Leaf.
+ *
+ * This may grow the pool, so any QuadNode references are invalid afterwards.
+ */
+
+int QuadTree::NewNode(Coordinate _center, float _radius){
+	int n;
+	assert(_radius>MIN_QUAD_SIZE/2);
+	if( freeNodes.empty() ){
+		n = nodes.size();
+		nodes.push_back( QuadNode() );
+	} else {
+		n = freeNodes.back();
+		freeNodes.pop_back();
+	}
+	QuadNode &node = nodes[n];
+	for(int t=0;t<4;t++){
+		node.subtrees[t] = -1;
+	}
+	node.radius = _radius;
+	node.center = _center;
+	node.objectcount = 0;
+	node.numObjects = 0;
+	node.overflow.clear();
+	node.flags = 0;
+	node.isLeaf = true;
+	node.isDirty = false;
+	return n;
+}
+
+/** \brief Return a Node and all of its subtrees to the pool
+ * \arg n The pool index of the Node.
+ */
+
+void QuadTree::FreeNode(int n){
 	for(int t=0;t<4;t++){
-		if(NULL != (subtrees[t])){
-			delete subtrees[t];
-			this->subtrees[t] = NULL;
+		if(nodes[n].subtrees[t] >= 0){
+			FreeNode(nodes[n].subtrees[t]);
+			nodes[n].subtrees[t] = -1;
 		}
 	}
+	nodes[n].numObjects = 0;
+	nodes[n].objectcount = 0;
+	nodes[n].overflow.clear();
+	freeNodes.push_back(n);
+}
+
+/** \brief Get a Sprite stored in a Leaf
+ */
+
+Sprite* QuadTree::LeafGet(int n, unsigned int i){
+	QuadNode &node = nodes[n];
+	assert(i < node.numObjects);
+	if(i < QUADMAXOBJECTS){
+		return node.objects[i];
+	}
+	return node.overflow[i-QUADMAXOBJECTS];
+}
+
+/** \brief Store a Sprite in a Leaf
+ * This does not do any accounting for the Leaf.
+ */
+
+void QuadTree::LeafAdd(int n, Sprite* obj){
+	QuadNode &node = nodes[n];
+	if(node.numObjects < QUADMAXOBJECTS){
+		node.objects[node.numObjects] = obj;
+	} else {
+		node.overflow.push_back(obj);
+	}
+	node.numObjects++;
+}
+
+/** \brief Remove a Sprite from a Leaf
+ * The last Sprite of the Leaf takes its place.
+ * This does not do any accounting for the Leaf.
+ */
+
+void QuadTree::LeafRemove(int n, unsigned int i){
+	QuadNode &node = nodes[n];
+	unsigned int last = node.numObjects-1;
+	assert(i < node.numObjects);
+	if(i < QUADMAXOBJECTS){
+		node.objects[i] = LeafGet(n,last);
+	} else {
+		node.overflow[i-QUADMAXOBJECTS] = LeafGet(n,last);
+	}
+	if(last >= QUADMAXOBJECTS){
+		node.overflow.pop_back();
+	}
+	node.numObjects--;
 }
 
 /** \brief The number of Sprites within this QuadTree.
@@ -81,19 +169,7 @@ QuadTree::~QuadTree(){
  */
 
 unsigned int QuadTree::Count(){
-	return objectcount;
-	/*
-	if(isLeaf){
-		return objects->size();
-	} else {
-		int total=0;
-		for(int t=0;t<4;t++){
-			if(NULL != subtrees[t])
-				total += subtrees[t]->Count();
-		}
-		return total;
-	}
-	*/
+	return nodes[0].objectcount;
 }
 
 /** \brief Check if a point is inside this QuadTree.
@@ -102,10 +178,16 @@ unsigned int QuadTree::Count(){
  */
 
 bool QuadTree::Contains(Coordinate point){
-	bool insideLeftBorder = (center.GetX()-radius) <= point.GetX();
-	bool insideRightBorder = (center.GetX()+radius) >= point.GetX();
-	bool insideTopBorder = (center.GetY()+radius) >= point.GetY();
-	bool insideBottomBorder = (center.GetY()-radius) <= point.GetY();
+	return Contains(0,point);
+}
+
+bool QuadTree::Contains(int n, Coordinate point){
+	const Coordinate &c = nodes[n].center;
+	const float r = nodes[n].radius;
+	bool insideLeftBorder = (c.GetX()-r) <= point.GetX();
+	bool insideRightBorder = (c.GetX()+r) >= point.GetX();
+	bool insideTopBorder = (c.GetY()+r) >= point.GetY();
+	bool insideBottomBorder = (c.GetY()-r) <= point.GetY();
 	return insideLeftBorder && insideRightBorder && insideTopBorder && insideBottomBorder;
 }
 
@@ -118,14 +200,18 @@ bool QuadTree::Contains(Coordinate point){
  */
 
 void QuadTree::Insert(Sprite *obj){
-	if(! isLeaf ){ // Node
-		InsertSubTree(obj);
+	Insert(0,obj);
+}
+
+void QuadTree::Insert(int n, Sprite *obj){
+	if(! nodes[n].isLeaf ){ // Node
+		InsertSubTree(n,obj);
 	} else { // Leaf
-		objects->push_back(obj);
+		LeafAdd(n,obj);
 		// An over Full Leaf should become a Node
-		isDirty=true;
+		nodes[n].isDirty=true;
 	}
-	objectcount++;
+	nodes[n].objectcount++;
 }
 
 /** \brief Remove a Sprite from this Tree
@@ -137,34 +223,37 @@ void QuadTree::Insert(Sprite *obj){
  */
 
 bool QuadTree::Delete(Sprite* obj){
-	if(0 == this->Count())
+	return Delete(0,obj);
+}
+
+bool QuadTree::Delete(int n, Sprite* obj){
+	if(0 == nodes[n].objectcount)
 		return( false ); // No objects to delete.
 
-	if(!Contains(obj->GetWorldPosition()))
+	if(!Contains(n,obj->GetWorldPosition()))
 		return( false ); // Out of bounds, nothing to delete.
 
-	if(!isLeaf){ // Node
-		QuadTree* dest = subtrees[SubTreeThatContains( obj->GetWorldPosition() )];
-		if(dest==NULL)
+	if(!nodes[n].isLeaf){ // Node
+		int dest = nodes[n].subtrees[SubTreeThatContains( n, obj->GetWorldPosition() )];
+		if(dest<0)
 			return( false ); // That branch is empty, nothing to delete.
-		if( dest->Delete(obj) ){
-			isDirty=true;
-			objectcount--;
+		if( Delete(dest,obj) ){
+			nodes[n].isDirty=true;
+			nodes[n].objectcount--;
 			return( true ); // Found that object.
 		} else {
 			return( false ); // Didn't find that object.
 		}
 	} else { // Leaf
-		list<Sprite *>::iterator i = std::find( objects->begin(), objects->end(), obj);
-		if(i != objects->end())
-		{
-			i = objects->erase( i );
-			// Note that leaves don't ReBallance on delete.
-			objectcount--;
-			return( true );
-		} else {
-			return( false );
+		for(unsigned int i=0; i<nodes[n].numObjects; i++){
+			if(LeafGet(n,i) == obj){
+				LeafRemove(n,i);
+				// Note that leaves don't ReBallance on delete.
+				nodes[n].objectcount--;
+				return( true );
+			}
 		}
+		return( false );
 	}
 }
 
@@ -174,19 +263,22 @@ bool QuadTree::Delete(Sprite* obj){
  */
 
 list<Sprite *> *QuadTree::GetSprites() {
-	if(!isLeaf){ // Node
-		list<Sprite*> *other;
-		list<Sprite*> *full = new list<Sprite*>();
+	vector<Sprite*> full;
+	GetSprites(0,full);
+	return new list<Sprite*>(full.begin(), full.end());
+}
+
+void QuadTree::GetSprites(int n, vector<Sprite*> &sprites) {
+	if(!nodes[n].isLeaf){ // Node
 		for(int t=0;t<4;t++){
-			if(NULL != (subtrees[t])){
-				other = subtrees[t]->GetSprites();
-				full->splice(full->end(), *other );
-				delete other;
+			if(nodes[n].subtrees[t] >= 0){
+				GetSprites(nodes[n].subtrees[t],sprites);
 			}
 		}
-		return full;
 	} else { // Leaf
-		return new list<Sprite*>(*objects);
+		for(unsigned int i=0; i<nodes[n].numObjects; i++){
+			sprites.push_back( LeafGet(n,i) );
+		}
 	}
 }
 
@@ -194,38 +286,42 @@ list<Sprite *> *QuadTree::GetSprites() {
  *
  * \arg point The center of the search radius.
  * \arg distance The maximum search radius.
- * \arg nearby [out] The list of all Sprites found within the search radius.
+ * \arg nearby [out] The Sprites found within the search radius are appended to this.
  * \arg type A DRAW_ORDER mask used to filter for desired Sprite types.
  *
- * The nearby list is passed down the recursive call-stack rather than returned at by each call.
- * This limits the malloc calls.
+ * The nearby vector is passed down the recursive call-stack rather than returned at by each call.
+ * Since it belongs to the caller, a reused vector makes the search allocation free.
  *
  * \returns nothing.
  */
 
-void QuadTree::GetSpritesNear(Coordinate point, float distance, list<Sprite*> *nearby, int type){
+void QuadTree::GetSpritesNear(Coordinate point, float distance, vector<Sprite*> &nearby, int type){
+	GetSpritesNear(0,point,distance,nearby,type);
+}
+
+void QuadTree::GetSpritesNear(int n, Coordinate point, float distance, vector<Sprite*> &nearby, int type){
 	// The Maximum range is when the center and point are on a 45 degree angle.
 	//   Root-2 of the radius + the distance
-	const float maxrange = V_SQRT2*radius + distance;
+	const float maxrange = V_SQRT2*nodes[n].radius + distance;
 
 	// If the distance to the point is greater than the max range,
 	//   then no collisions are possible
-	if( (point-center).GetMagnitudeSquared() > maxrange*maxrange){
+	if( (point-nodes[n].center).GetMagnitudeSquared() > maxrange*maxrange){
 		return;
 	}
 
-	if(!isLeaf){ // Node
+	if(!nodes[n].isLeaf){ // Node
 		for(int t=0;t<4;t++){
-			if(NULL != (subtrees[t])){
-				subtrees[t]->GetSpritesNear(point,distance,nearby,type);
+			if(nodes[n].subtrees[t] >= 0){
+				GetSpritesNear(nodes[n].subtrees[t],point,distance,nearby,type);
 			}
 		}
 	} else { // Leaf
-		list<Sprite*>::iterator i;
-		for( i = objects->begin(); i != objects->end(); ++i ) {
-			if( ((*i)->GetDrawOrder() & type) == 0) continue;
-			if( (point - (*i)->GetWorldPosition()).GetMagnitudeSquared() < distance*distance + (*i)->GetRadarSize()*(*i)->GetRadarSize() ) {
-				nearby->push_back( *i);
+		for(unsigned int i=0; i<nodes[n].numObjects; i++){
+			Sprite* obj = LeafGet(n,i);
+			if( (obj->GetDrawOrder() & type) == 0) continue;
+			if( (point - obj->GetWorldPosition()).GetMagnitudeSquared() < distance*distance + obj->GetRadarSize()*obj->GetRadarSize() ) {
+				nearby.push_back( obj );
 			}
 		}
 	}
@@ -245,9 +341,13 @@ void QuadTree::GetSpritesNear(Coordinate point, float distance, list<Sprite*> *n
  */
 
 Sprite* QuadTree::GetNearestSprite(Sprite* obj, float distance, int type){
+	return GetNearestSprite(0,obj,distance,type);
+}
+
+Sprite* QuadTree::GetNearestSprite(int n, Sprite* obj, float distance, int type){
 	// The Maximum range is when the center and point are on a 45 degree angle.
 	//   Root-2 of the radius + the distance
-	const float maxrange = V_SQRT2*radius + distance;
+	const float maxrange = V_SQRT2*nodes[n].radius + distance;
 	Sprite* closest=NULL;
 	Sprite* possible=NULL;
 	float tmpdist;
@@ -256,15 +356,15 @@ Sprite* QuadTree::GetNearestSprite(Sprite* obj, float distance, int type){
 
 	// If the distance to the point is greater than the max range,
 	//   then no collisions are possible
-	if( (point-center).GetMagnitudeSquared() > maxrange*maxrange){
+	if( (point-nodes[n].center).GetMagnitudeSquared() > maxrange*maxrange){
 		return NULL;
 	}
-	if(!isLeaf){ // Node
+	if(!nodes[n].isLeaf){ // Node
 		// Nodes work in linear space
 		mindist=distance;
 		for(int t=0;t<4;t++){
-			if(NULL != (subtrees[t])){
-				possible = subtrees[t]->GetNearestSprite(obj,distance,type);
+			if(nodes[n].subtrees[t] >= 0){
+				possible = GetNearestSprite(nodes[n].subtrees[t],obj,distance,type);
 				if(possible==NULL) continue; // This tree short circuited
 				tmpdist = (point-possible->GetWorldPosition()).GetMagnitude();
 				if( tmpdist < mindist ){
@@ -276,14 +376,14 @@ Sprite* QuadTree::GetNearestSprite(Sprite* obj, float distance, int type){
 	} else { // Leaf
 		// Leaves work in square space
 		mindist=distance*distance;
-		list<Sprite*>::iterator i;
-		for( i = objects->begin(); i != objects->end(); ++i ) {
-			if(((*i) == obj) || (((*i)->GetDrawOrder() & type) == 0))
+		for(unsigned int i=0; i<nodes[n].numObjects; i++){
+			possible = LeafGet(n,i);
+			if((possible == obj) || ((possible->GetDrawOrder() & type) == 0))
 				continue;
-			tmpdist = (point - (*i)->GetWorldPosition()).GetMagnitudeSquared();
+			tmpdist = (point - possible->GetWorldPosition()).GetMagnitudeSquared();
 			if( tmpdist < mindist ) {
 				mindist = tmpdist;
-				closest = (*i);
+				closest = possible;
 			}
 		}
 	}
@@ -296,68 +396,85 @@ Sprite* QuadTree::GetNearestSprite(Sprite* obj, float distance, int type){
  * Any Sprites that can be re-inserted into this QuadTree will be re-inserted.
  * Sprites that are outside of this this QuadTree are removed and forgotten.
  *
- * \returns List of all Sprites outside of this QuadTree.
+ * \arg outofbounds [out] All Sprites outside of this QuadTree are appended here.
+ *      The caller should reuse this between calls so that it does not need to grow.
  */
 
-list<Sprite*> *QuadTree::FixOutOfBounds(){
-	list<Sprite*>::iterator i;
-	list<Sprite*> *other;
-	list<Sprite*> *stillinside = new list<Sprite*>();
-	list<Sprite*> *outofbounds = new list<Sprite*>();
-	if(!isLeaf){ // Node
+void QuadTree::FixOutOfBounds(vector<Sprite*> &outofbounds){
+	FixOutOfBounds(0,outofbounds);
+}
+
+void QuadTree::FixOutOfBounds(int n, vector<Sprite*> &outofbounds){
+	const unsigned int first = outofbounds.size();
+	unsigned int i;
+	if(!nodes[n].isLeaf){ // Node
 		// Collect out of bound sprites from sub-trees
 		for(int t=0;t<4;t++){
-			if(NULL != (subtrees[t])){
-				other = subtrees[t]->FixOutOfBounds();
-				outofbounds->splice(outofbounds->end(),*other);
-				delete other;
+			if(nodes[n].subtrees[t] >= 0){
+				FixOutOfBounds(nodes[n].subtrees[t],outofbounds);
 			}
 		}
-		objectcount-= outofbounds->size();
-		if(outofbounds->size()) isDirty=true;
+		nodes[n].objectcount -= outofbounds.size() - first;
+		if(outofbounds.size() > first) nodes[n].isDirty=true;
 		// Insert any sprites that are inside of this Tree
-		for( i = outofbounds->begin(); i != outofbounds->end(); ++i ) {
-			if( this->Contains((*i)->GetWorldPosition()) ) {
-				stillinside->push_back(*i);
+		for( i = first; i < outofbounds.size(); ) {
+			if( Contains(n,outofbounds[i]->GetWorldPosition()) ) {
+				Insert(n,outofbounds[i]);
+				outofbounds[i] = outofbounds.back();
+				outofbounds.pop_back();
+			} else {
+				++i;
 			}
 		}
-		for( i = stillinside->begin(); i != stillinside->end(); ++i ) {
-			this->Insert(*i);
-			outofbounds->remove(*i);
-		}
 	} else { // Leaf
 		// Collect and forget any out of bound sprites from object list
-		for( i = objects->begin(); i != objects->end(); ++i ) {
-			if(! this->Contains((*i)->GetWorldPosition()) ) {
-				outofbounds->push_back( *i );
+		for( i = nodes[n].numObjects; i > 0; --i ) {
+			Sprite* obj = LeafGet(n,i-1);
+			if(! Contains(n,obj->GetWorldPosition()) ) {
+				outofbounds.push_back( obj );
+				LeafRemove(n,i-1);
 			}
 		}
-		for( i = outofbounds->begin(); i != outofbounds->end(); ++i ) {
-			objects->remove(*i);
-		}
-		objectcount-= outofbounds->size();
+		nodes[n].objectcount -= outofbounds.size() - first;
 	}
-	delete stillinside;
-	if(outofbounds->size()) isDirty=true;
-	// Return any sprites that couldn't be re-inserted
-	return outofbounds;
+	if(outofbounds.size() > first) nodes[n].isDirty=true;
 }
 
 /** \brief Update all Sprites in this QuadTree
  */
 
 void QuadTree::Update(){
-	list<Sprite*>::iterator i;
+	Update(0,DRAW_ORDER_ALL,NULL);
+}
+
+/** \brief Update only some of the Sprites in this QuadTree
+ *
+ * \arg type A DRAW_ORDER mask of the Sprites that should be updated.
+ * \arg skipped [out] The Sprites that are not of this type are appended here, in the order that they would have been updated.
+ */
+
+void QuadTree::Update(int type, vector<Sprite*> &skipped){
+	Update(0,type,&skipped);
+}
+
+void QuadTree::Update(int n, int type, vector<Sprite*> *skipped){
 	// Update all internal sprites
-	if(!isLeaf){ // Node
+	// Sprites may add new Sprites to this QuadTree while they Update,
+	// so the pool is re-indexed rather than referenced.
+	if(!nodes[n].isLeaf){ // Node
 		for(int t=0;t<4;t++){
-			if(NULL != (subtrees[t])){
-				subtrees[t]->Update();
+			if(nodes[n].subtrees[t] >= 0){
+				Update(nodes[n].subtrees[t],type,skipped);
 			}
 		}
 	} else { // Leaf
-		for( i = objects->begin(); i != objects->end(); ++i ) {
-			(*i)->Update();
+		for(unsigned int i=0; i<nodes[n].numObjects; i++){
+			Sprite* obj = LeafGet(n,i);
+			if( obj->GetDrawOrder() & type ) {
+				obj->Update();
+			} else {
+				skipped->push_back( obj );
+			}
 		}
 	}
 }
@@ -370,53 +487,59 @@ void QuadTree::Update(){
  */
 
 void QuadTree::Draw(Coordinate root){
+	Draw(0,root);
+}
+
+void QuadTree::Draw(int n, Coordinate root){
 	// The QuadTree is scaled so that it always fits on the screen.
 	float scale = (Video::GetHalfHeight() > Video::GetHalfWidth() ?
 		static_cast<float>(Video::GetHalfWidth()) : static_cast<float>(Video::GetHalfHeight()) -5);
-	float r = scale* radius / QUADRANTSIZE;
-	float x = (scale* static_cast<float>((center-root).GetX()) / QUADRANTSIZE)
+	float r = scale* nodes[n].radius / QUADRANTSIZE;
+	float x = (scale* static_cast<float>((nodes[n].center-root).GetX()) / QUADRANTSIZE)
 		+ static_cast<float>(Video::GetHalfWidth())  -r;
-	float y = (scale* static_cast<float>((center-root).GetY()) / QUADRANTSIZE)
+	float y = (scale* static_cast<float>((nodes[n].center-root).GetY()) / QUADRANTSIZE)
 		+ static_cast<float>(Video::GetHalfHeight()) -r;
 	Video::DrawRect( static_cast<int>(x),static_cast<int>(y),
 		static_cast<int>(2*r),static_cast<int>(2*r), 0,255.f,0.f, .1f);
 
-	if(!isLeaf){ // Node
+	if(!nodes[n].isLeaf){ // Node
 		for(int t=0;t<4;t++){
-			if(NULL != (subtrees[t])) subtrees[t]->Draw(root);
+			if(nodes[n].subtrees[t] >= 0) Draw(nodes[n].subtrees[t],root);
 		}
 	} else { // Leaf
-		list<Sprite *>::iterator i;
-		for( i = objects->begin(); i != objects->end(); ++i ) {
-			Coordinate pos = (*i)->GetWorldPosition() - root;
+		for(unsigned int i=0; i<nodes[n].numObjects; i++){
+			Sprite* obj = LeafGet(n,i);
+			Coordinate pos = obj->GetWorldPosition() - root;
 			int posx = static_cast<int>((scale* (float)pos.GetX() / QUADRANTSIZE) + (float)Video::GetHalfWidth());
 			int posy = static_cast<int>((scale* (float)pos.GetY() / QUADRANTSIZE) + (float)Video::GetHalfHeight());
-			Color col = (*i)->GetRadarColor();
+			Color col = obj->GetRadarColor();
 			// The 17 is here because it looks nice.  I can't explain why.
-			Video::DrawCircle( posx, posy, static_cast<int>(17.f*(*i)->GetRadarSize()/scale),2, col.r,col.g,col.b );
+			Video::DrawCircle( posx, posy, static_cast<int>(17.f*obj->GetRadarSize()/scale),2, col.r,col.g,col.b );
 		}
 	}
 }
 
 /** \brief Get the QuadTree Position that would contain a point
+ * \arg n The pool index of the Node.
  * \arg point The point that we're checking.
  * \returns The QuadTree Position.
  */
 
-QuadPosition QuadTree::SubTreeThatContains(Coordinate point){
-	bool rightOfCenter = point.GetX() > center.GetX();
-	bool aboveCenter = point.GetY() > center.GetY();
+QuadPosition QuadTree::SubTreeThatContains(int n, Coordinate point){
+	bool rightOfCenter = point.GetX() > nodes[n].center.GetX();
+	bool aboveCenter = point.GetY() > nodes[n].center.GetY();
 	int pos =  (aboveCenter?0:2) | (rightOfCenter?1:0);
-	assert(this->Contains(point)); // Ensure that this point is in this region
+	assert(Contains(n,point)); // Ensure that this point is in this region
 	return QuadPosition(pos);
 }
 
 /** \brief Build a new subtree at the given QuadPosition
+ * \arg n The pool index of the Node.
  * \arg pos The QuadPosition that should be created.
  */
 
-void QuadTree::CreateSubTree(QuadPosition pos){
-	float half = radius/2;
+void QuadTree::CreateSubTree(int n, QuadPosition pos){
+	float half = nodes[n].radius/2;
 	// Each subtree has a specific new center
 	Coordinate offset;
 	switch(pos){
@@ -427,9 +550,9 @@ void QuadTree::CreateSubTree(QuadPosition pos){
 		case LOWER_RIGHT: offset = Coordinate(+half,-half); break;
 		default: assert(0);
 	}
-	assert(subtrees[pos]==NULL);
-	subtrees[pos] = new QuadTree(center+offset,half);
-	assert(subtrees[pos]!=NULL);
+	assert(nodes[n].subtrees[pos]<0);
+	int subtree = NewNode(nodes[n].center+offset,half);
+	nodes[n].subtrees[pos] = subtree;
 }
 
 /** \brief Insert an object into a SubTree
@@ -438,12 +561,12 @@ void QuadTree::CreateSubTree(QuadPosition pos){
  *  It doesn't do any accounting for this Tree.
  */
 
-void QuadTree::InsertSubTree(Sprite *obj){
-	QuadPosition pos = SubTreeThatContains( obj->GetWorldPosition() );
-	if(subtrees[pos]==NULL)
-		CreateSubTree(pos);
-	assert(subtrees[pos]!=NULL);
-	subtrees[pos]->Insert(obj);
+void QuadTree::InsertSubTree(int n, Sprite *obj){
+	QuadPosition pos = SubTreeThatContains( n, obj->GetWorldPosition() );
+	if(nodes[n].subtrees[pos]<0)
+		CreateSubTree(n,pos);
+	assert(nodes[n].subtrees[pos]>=0);
+	Insert(nodes[n].subtrees[pos],obj);
 }
 
 /** \brief Ballance the QuadTree by splitting and merging subtrees
@@ -456,50 +579,62 @@ void QuadTree::InsertSubTree(Sprite *obj){
  */
 
 void QuadTree::ReBallance(){
-	unsigned int numObjects = this->Count();
-	list<Sprite*>::iterator i;
-	
-	if( isDirty && isLeaf && numObjects>QUADMAXOBJECTS && radius>MIN_QUAD_SIZE){
+	ReBallance(0);
+}
+
+void QuadTree::ReBallance(int n){
+	unsigned int numObjects = nodes[n].objectcount;
+	unsigned int i;
+
+	if( nodes[n].isDirty && nodes[n].isLeaf && numObjects>QUADMAXOBJECTS && nodes[n].radius>MIN_QUAD_SIZE){
 		//cout << "LEAF at "<<center<<" is becoming a NODE.\n";
-		isLeaf = false;
+		nodes[n].isLeaf = false;
 
-		assert(0 != objects->size()); // The Leaf list should not be empty
-		
-		for( i = objects->begin(); i != objects->end(); ++i ) {
-			InsertSubTree(*i);
+		assert(0 != nodes[n].numObjects); // The Leaf list should not be empty
+
+		// Creating the subtrees may grow the pool, so move the Sprites out first.
+		scratch.clear();
+		for( i = 0; i < nodes[n].numObjects; i++ ) {
+			scratch.push_back( LeafGet(n,i) );
+		}
+		nodes[n].numObjects = 0;
+		nodes[n].overflow.clear();
+		for( i = 0; i < scratch.size(); i++ ) {
+			InsertSubTree(n,scratch[i]);
 		}
-		assert(!isLeaf); // Still a Node
-		this->objects->clear();
-	} else if(isDirty && !isLeaf && numObjects<=QUADMAXOBJECTS ){
-		assert(0 == objects->size()); // The Leaf list should be empty
+		assert(!nodes[n].isLeaf); // Still a Node
+	} else if(nodes[n].isDirty && !nodes[n].isLeaf && numObjects<=QUADMAXOBJECTS ){
+		assert(0 == nodes[n].numObjects); // The Leaf list should be empty
 		//cout << "NODE at "<<center<<" is becoming a LEAF.\n";
-		isLeaf = true;
+		nodes[n].isLeaf = true;
 		for(int t=0;t<4;t++){
-			if(NULL != (subtrees[t])){
-				list<Sprite*> *other = subtrees[t]->GetSprites();
-				for( i = other->begin(); i != other->end(); ++i ) {
-					objects->push_back( *i );
+			int subtree = nodes[n].subtrees[t];
+			if(subtree >= 0){
+				scratch.clear();
+				GetSprites(subtree,scratch);
+				for( i = 0; i < scratch.size(); i++ ) {
+					LeafAdd( n, scratch[i] );
 				}
-				delete other;
-				delete subtrees[t];
-				subtrees[t] = NULL;
+				FreeNode(subtree);
+				nodes[n].subtrees[t] = -1;
 			}
 		}
-		assert(isLeaf); // Still a Leaf
+		assert(nodes[n].isLeaf); // Still a Leaf
 	}
 	// ReBallance the subtrees
 	for(int t=0;t<4;t++){
-		if(NULL != (subtrees[t])){
-			if(subtrees[t]->Count()==0){
-				delete subtrees[t];
-				subtrees[t] = NULL;
+		int subtree = nodes[n].subtrees[t];
+		if(subtree >= 0){
+			if(nodes[subtree].objectcount==0){
+				FreeNode(subtree);
+				nodes[n].subtrees[t] = -1;
 			} else {
-				subtrees[t]->ReBallance();
+				ReBallance(subtree);
 			}
 		}
 	}
-	isDirty=false;
-	assert(numObjects == this->Count()); // ReBallancing should never change the total number of elements
+	nodes[n].isDirty=false;
+	assert(numObjects == nodes[n].objectcount); // ReBallancing should never change the total number of elements
 }
 
 /** \brief Generate an XML Node of this QuadTree.
@@ -510,28 +645,33 @@ void QuadTree::ReBallance(){
  */
 
 xmlNodePtr QuadTree::ToNode() {
+	return ToNode(0);
+}
+
+xmlNodePtr QuadTree::ToNode(int n) {
 	xmlNodePtr thisNode, objNode;
 	char buff[256];
-	list<Sprite*>::iterator i;
+	Sprite* obj;
 
 	thisNode = xmlNewNode(NULL, BAD_CAST "QuadTree" );
 
-	snprintf(buff, sizeof(buff), "%d", (int) center.GetX() );
+	snprintf(buff, sizeof(buff), "%d", (int) nodes[n].center.GetX() );
 	xmlSetProp( thisNode, BAD_CAST "x", BAD_CAST buff );
-	snprintf(buff, sizeof(buff), "%d", (int) center.GetY() );
+	snprintf(buff, sizeof(buff), "%d", (int) nodes[n].center.GetY() );
 	xmlSetProp( thisNode, BAD_CAST "y", BAD_CAST buff );
-	snprintf(buff, sizeof(buff), "%d", (int) this->radius );
+	snprintf(buff, sizeof(buff), "%d", (int) nodes[n].radius );
 	xmlSetProp( thisNode, BAD_CAST "r", BAD_CAST buff );
 	
-	if(!isLeaf){ // Node
+	if(!nodes[n].isLeaf){ // Node
 		for(int t=0;t<4;t++){
-			if(NULL != (subtrees[t])){
-				xmlAddChild(thisNode, subtrees[t]->ToNode() );
+			if(nodes[n].subtrees[t] >= 0){
+				xmlAddChild(thisNode, ToNode(nodes[n].subtrees[t]) );
 			}
 		}
 	} else { // Leaf
-		for( i = objects->begin(); i != objects->end(); ++i ) {
-			switch((*i)->GetDrawOrder()) {
+		for(unsigned int i=0; i<nodes[n].numObjects; i++){
+			obj = LeafGet(n,i);
+			switch(obj->GetDrawOrder()) {
 				case DRAW_ORDER_PLANET:
 					snprintf(buff, sizeof(buff), "%s", "Planet" );
 					break;
@@ -553,16 +693,16 @@ xmlNodePtr QuadTree::ToNode() {
 				case DRAW_ORDER_GATE_BOTTOM: // Ignore
 					continue;
 				default:
-					LogMsg(ERR,"Unknown Sprite Type: %d",(*i)->GetDrawOrder());
+					LogMsg(ERR,"Unknown Sprite Type: %d",obj->GetDrawOrder());
 					assert(0);
 					break;
 			}
 			objNode = xmlNewNode(NULL, BAD_CAST buff);
-			snprintf(buff, sizeof(buff), "%d", (int) (*i)->GetWorldPosition().GetX() );
+			snprintf(buff, sizeof(buff), "%d", (int) obj->GetWorldPosition().GetX() );
 			xmlSetProp( objNode, BAD_CAST "x", BAD_CAST buff );
-			snprintf(buff, sizeof(buff), "%d", (int) (*i)->GetWorldPosition().GetY() );
+			snprintf(buff, sizeof(buff), "%d", (int) obj->GetWorldPosition().GetY() );
 			xmlSetProp( objNode, BAD_CAST "y", BAD_CAST buff );
-			snprintf(buff, sizeof(buff), "%d", (int) (*i)->GetAngle() );
+			snprintf(buff, sizeof(buff), "%d", (int) obj->GetAngle() );
 			xmlSetProp( objNode, BAD_CAST "angle", BAD_CAST buff );
 			xmlAddChild(thisNode, objNode);
 		}
@@ -35,35 +35,66 @@ class QuadTree {
 		bool Delete(Sprite* obj);
 
 		list<Sprite*> *GetSprites();
-		void GetSpritesNear(Coordinate point, float distance, list<Sprite*> *returnList, int type = DRAW_ORDER_ALL);
+		void GetSpritesNear(Coordinate point, float distance, vector<Sprite*> &nearby, int type = DRAW_ORDER_ALL);
 		Sprite* GetNearestSprite(Sprite* obj, float distance, int type = DRAW_ORDER_ALL);
-		list<Sprite*> *FixOutOfBounds();
+		void FixOutOfBounds(vector<Sprite*> &outofbounds);
 
 		void Update();
+		void Update(int type, vector<Sprite*> &skipped);
 		void Draw(Coordinate root);
 		void ReBallance();
 
 		xmlNodePtr ToNode();
 
 	private:
-		QuadPosition SubTreeThatContains(Coordinate point);
-		void CreateSubTree(QuadPosition pos);
-		void InsertSubTree(Sprite* obj);
+		// A single Node or Leaf.  These live in the nodes pool and refer to each other by index.
+		struct QuadNode {
+			Coordinate center;
+			float radius;
+			int subtrees[4]; ///< Pool index of each branch, or -1 when there is no branch.
+			unsigned int objectcount; ///< Sprites within this Node or Leaf.
+			unsigned int numObjects; ///< Sprites stored directly in this Leaf.
+			Sprite* objects[QUADMAXOBJECTS]; ///< The first few Sprites of a Leaf.
+			vector<Sprite*> overflow; ///< Any further Sprites of a Leaf (only used until it splits).
+			union{
+				// Unnamed struct so that these flags can be accessed directly
+				struct{
+					Uint32 isLeaf:1;
+					Uint32 isDirty:1;
+					Uint32 extra:30;
+				};
+				Uint32 flags;
+			};
+		};
+
+		int NewNode(Coordinate center, float radius);
+		void FreeNode(int n);
+
+		Sprite* LeafGet(int n, unsigned int i);
+		void LeafAdd(int n, Sprite* obj);
+		void LeafRemove(int n, unsigned int i);
 
-		QuadTree* subtrees[4];
-		list<Sprite*> *objects;
+		bool Contains(int n, Coordinate point);
+		void Insert(int n, Sprite* obj);
+		bool Delete(int n, Sprite* obj);
+		void GetSprites(int n, vector<Sprite*> &sprites);
+		void GetSpritesNear(int n, Coordinate point, float distance, vector<Sprite*> &nearby, int type);
+		Sprite* GetNearestSprite(int n, Sprite* obj, float distance, int type);
+		void FixOutOfBounds(int n, vector<Sprite*> &outofbounds);
+		void Update(int n, int type, vector<Sprite*> *skipped);
+		void Draw(int n, Coordinate root);
+		void ReBallance(int n);
+		xmlNodePtr ToNode(int n);
+
+		QuadPosition SubTreeThatContains(int n, Coordinate point);
+		void CreateSubTree(int n, QuadPosition pos);
+		void InsertSubTree(int n, Sprite* obj);
+
+		vector<QuadNode> nodes; ///< Every Node and Leaf of this QuadTree.  The root is always at 0.
+		vector<int> freeNodes; ///< Pool indices that can be reused.
+		vector<Sprite*> scratch; ///< Reused while splitting a Leaf.
 		Coordinate center;
 		float radius;
-		unsigned int objectcount;
-		union{
-			// Unnamed struct so that these flags can be accessed directly
-			struct{
-				Uint32 isLeaf:1;
-				Uint32 isDirty:1;
-				Uint32 extra:30;
-			};
-			Uint32 flags;
-		};
 };
 
 inline bool QuadTree::PossiblyNear(Coordinate point, float distance) {
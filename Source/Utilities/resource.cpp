@@ -14,59 +14,101 @@
  *  \details The Resource class provides a simple way to use Memory efficiently
  *  without having duplicate instances of the same object.  Resources are
  *  stored using a key (usually a path) and a pointer to the concrete object
- *  allocated on the heap.  This key is then stored into a master lookup table
- *  (an STL map) so that it can be retrieved later.  From then on, any attempt
- *  to access that object will not have to load the object.
+ *  allocated on the heap.  The key is interned: the first time a path is seen
+ *  it is given a small integer ID, kept in a hash table.  Each kind of
+ *  Resource has its own table indexed by that ID, so that it can be retrieved
+ *  later.  From then on, any attempt to access that object will not have to
+ *  load the object.
  *
  *  All Resource subclasses should implement their own static "Get" function.
  *  This function should first attempt to retieve the Resource from the master
  *  Resource class.  If that fails, the subclass::Get should load the object
- *  and store it into the master Resource map.  This means that only the first
- *  attempt to Get a Resource requires the object to be loaded from the OS, all
- *  later Get attempts should be very fast.
+ *  and store it into the Resource table of its type.  This means that only the
+ *  first attempt to Get a Resource requires the object to be loaded from the
+ *  OS, all later Get attempts should be very fast.
  *
- *  Each key will only point to a single Resource object, but multiple names
- *  can point to the same Resource.  For example, a model image might be stored
- *  as both the relative path and the model's name.
+ *  Code that asks for the same Resource over and over (every frame, say)
+ *  should keep a ResourceHandle, which only does the lookup once.
+ *
+ *  Each key will only point to a single Resource object of each type, but
+ *  multiple names can point to the same Resource.  For example, a model image
+ *  might be stored as both the relative path and the model's name.
  *
  *  \note Currently, Resources are never freed.  The assumption here is that
  *  all Resouces will be used again in the lifetime of the game.  This may
  *  change in later versions of Epiar.
  *
- *  \warning There is only one main resource lookup table.  If different
- *  Resource subclasses attempt to use the same key for different objects then
- *  errors will occur.
- *
- *  \see Image, Ani, Sound
+ *  \see Image, Ani, Sound, ResourceHandle
+ */
+
+/** \brief Makes a hash table entry for a path.
+ */
+ResourcePath::ResourcePath( const string& _path, int _id ) : path(_path), id(_id) {
+	// FNV-1a
+	unsigned int h = 2166136261u;
+	for( string::size_type i = 0; i < path.length(); i++ ) {
+		h ^= (unsigned char)path[i];
+		h *= 16777619u;
+	}
+	hashVal = (int)( h & 0x7FFFFFFF );
+}
+
+/** \brief Every path that has been used as a key, and its ID.
  */
+HashTable<ResourcePath> Resource::paths( 1021 );
 
-/** \brief The Master Resource Map.
- *  \warning This map is shared by all Resource subclasses.
+/** \brief The Resources of each type, indexed by the ID of their key.
  */
-map<string, Resource*> Resource::values;
+vector<Resource*> Resource::values[RESOURCE_TYPES];
 
 /** \brief Empty Resource constructor.
  */
 Resource::Resource() {
 }
 
+/** \brief Finds the ID of a path, giving it a new one if it is new.
+ *  \details IDs are never reused, so they count up from 0.
+ */
+int Resource::Intern( const string& path ) {
+	ResourcePath entry( path );
+	if( paths.contains( entry ) ) {
+		return entry.id;
+	}
+	entry.id = paths.size();
+	paths.insert( entry );
+	return entry.id;
+}
+
 /** \brief Store a Resource given a Key and pointer.
- *  \warning, attempting to store multiple resources using the same key will
- *  cause the previous object to be lost.
- *  \TODO Ensure that keys are not reused for different Resource objects.
+ *  \details If the key already has a Resource of this type, it is kept and
+ *  res is ignored.
  *  \TODO Fix potential memory leak.
  */
-void Resource::Store(string key,Resource *res) {
-	values.insert(make_pair(key,res));
+void Resource::Store( ResourceType type, const string& key, Resource *res ) {
+	vector<Resource*> &table = values[type];
+	unsigned int id = Intern( key );
+	if( id >= table.size() ) {
+		table.resize( id + 1, NULL );
+	}
+	if( table[id] == NULL ) {
+		table[id] = res;
+	}
 }
 
 /** \brief Retrieve a stored Resource
  *  \returns The Resource pointer or NULL.
  */
-Resource* Resource::Get(string path) {
-	map<string,Resource*>::iterator val = values.find( path );
-	if( val != values.end() ){
-		return val->second;
-	} 
-	return NULL;
+Resource* Resource::Get( ResourceType type, const string& path ) {
+	return Get( type, Intern( path ) );
+}
+
+/** \brief Retrieve a stored Resource by the ID of its key
+ *  \returns The Resource pointer or NULL.
+ */
+Resource* Resource::Get( ResourceType type, int id ) {
+	vector<Resource*> &table = values[type];
+	if( id < 0 || id >= (int)table.size() ) {
+		return NULL;
+	}
+	return table[id];
 }
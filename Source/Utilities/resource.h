@@ -8,17 +8,68 @@
  */
 
 #include "includes.h"
+#include "Utilities/hashtbl.h"
 
 #ifndef __H_RESOURCE_CLASS
 #define __H_RESOURCE_CLASS
 
+/**\brief The kinds of Resource.  Each kind has its own table.
+ */
+enum ResourceType {
+	RESOURCE_IMAGE,
+	RESOURCE_ANIMATION,
+	RESOURCE_FONT,
+	RESOURCE_SOUND,
+	RESOURCE_SONG,
+	RESOURCE_TYPES ///< The number of kinds, not a kind.
+};
+
+/**\brief A path in the table of interned Resource paths.
+ */
+struct ResourcePath {
+	string path;
+	int hashVal;
+	int id; ///< The index of this path in the Resource tables.
+
+	ResourcePath( const string& _path = "", int _id = -1 );
+	int hash( void ) const { return hashVal; }
+	bool operator!=( const ResourcePath &other ) const {
+		return ( hashVal != other.hashVal ) || ( path != other.path );
+	}
+};
+
 class Resource{
 	public:
 		Resource();
-		static void Store(string key, Resource* res);
-		static Resource* Get(string path);
+		static int Intern( const string& path );
+		static void Store( ResourceType type, const string& key, Resource* res );
+		static Resource* Get( ResourceType type, const string& path );
+		static Resource* Get( ResourceType type, int id );
+	private:
+		static HashTable<ResourcePath> paths;
+		static vector<Resource*> values[RESOURCE_TYPES];
+};
+
+/**\brief A typed handle to one Resource that is looked up only once.
+ * \details Code that uses the same Image, Ani or Sound every frame should keep
+ *  a ResourceHandle instead of calling Get with the path each time.  Since
+ *  Resources are never freed, the pointer stays valid once it is found.
+ *  The lookup waits until the first call to Get, so a handle can be static.
+ */
+template<class T> class ResourceHandle {
+	public:
+		ResourceHandle( const string& _path ) : path(_path), resource(NULL) {}
+		T* Get() {
+			if( resource == NULL ) {
+				resource = T::Get( path );
+			}
+			return resource;
+		}
+		const string& GetPath() { return path; }
+
 	private:
-		static map<string,Resource*> values;
+		string path;
+		T* resource; ///< NULL until Get finds the Resource, so a missing one is looked for again.
 };
 
 #endif // __H_RESOURCE__
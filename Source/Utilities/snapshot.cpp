@@ -0,0 +1,345 @@
+/**\file			snapshot.cpp
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Binary copies of the Components XML files
+ * \details
+ */
+
+#include "includes.h"
+#include "common.h"
+#include "Utilities/snapshot.h"
+#include "Utilities/file.h"
+#include "Utilities/filesystem.h"
+#include "Utilities/log.h"
+
+/**\class SnapshotWriter
+ * \brief Writes the component elements of an XML file to a snapshot.
+ * \details
+ * A snapshot holds the same elements and text as the XML file, but as a flat
+ * array of nodes in document order and one table of distinct strings, so it
+ * can be read straight out of a mapped file without parsing any text.
+ * Attributes are kept as well, since some Components read them (Lua
+ * tables saved in a Player are typed by their attributes).  Whitespace
+ * between elements and comments are left out.
+ *
+ * The header records the version of Epiar that wrote the snapshot and the
+ * modification time and size of the XML file, so that an old snapshot is
+ * never used after either of them changes.  XML remains the format that
+ * is edited; the snapshot is only ever a copy of it.
+ *
+ * The fields of each Component are not stored, so FromXMLNode is still the
+ * only code that reads them.  Rebuilding the elements costs far less than
+ * the XML parsing that it replaces.
+ */
+
+/**\brief Starts an empty snapshot.
+ * \param rootName The root element of the XML file.
+ */
+SnapshotWriter::SnapshotWriter( const string& rootName ) {
+	memset( &header, 0, sizeof(header) );
+	header.magic = SNAPSHOT_MAGIC;
+	header.format = SNAPSHOT_FORMAT;
+	header.epiarVersion[0] = EPIAR_VERSION_MAJOR;
+	header.epiarVersion[1] = EPIAR_VERSION_MINOR;
+	header.epiarVersion[2] = EPIAR_VERSION_MICRO;
+	header.rootName = Intern( rootName.c_str() );
+}
+
+/**\brief Records the version written in the XML file.
+ * \details A streamed file may not give its version until after some components.
+ * \param versionMajor The version-major of the XML file.
+ * \param versionMinor The version-minor of the XML file.
+ * \param versionMicro The version-macro of the XML file.
+ */
+void SnapshotWriter::SetFileVersion( int versionMajor, int versionMinor, int versionMicro ) {
+	header.fileVersion[0] = versionMajor;
+	header.fileVersion[1] = versionMinor;
+	header.fileVersion[2] = versionMicro;
+}
+
+/**\brief Copies a component element and everything in it.
+ */
+void SnapshotWriter::Add( xmlNodePtr node ) {
+	AddNode( node );
+	header.componentCount++;
+}
+
+/**\brief Writes the snapshot beside the old one and then replaces it.
+ * \param filename Where the snapshot is kept, from SnapshotName.  Nothing is written if it is "".
+ * \param source The XML file that it was read from.
+ */
+bool SnapshotWriter::Save( const string& filename, const string& source ) {
+	long modTime, fileSize;
+	unsigned int i;
+
+	if( filename == "" || !File::Stat( source, &modTime, &fileSize ) ) {
+		return false;
+	}
+	header.modTime = modTime;
+	header.fileSize = fileSize;
+	header.nodeCount = nodes.size();
+	header.stringCount = strings.size();
+	header.attributeCount = attributes.size();
+
+	// The strings are kept with their terminators so they can be used in place
+	vector<Uint32> offsets( strings.size() );
+	Uint32 offset = sizeof(SnapshotHeader) + nodes.size() * sizeof(SnapshotNode)
+	              + attributes.size() * sizeof(SnapshotAttribute) + strings.size() * sizeof(Uint32);
+	for( i = 0; i < strings.size(); i++ ) {
+		offsets[i] = offset;
+		offset += strings[i].length() + 1;
+	}
+
+	string temporary = filename + ".tmp";
+	FILE *fp = fopen( temporary.c_str(), "wb" );
+	if( fp == NULL ) {
+		LogMsg(WARN, "Could not write the snapshot '%s'.", temporary.c_str() );
+		return false;
+	}
+	bool written = ( fwrite( &header, sizeof(header), 1, fp ) == 1 );
+	if( written && !nodes.empty() ) {
+		written = ( fwrite( &nodes[0], sizeof(SnapshotNode), nodes.size(), fp ) == nodes.size() );
+	}
+	if( written && !attributes.empty() ) {
+		written = ( fwrite( &attributes[0], sizeof(SnapshotAttribute), attributes.size(), fp ) == attributes.size() );
+	}
+	if( written && !offsets.empty() ) {
+		written = ( fwrite( &offsets[0], sizeof(Uint32), offsets.size(), fp ) == offsets.size() );
+	}
+	for( i = 0; written && i < strings.size(); i++ ) {
+		written = ( fwrite( strings[i].c_str(), 1, strings[i].length() + 1, fp ) == strings[i].length() + 1 );
+	}
+	if( fclose( fp ) != 0 ) {
+		written = false;
+	}
+	if( !written ) {
+		LogMsg(WARN, "Could not write the snapshot '%s'.", temporary.c_str() );
+		remove( temporary.c_str() );
+		return false;
+	}
+
+	remove( filename.c_str() );
+	if( rename( temporary.c_str(), filename.c_str() ) != 0 ) {
+		LogMsg(WARN, "Could not replace the snapshot '%s'.", filename.c_str() );
+		remove( temporary.c_str() );
+		return false;
+	}
+	LogMsg(INFO, "Wrote %d components of '%s' to the snapshot '%s'.", header.componentCount, source.c_str(), filename.c_str() );
+	return true;
+}
+
+/**\brief Copies an element and its children (Internal use)
+ */
+void SnapshotWriter::AddNode( xmlNodePtr node ) {
+	Uint32 index = nodes.size();
+	long line = xmlGetLineNo( node );
+	SnapshotNode added;
+	added.name = Intern( (const char*)node->name );
+	added.text = SNAPSHOT_NO_TEXT;
+	added.children = 0;
+	added.line = ( line > 0 ) ? line : 0;
+	added.attributes = 0;
+
+	for( xmlAttrPtr attr = node->properties; attr != NULL; attr = attr->next ) {
+		SnapshotAttribute copied;
+		xmlChar *value = xmlNodeGetContent( (xmlNodePtr)attr );
+		copied.name = Intern( (const char*)attr->name );
+		copied.value = Intern( value ? (const char*)value : "" );
+		xmlFree( value );
+		attributes.push_back( copied );
+		added.attributes++;
+	}
+
+	// NodeToString only reads the first child
+	xmlNodePtr child = node->xmlChildrenNode;
+	if( child != NULL && ( child->type == XML_TEXT_NODE || child->type == XML_CDATA_SECTION_NODE ) ) {
+		xmlChar *content = xmlNodeGetContent( child );
+		added.text = Intern( (const char*)content );
+		xmlFree( content );
+	}
+	nodes.push_back( added );
+
+	for( ; child != NULL; child = child->next ) {
+		if( child->type == XML_ELEMENT_NODE ) {
+			AddNode( child );
+			nodes[index].children++;
+		}
+	}
+}
+
+/**\brief Finds or adds a string (Internal use)
+ */
+Uint32 SnapshotWriter::Intern( const char *str ) {
+	map<string,Uint32>::iterator found = stringIds.find( str );
+	if( found != stringIds.end() ) {
+		return found->second;
+	}
+	Uint32 id = strings.size();
+	strings.push_back( str );
+	stringIds[str] = id;
+	return id;
+}
+
+/**\class SnapshotReader
+ * \brief Rebuilds the component elements of a snapshot.
+ * \details
+ * NextComponent builds one component element at a time in a document, so
+ * that it can be given to Component::FromXMLNode and then freed.
+ */
+
+/**\brief Creates a reader without a snapshot.
+ */
+SnapshotReader::SnapshotReader( void ):
+	header(NULL), nodes(NULL), attributes(NULL), offsets(NULL), next(0), nextAttribute(0)
+{
+}
+
+/**\brief Maps a snapshot if it is still a copy of its XML file.
+ * \param filename Where the snapshot is kept.
+ * \param source The XML file that it was read from.
+ * \return false if the snapshot is missing, damaged or out of date.
+ */
+bool SnapshotReader::Open( const string& filename, const string& source ) {
+	long modTime, fileSize;
+
+	header = NULL;
+	next = 0;
+	nextAttribute = 0;
+	if( filename == "" || !file.Open( filename ) ) {
+		return false;
+	}
+	if( !File::Stat( source, &modTime, &fileSize ) || !Validate() ) {
+		file.Close();
+		return false;
+	}
+	if( header->modTime != (Sint64)modTime || header->fileSize != (Uint32)fileSize ) {
+		LogMsg(INFO, "The snapshot '%s' is older than '%s'.", filename.c_str(), source.c_str() );
+		header = NULL;
+		file.Close();
+		return false;
+	}
+	return true;
+}
+
+/**\brief The version written in the XML file.
+ */
+void SnapshotReader::GetFileVersion( int *major, int *minor, int *micro ) {
+	*major = header->fileVersion[0];
+	*minor = header->fileVersion[1];
+	*micro = header->fileVersion[2];
+}
+
+/**\brief Builds the next component element.
+ * \details The element belongs to doc, but isn't linked into it.
+ * \return The element, or NULL after the last one.
+ */
+xmlNodePtr SnapshotReader::NextComponent( xmlDocPtr doc ) {
+	if( header == NULL || next >= header->nodeCount ) {
+		return NULL;
+	}
+	return BuildNode( doc );
+}
+
+/**\brief Checks the header and that every node and string is inside the file (Internal use)
+ * \details After this, nothing that is read from the snapshot needs checking.
+ */
+bool SnapshotReader::Validate( void ) {
+	const unsigned char *data = file.GetData();
+	long length = file.GetLength();
+	Uint32 i;
+
+	header = (const SnapshotHeader*)data;
+	if( length < (long)sizeof(SnapshotHeader)
+	 || header->magic != SNAPSHOT_MAGIC
+	 || header->format != SNAPSHOT_FORMAT
+	 || header->epiarVersion[0] != EPIAR_VERSION_MAJOR
+	 || header->epiarVersion[1] != EPIAR_VERSION_MINOR
+	 || header->epiarVersion[2] != EPIAR_VERSION_MICRO ) {
+		header = NULL;
+		return false;
+	}
+
+	long stringStart = sizeof(SnapshotHeader) + (long)header->nodeCount * sizeof(SnapshotNode)
+	                 + (long)header->attributeCount * sizeof(SnapshotAttribute) + (long)header->stringCount * sizeof(Uint32);
+	if( length < stringStart || data[length - 1] != '\0' || header->rootName >= header->stringCount ) {
+		header = NULL;
+		return false;
+	}
+	nodes = (const SnapshotNode*)( data + sizeof(SnapshotHeader) );
+	attributes = (const SnapshotAttribute*)( nodes + header->nodeCount );
+	offsets = (const Uint32*)( attributes + header->attributeCount );
+
+	// Since the file ends with a terminator, every string in it is terminated
+	for( i = 0; i < header->stringCount; i++ ) {
+		if( offsets[i] < stringStart || offsets[i] >= length ) {
+			header = NULL;
+			return false;
+		}
+	}
+
+	for( i = 0; i < header->attributeCount; i++ ) {
+		if( attributes[i].name >= header->stringCount || attributes[i].value >= header->stringCount ) {
+			header = NULL;
+			return false;
+		}
+	}
+
+	// Every component's elements must fit in the nodes exactly, and their attributes in the attributes
+	Uint32 components = 0, unvisited = 0, attributeTotal = 0;
+	for( i = 0; i < header->nodeCount; i++ ) {
+		if( unvisited == 0 ) {
+			components++;
+		} else {
+			unvisited--;
+		}
+		if( nodes[i].name >= header->stringCount
+		 || ( nodes[i].text != SNAPSHOT_NO_TEXT && nodes[i].text >= header->stringCount )
+		 || nodes[i].children > header->nodeCount - i - 1 - unvisited
+		 || nodes[i].attributes > header->attributeCount - attributeTotal ) {
+			header = NULL;
+			return false;
+		}
+		unvisited += nodes[i].children;
+		attributeTotal += nodes[i].attributes;
+	}
+	if( unvisited != 0 || components != header->componentCount || attributeTotal != header->attributeCount ) {
+		header = NULL;
+		return false;
+	}
+	return true;
+}
+
+/**\brief Builds the element at next, and its children (Internal use)
+ */
+xmlNodePtr SnapshotReader::BuildNode( xmlDocPtr doc ) {
+	const SnapshotNode *source = &nodes[next++];
+	xmlNodePtr node = xmlNewDocNode( doc, NULL, BAD_CAST String( source->name ), NULL );
+	node->line = ( source->line > 65535 ) ? 65535 : (unsigned short)source->line;
+
+	for( Uint32 a = 0; a < source->attributes; a++, nextAttribute++ ) {
+		xmlNewProp( node, BAD_CAST String( attributes[nextAttribute].name ), BAD_CAST String( attributes[nextAttribute].value ) );
+	}
+
+	if( source->text != SNAPSHOT_NO_TEXT ) {
+		xmlAddChild( node, xmlNewDocText( doc, BAD_CAST String( source->text ) ) );
+	}
+	for( Uint32 c = 0; c < source->children; c++ ) {
+		xmlAddChild( node, BuildNode( doc ) );
+	}
+	return node;
+}
+
+/**\brief Where the snapshot of an XML file is kept.
+ * \details The snapshot is written where Filesystem::WritablePath puts it,
+ * not beside the XML file, so "Resources/Definitions/models.xml" is kept in
+ * "Resources_Definitions_models.bin" there.
+ * \return The native path of the snapshot, or "" if there is nowhere to keep it.
+ */
+string SnapshotName( const string& filename ) {
+	string::size_type extension = filename.rfind( ".xml" );
+	if( extension != string::npos && extension + 4 == filename.length() ) {
+		return Filesystem::WritablePath( filename.substr( 0, extension ) + ".bin" );
+	}
+	return Filesystem::WritablePath( filename + ".bin" );
+}
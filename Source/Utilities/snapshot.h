@@ -0,0 +1,100 @@
+/**\file			snapshot.h
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			Binary copies of the Components XML files
+ * \details
+ */
+
+#ifndef __H_SNAPSHOT__
+#define __H_SNAPSHOT__
+
+#include "includes.h"
+#include "Utilities/file.h"
+
+#define SNAPSHOT_MAGIC 0x534E4345  ///< "ECNS" in the first four bytes of the file.
+#define SNAPSHOT_FORMAT 2          ///< Files with any other format are ignored.
+#define SNAPSHOT_NO_TEXT 0xFFFFFFFF ///< The text of an element that has none.
+
+/**\brief The start of a snapshot file.
+ * \details The nodes follow the header, then the attributes, then the offsets
+ * of the strings, then the strings.
+ */
+struct SnapshotHeader {
+	Sint64 modTime;          ///< When the XML file was last changed.
+	Uint32 magic;
+	Uint32 format;
+	Uint32 epiarVersion[3];  ///< The EPIAR_VERSION_MAJOR, _MINOR and _MICRO that wrote it.
+	Uint32 fileVersion[3];   ///< The version-major, version-minor and version-macro of the XML file.
+	Uint32 fileSize;         ///< Bytes in the XML file.
+	Uint32 rootName;         ///< The root element of the XML file.
+	Uint32 componentCount;
+	Uint32 nodeCount;
+	Uint32 stringCount;
+	Uint32 attributeCount;
+};
+
+/**\brief One element.  Its child elements follow it.
+ * \details Names and text are indexes into the strings.
+ */
+struct SnapshotNode {
+	Uint32 name;
+	Uint32 text;     ///< The text before the first child element, or SNAPSHOT_NO_TEXT.
+	Uint32 children; ///< Child elements, not counting their children.
+	Uint32 line;     ///< Where the element was in the XML file.
+	Uint32 attributes; ///< Attributes of this element, which follow those of the elements before it.
+};
+
+/**\brief One attribute of an element.
+ * \details Names and values are indexes into the strings.
+ */
+struct SnapshotAttribute {
+	Uint32 name;
+	Uint32 value;
+};
+
+class SnapshotWriter {
+	public:
+		SnapshotWriter( const string& rootName );
+		void SetFileVersion( int versionMajor, int versionMinor, int versionMicro );
+		void Add( xmlNodePtr node );
+		bool Save( const string& filename, const string& source );
+
+	private:
+		void AddNode( xmlNodePtr node );
+		Uint32 Intern( const char *str );
+
+		SnapshotHeader header;
+		vector<SnapshotNode> nodes;
+		vector<SnapshotAttribute> attributes;
+		vector<string> strings;
+		map<string,Uint32> stringIds;
+};
+
+class SnapshotReader {
+	public:
+		SnapshotReader( void );
+		bool Open( const string& filename, const string& source );
+
+		string GetRootName( void ) { return String( header->rootName ); }
+		int GetComponentCount( void ) { return header->componentCount; }
+		void GetFileVersion( int *major, int *minor, int *micro );
+		xmlNodePtr NextComponent( xmlDocPtr doc );
+
+	private:
+		bool Validate( void );
+		xmlNodePtr BuildNode( xmlDocPtr doc );
+		const char *String( Uint32 id ) { return (const char*)( file.GetData() + offsets[id] ); }
+
+		MappedFile file;
+		const SnapshotHeader *header;
+		const SnapshotNode *nodes;
+		const SnapshotAttribute *attributes;
+		const Uint32 *offsets;
+		Uint32 next; ///< The node that NextComponent will build.
+		Uint32 nextAttribute; ///< The first attribute of that node.
+};
+
+string SnapshotName( const string& filename );
+
+#endif // __H_SNAPSHOT__
@@ -10,6 +10,10 @@
 #include "common.h"
 #include "Utilities/timer.h"
 
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
+
 /**\class Timer
  * \brief Timer class. */
 
@@ -46,6 +50,24 @@ Uint32 Timer::GetTicks( void )
 	return( lastLoopTick );
 }
 
+/**\brief Reads a clock that is much finer than SDL_GetTicks.
+ * \details This is meant for measuring how long code takes to run, so only the
+ * difference between two calls is meaningful.
+ * \return Seconds since an arbitrary point.
+ */
+double Timer::GetRealTime( void ) {
+#ifdef _WIN32
+	LARGE_INTEGER count, frequency;
+	QueryPerformanceCounter( &count );
+	QueryPerformanceFrequency( &frequency );
+	return double(count.QuadPart) / double(frequency.QuadPart);
+#else
+	struct timeval now;
+	gettimeofday( &now, NULL );
+	return double(now.tv_sec) + double(now.tv_usec) * 0.000001;
+#endif
+}
+
 void Timer::Delay( int waitMS ) {
 //#ifdef EPIAR_CAP_FRAME
 //	Uint32 ticksElapsed = SDL_GetTicks() - lastLoopTick;
@@ -70,6 +92,17 @@ Uint32 Timer::GetLogicalFrameCount( void )
 	return logicalFrameCount;
 }
 
+/**\brief Moves the game clock forward without waiting.
+ * \details The benchmark runs logical frames back to back, so it steps the
+ * clock that GetTicks returns instead of reading SDL_GetTicks.
+ * \param ticks Milliseconds to add.
+ */
+void Timer::Advance( Uint32 ticks )
+{
+	lastLoopLength = ticks;
+	lastLoopTick += ticks;
+}
+
 void Timer::IncrementFrameCount ( void )
 {
 			//we don't mind if it wraps - up to whoever's using it to deal with it
@@ -19,6 +19,8 @@ class Timer {
 		static int Update( void );
 		static void Delay( int waitMS );
 		static Uint32 GetTicks( void );
+		static void Advance( Uint32 ticks );
+		static double GetRealTime( void );
 		
 		static float GetDelta( void );
 
@@ -0,0 +1,194 @@
+/**\file			workerpool.cpp
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			A fixed set of threads that run batches of jobs.
+ * \details
+ */
+
+#include "includes.h"
+#include "common.h"
+#include "Utilities/workerpool.h"
+#include "Utilities/log.h"
+
+/**\class WorkerPool
+ * \brief A fixed set of threads that run batches of jobs.
+ *
+ * A batch is a function and a number of jobs.  Each thread takes the next
+ * job index that nobody has started yet, so a few slow jobs don't hold up
+ * the rest.  Run blocks until every job of the batch is finished.  Start
+ * returns at once instead, so that the caller can do something else until it
+ * calls Wait.  Only one batch runs at a time.
+ *
+ * Jobs must not touch anything that other jobs of the same batch may be
+ * using.  Work that can't be split that way should be recorded during the
+ * job and applied by the caller after Run returns.
+ */
+
+/**\brief Start the worker threads.
+ * \param numThreads Number of threads to start.
+ */
+WorkerPool::WorkerPool( int numThreads ) {
+	lock = SDL_CreateMutex();
+	wake = SDL_CreateCond();
+	finished = SDL_CreateCond();
+	job = NULL;
+	data = NULL;
+	numJobs = 0;
+	nextJob = 0;
+	jobsRemaining = 0;
+	quitting = false;
+
+	for( int t = 0; t < numThreads; t++ ) {
+		SDL_Thread *thread = SDL_CreateThread( WorkerThread, this );
+		if( thread == NULL ) {
+			LogMsg(ERR, "Could not start worker thread %d: %s", t, SDL_GetError() );
+			break;
+		}
+		threads.push_back( thread );
+		threadIDs.push_back( SDL_GetThreadID( thread ) );
+	}
+	LogMsg(INFO, "Started %d worker threads.", (int)threads.size() );
+}
+
+/**\brief Stop and wait for all of the worker threads.
+ */
+WorkerPool::~WorkerPool() {
+	SDL_mutexP( lock );
+	quitting = true;
+	SDL_CondBroadcast( wake );
+	SDL_mutexV( lock );
+
+	for( unsigned int t = 0; t < threads.size(); t++ ) {
+		SDL_WaitThread( threads[t], NULL );
+	}
+	threads.clear();
+	threadIDs.clear();
+
+	SDL_DestroyCond( finished );
+	SDL_DestroyCond( wake );
+	SDL_DestroyMutex( lock );
+}
+
+/**\brief Run a batch of jobs on the worker threads.
+ * \param _job Function called once per job.
+ * \param _data Passed to every call of the job.
+ * \param _numJobs The job function is called with every index from 0 to _numJobs-1.
+ * \details
+ * This returns once every job has finished.
+ * If there are no worker threads then the jobs are run on this thread, in order.
+ */
+void WorkerPool::Run( WorkerJob _job, void *_data, int _numJobs ) {
+	Start( _job, _data, _numJobs );
+	Wait();
+}
+
+/**\brief Start a batch of jobs on the worker threads without waiting for it.
+ * \param _job Function called once per job.
+ * \param _data Passed to every call of the job.
+ * \param _numJobs The job function is called with every index from 0 to _numJobs-1.
+ * \details
+ * The previous batch must have finished; call Wait first if it may not have.
+ * If there are no worker threads then the jobs are run on this thread, in order.
+ */
+void WorkerPool::Start( WorkerJob _job, void *_data, int _numJobs ) {
+	if( _numJobs <= 0 ) {
+		return;
+	}
+	if( threads.empty() ) {
+		for( int j = 0; j < _numJobs; j++ ) {
+			_job( _data, j );
+		}
+		return;
+	}
+
+	SDL_mutexP( lock );
+	assert( jobsRemaining == 0 );
+	job = _job;
+	data = _data;
+	numJobs = _numJobs;
+	nextJob = 0;
+	jobsRemaining = _numJobs;
+	SDL_CondBroadcast( wake );
+	SDL_mutexV( lock );
+}
+
+/**\brief Wait until every job of the current batch has finished.
+ * \details This returns at once if no batch is running.
+ */
+void WorkerPool::Wait( void ) {
+	if( threads.empty() ) {
+		return;
+	}
+
+	SDL_mutexP( lock );
+	while( jobsRemaining > 0 ) {
+		SDL_CondWait( finished, lock );
+	}
+	numJobs = 0;
+	nextJob = 0;
+	job = NULL;
+	data = NULL;
+	SDL_mutexV( lock );
+}
+
+/**\brief Whether some jobs of the current batch have not finished yet.
+ */
+bool WorkerPool::IsBusy( void ) {
+	bool busy;
+	if( threads.empty() ) {
+		return false;
+	}
+
+	SDL_mutexP( lock );
+	busy = ( jobsRemaining > 0 );
+	SDL_mutexV( lock );
+	return busy;
+}
+
+/**\brief Which worker thread is calling this.
+ * \return The index of the worker thread, or -1 if this is not a worker thread.
+ */
+int WorkerPool::CurrentWorker( void ) {
+	Uint32 id = SDL_ThreadID();
+	for( unsigned int t = 0; t < threadIDs.size(); t++ ) {
+		if( threadIDs[t] == id ) {
+			return t;
+		}
+	}
+	return -1;
+}
+
+/**\brief Thread entry point (Internal use).
+ */
+int WorkerPool::WorkerThread( void *pool ) {
+	((WorkerPool*)pool)->Work();
+	return 0;
+}
+
+/**\brief Take jobs until the pool shuts down (Internal use).
+ */
+void WorkerPool::Work( void ) {
+	SDL_mutexP( lock );
+	while( true ) {
+		while( !quitting && nextJob >= numJobs ) {
+			SDL_CondWait( wake, lock );
+		}
+		if( quitting ) {
+			break;
+		}
+
+		int current = nextJob++;
+		WorkerJob currentJob = job;
+		void *currentData = data;
+
+		SDL_mutexV( lock );
+		currentJob( currentData, current );
+		SDL_mutexP( lock );
+
+		if( --jobsRemaining == 0 ) {
+			SDL_CondSignal( finished );
+		}
+	}
+	SDL_mutexV( lock );
+}
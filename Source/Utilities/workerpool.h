@@ -0,0 +1,49 @@
+/**\file			workerpool.h
+ * \author			Epiar Development Team
+ * \date			Created: Sunday, October 18, 2026
+ * \date			Modified: Sunday, October 18, 2026
+ * \brief			A fixed set of threads that run batches of jobs.
+ * \details
+ */
+
+#ifndef __h_workerpool__
+#define __h_workerpool__
+
+#include "includes.h"
+
+// A job is called once for every index of a batch.
+typedef void (*WorkerJob)(void *data, int job);
+
+class WorkerPool {
+	public:
+		WorkerPool( int numThreads );
+		~WorkerPool();
+
+		void Run( WorkerJob job, void *data, int numJobs );
+		void Start( WorkerJob job, void *data, int numJobs );
+		void Wait( void );
+		bool IsBusy( void );
+
+		int CurrentWorker( void );
+		int GetNumThreads( void ) { return threads.size(); }
+
+	private:
+		static int WorkerThread( void *pool );
+		void Work( void );
+
+		vector<SDL_Thread*> threads;
+		vector<Uint32> threadIDs;
+
+		SDL_mutex *lock;   ///< Guards everything below.
+		SDL_cond *wake;    ///< Signalled when a batch starts or the pool is shutting down.
+		SDL_cond *finished;///< Signalled when the last job of a batch completes.
+
+		WorkerJob job;
+		void *data;
+		int numJobs;       ///< Number of jobs in the current batch.
+		int nextJob;       ///< The next job that a thread should take.
+		int jobsRemaining; ///< Jobs that have not finished yet.
+		bool quitting;
+};
+
+#endif // __h_workerpool__
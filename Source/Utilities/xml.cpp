@@ -16,12 +16,21 @@
 /**\class XMLFile
  * \brief XML handling. */
 
+/**\brief Counts the changes to every XMLFile.
+ * \details A version is never reused, even by a new XMLFile, so a version that
+ * was read from a file that has since been replaced never matches again.
+ * \see OptionHandle
+ */
+unsigned int XMLFile::changes = 0;
+
 XMLFile::XMLFile() {
 	xmlPtr = NULL;
+	version = ++changes;
 }
 
 XMLFile::XMLFile( const string& filename ) {
 	xmlPtr = NULL;
+	version = ++changes;
 	Open( filename );
 }
 
@@ -33,6 +42,7 @@ bool XMLFile::New( const string& _filename, const string& rootName ) {
 	LogMsg(INFO, "New XML File: %s", filename.c_str());
 
 	xmlPtr = xmlNewDoc( BAD_CAST "1.0" );
+	version = ++changes;
 
 	xmlNodePtr root_node = xmlNewNode(NULL, BAD_CAST rootName.c_str() );
     xmlDocSetRootElement(xmlPtr, root_node);
@@ -47,8 +57,6 @@ bool XMLFile::New( const string& _filename, const string& rootName ) {
 }
 
 bool XMLFile::Open( const string& filename ) {
-	char *buf = NULL;
-	long bufSize = 0;
 	File xmlfile;
 
 	if( xmlfile.OpenRead( filename ) == false ) {
@@ -56,15 +64,12 @@ bool XMLFile::Open( const string& filename ) {
 		return( false );
 	}
 
-	buf = xmlfile.Read();
-	bufSize = xmlfile.GetLength();
-	if( buf == NULL ) {
-		LogMsg(ERR, "Could not load XML from archive. Buffer failed to allocate." );
-		return( NULL );
+	// Parse while reading, rather than keeping a copy of the whole file
+	xmlPtr = xmlReadIO( ReadXMLFromFile, NULL, &xmlfile, filename.c_str(), NULL, 0 );
+	if( xmlPtr == NULL ) {
+		LogMsg(ERR, "Could not parse XML from %s", filename.c_str() );
 	}
-
-	xmlPtr = xmlParseMemory( buf, bufSize );
-	delete [] buf;
+	version = ++changes;
 
 	this->filename.assign( filename );
 
@@ -90,6 +95,8 @@ bool XMLFile::Save( const string& filename ) {
 bool XMLFile::Close() {
 	if( xmlPtr ) xmlFreeDoc( xmlPtr );
 	xmlPtr = NULL;
+	values.clear(); // The memoized nodes were freed with the document
+	version = ++changes;
 
 	return( true );
 }
@@ -110,6 +117,7 @@ void XMLFile::Set( const string& path, const string& value ) {
 	LogMsg(INFO,"Overriding Option['%s'] from '%s' to '%s'",path.c_str(),Get(path).c_str(),value.c_str());
 	xmlNodePtr p =  FindNode(path,true);
 	xmlNodeSetContent(p, BAD_CAST value.c_str() );
+	version = ++changes;
 	LogMsg(INFO,"Done Overriding Option['%s'] to '%s'",path.c_str(),Get(path).c_str());
 	assert( value == Get(path));
 }
@@ -122,6 +130,7 @@ void XMLFile::Set( const string& path, const float value ) {
 	val_ss >> stringvalue;
 	LogMsg(INFO,"Overriding Option['%s'] from '%s' to '%s'",path.c_str(),Get(path).c_str(),stringvalue.c_str());
 	xmlNodeSetContent(FindNode(path,true), BAD_CAST stringvalue.c_str() );
+	version = ++changes;
 	assert( stringvalue == Get(path));
 }
 
@@ -134,6 +143,7 @@ void XMLFile::Set( const string& path, const int value ) {
 	LogMsg(INFO,"Overriding Option['%s'] from '%s' to '%s'",path.c_str(),Get(path).c_str(),stringvalue.c_str());
 	xmlNodePtr p =  FindNode(path,true);
 	xmlNodeSetContent(p, BAD_CAST stringvalue.c_str() );
+	version = ++changes;
 	assert( stringvalue == Get(path));
 }
 
@@ -211,6 +221,20 @@ xmlNodePtr XMLFile::FindNode( const string& path, bool createIfMissing ) {
 	return( cur );
 }
 
+/**\brief Reads the next part of an XML file for libxml2.
+ * \details Pass this to xmlReadIO or xmlReaderForIO with an open File as the
+ *          context, so that the file is parsed while it is read rather than
+ *          being read into memory first.
+ * \param file The File, which stays open.
+ * \param buffer Where the bytes go.
+ * \param len The most bytes that libxml2 wants.
+ * \return The number of bytes read, 0 at the end, or -1 on an error.
+ */
+int ReadXMLFromFile( void *file, char *buffer, int len )
+{
+	return static_cast<int>( static_cast<File*>(file)->ReadUpTo( len, buffer ) );
+}
+
 /**\brief Find the first child node that matches a specific name
  * \param node The parent node that we are searching.
  * \param text The text name that we are searching for.
@@ -29,6 +29,7 @@ class XMLFile {
 		void Set( const string& path, const string& value ); // cast/convert this to whatever return value you need
 		void Set( const string& path, const float value ); // cast/convert this to whatever return value you need
 		void Set( const string& path, const int value ); // cast/convert this to whatever return value you need
+		unsigned int GetVersion( void ) { return version; } // changes whenever any value may have changed
 
 	protected:
 		string filename;
@@ -36,11 +37,14 @@ class XMLFile {
 	private:
 		xmlDocPtr xmlPtr;
 		map<string,xmlNodePtr> values;
+		unsigned int version;
+		static unsigned int changes; ///< The last version given to any XMLFile.
 
 		xmlNodePtr FindNode( const string& path, bool createIfMissing=false );
 };
 
 vector<string> TokenizedString(const string& path, const string& tokens);
+int ReadXMLFromFile( void *file, char *buffer, int len );
 
 #define PPA_MATCHES( text ) if( !strcmp( subName.c_str(), text ) )
 #define NodeNameIs( node, text ) ( !xmlStrcmp( ((node)->name), (const xmlChar *)(text) ) )
@@ -29,4 +29,31 @@ extern XMLFile *skinfile;
 
 #define SKIN(path) (skinfile->Get(path) )
 
+/**\brief A typed handle to one option that is parsed only when the options change.
+ * \details OPTION() walks the XML and parses a string on every call.  Code that
+ *  reads an option every frame should keep an OptionHandle instead; it only
+ *  converts the value again after SETOPTION (or Lua's setoption) changes the
+ *  version of the options file, or after optionsfile is replaced.
+ *
+ *  Like OPTION(), a handle may only be used on the main thread.  Neither the
+ *  refresh nor the XMLFile behind it is synchronized, so code that runs on
+ *  worker threads must be handed the values it needs instead.
+ */
+template<typename T> class OptionHandle {
+	public:
+		OptionHandle( const string& _path ) : path(_path), version(0), value() {}
+		T Get() {
+			if( version != optionsfile->GetVersion() ) {
+				value = OPTION(T, path);
+				version = optionsfile->GetVersion();
+			}
+			return value;
+		}
+
+	private:
+		string path;
+		unsigned int version; ///< The options version that value was read from, 0 before the first read.
+		T value;
+};
+
 #endif // __H_COMMON__
@@ -47,6 +47,7 @@
 #include "SDL_mixer.h"
 #include <libxml/xmlmemory.h>
 #include <libxml/parser.h>
+#include <libxml/xmlreader.h>
 #include <zlib.h>
 
 #if __APPLE__
@@ -15,9 +15,11 @@
 #include "Tests/graphics.h"
 #include "Engine/simulation.h"
 #include "Graphics/font.h"
+#include "Graphics/imagecache.h"
 #include "Graphics/video.h"
 #include "UI/ui.h"
 #include "Utilities/argparser.h"
+#include "Utilities/assetloader.h"
 #include "Utilities/filesystem.h"
 #include "Utilities/log.h"
 #include "Utilities/lua.h"
@@ -35,11 +37,17 @@ XMLFile *skinfile = NULL;
 Font *SansSerif = NULL, *BitType = NULL, *Serif = NULL, *Mono = NULL;
 ArgParser *argparser;
 
+// Benchmark settings from the command line
+string benchSimulation = "";
+int benchShips = 100;
+int benchFrames = 1000;
+
 void Main_OS                ( int argc, char **argv ); ///< Run OS Specific setup code
 void Main_Init_Singletons   ( int argc, char **argv ); ///< Initialize global Singletons
 void Main_Parse_Args        ( ); ///< Parse Command Line Arguments
 void Main_Log_Environment   ( void ); ///< Record Environment variables
 void Main_Menu              ( void ); ///< Run the Main Menu
+int  Main_Benchmark         ( void ); ///< Run the Simulation Benchmark
 void Main_Close_Singletons  ( void ); ///< Close global Singletons
 
 /**Main
@@ -60,6 +68,13 @@ int main( int argc, char **argv ) {
 	Main_Parse_Args();
 	Main_Log_Environment();
 
+	// Benchmarks replace the game
+	if( !benchSimulation.empty() ) {
+		int result = Main_Benchmark();
+		Main_Close_Singletons();
+		return( result );
+	}
+
 	// THE GAME
 	Main_Menu();
 
@@ -152,6 +167,8 @@ void Main_Init_Singletons( int argc, char **argv ) {
 	Timer::Initialize();
 	Video::Initialize();
 	UI::Initialize();
+	ImageCache::Open( Filesystem::WritablePath( OPTION(string, "options/video/image-cache") ) );
+	AssetLoader::Init( OPTION(int, "options/simulation/asset-threads") );
 
 	// Parse command line options first.
 	argparser = new ArgParser(argc, argv);
@@ -171,6 +188,9 @@ void Main_Init_Singletons( int argc, char **argv ) {
 	argparser->SetOpt(VALUEOPT, "log-fun",       "Filter log messages by function name.");
 	argparser->SetOpt(VALUEOPT, "log-msg",       "Filter log messages by string content.");
 	argparser->SetOpt(LONGOPT,  "ui-demo",       "Runs the UI demo.");
+	argparser->SetOpt(VALUEOPT, "bench-sim",     "Benchmark the Simulation in this folder without drawing it.");
+	argparser->SetOpt(VALUEOPT, "bench-ships",   "Number of AI Ships to benchmark with (Default 100).");
+	argparser->SetOpt(VALUEOPT, "bench-frames",  "Number of logical frames to benchmark (Default 1000).");
 
 #ifdef EPIAR_COMPILE_TESTS
 	argparser->SetOpt(VALUEOPT, "run-test",      "Run specified test");
@@ -185,6 +205,8 @@ void Main_Init_Singletons( int argc, char **argv ) {
  *  \warn Do not run any non-trivial code after calling this.
  */
 void Main_Close_Singletons( void ) {
+	AssetLoader::Close();
+	ImageCache::Close();
 	Video::Shutdown();
 	Audio::Instance().Shutdown();
 
@@ -259,6 +281,12 @@ void Main_Parse_Args( ) {
 
 	argparser->HaveLong("ui-demo");
 
+	benchSimulation = argparser->HaveValue("bench-sim");
+	string ships = argparser->HaveValue("bench-ships");
+	string frames = argparser->HaveValue("bench-frames");
+	if("" != ships)  benchShips = convertTo<int>( ships );
+	if("" != frames) benchFrames = convertTo<int>( frames );
+
 	// Print unused options.
 	list<string> unused = argparser->GetUnused();
 	list<string>::iterator it;
@@ -272,6 +300,9 @@ void Main_Parse_Args( ) {
 
 		exit( 1 );
 	}
+
+	// Now that the log options are final, move writing off the game thread.
+	Log::Instance().Start();
 }
 
 /** \details
@@ -291,6 +322,24 @@ void Main_Log_Environment( void ) {
 	LogMsg(INFO,"Executable Path: %s", argparser->GetPath().c_str() );
 }
 
+/** \details
+ *  Loads the Simulation named by --bench-sim and runs it as fast as possible.
+ *  The results are printed to stdout.
+ *  \return 0 on success, 1 if the Simulation could not be run.
+ *  \see Simulation::Benchmark
+ */
+int Main_Benchmark( void ) {
+	Simulation benchmark;
+	if( !benchmark.Load( benchSimulation ) ) {
+		LogMsg(ERR, "Could not load the Simulation '%s' to benchmark.", benchSimulation.c_str() );
+		return( 1 );
+	}
+	if( !benchmark.Benchmark( benchShips, benchFrames ) ) {
+		return( 1 );
+	}
+	return( 0 );
+}
+
 typedef enum {
 	Menu_DoNothing  = 0x0,
 	Menu_Play       = 0x1,
@@ -389,6 +438,7 @@ void Main_Menu( void ) {
 
 	screenNum = rand() % (sizeof(splashScreens) / sizeof(splashScreens[0]));
 	Image* splash = Image::Get( splashScreens[screenNum] );
+	Image* logo = Image::Get( "Resources/Art/logo.png" );
 
 	string simName = "Resources/Simulation/default";
 	Simulation debug;
@@ -426,7 +476,7 @@ void Main_Menu( void ) {
 		Video::Erase();
 		splash->DrawStretch(0,0,OPTION( int, "options/video/w" ),OPTION( int, "options/video/h"));
 		// Draw the "logo"
-		Image::Get("Resources/Art/logo.png")->Draw(Video::GetWidth() - 240, Video::GetHeight() - 120 );
+		logo->Draw(Video::GetWidth() - 240, Video::GetHeight() - 120 );
 		UI::Draw();
 		Video::Update();
 
@@ -440,7 +490,7 @@ void Main_Menu( void ) {
 
 				Video::Erase();
 				splash->DrawStretch(0,0,OPTION( int, "options/video/w" ),OPTION( int, "options/video/h"));
-				Image::Get("Resources/Art/logo.png")->Draw(Video::GetWidth() - 240, Video::GetHeight() - 120 );
+				logo->Draw(Video::GetWidth() - 240, Video::GetHeight() - 120 );
 				Video::Update();
 
 				if( false == debug.isLoaded() )